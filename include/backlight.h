@@ -23,9 +23,14 @@
 #define __BACKLIGHT_H
 
 #include <stdint.h>
+#include <stdbool.h>
 
 typedef unsigned char u8;
 typedef unsigned short u16;
+typedef unsigned int u32;
+
+/* called from the DMA interrupt when a fade reached its level */
+typedef void (*backlight_fade_done_t)(void *arg);
 
 void backlight_driver_init(void);
 void backlight_set_level(u8 level);
@@ -34,4 +39,18 @@ u8 backlight_get_level(void);
 u8 backlight_get_offset(void);
 void backlight_set_offset(u8 offset);
 
+/*
+ * Gamma corrected fade from the current level, run by DMA. A new fade
+ * or backlight_set_level() stops the one in progress, its done is then
+ * not called.
+ */
+int backlight_fade_to(u8 level, u32 duration_ms, backlight_fade_done_t done, void *arg);
+void backlight_fade_stop(void);
+/* scale the user level by pct, -1 while another fade runs */
+int backlight_set_adaptive(u8 pct, u32 fade_ms);
+bool backlight_fade_busy(void);
+
+/* off while the panel sleeps, level changes meanwhile apply on unblank */
+void backlight_set_blank(bool blank);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,47 @@
+// Copyright (c) 2024 embeddedboys developers
+
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef __BOOT_TIME_H
+#define __BOOT_TIME_H
+
+#include <stdint.h>
+
+#define BOOT_TIME_MAX_STAGES    24
+
+#if BOOT_TIME_ENABLED
+/* the end of a boot stage, name must be a string literal */
+extern void boot_mark(const char *name);
+/* flush task, a whole frame reached the panel */
+extern void boot_time_frame(void);
+/* LVGL task, prints the timeline once after the first frame */
+extern void boot_time_report(void);
+extern void boot_time_dump(void);
+extern void boot_time_init(void);
+#else
+static inline void boot_mark(const char *name) {}
+static inline void boot_time_frame(void) {}
+static inline void boot_time_report(void) {}
+static inline void boot_time_dump(void) {}
+static inline void boot_time_init(void) {}
+#endif
+
+#endif
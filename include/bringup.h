@@ -0,0 +1,74 @@
+// Copyright (c) 2024 embeddedboys developers
+
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef __BRINGUP_H
+#define __BRINGUP_H
+
+#include <stdint.h>
+
+#include "pico/stdlib.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+/*
+ * Boot stages. Each one is run by the long lived task that owns the
+ * hardware afterwards, so stages on different tasks overlap.
+ */
+enum bringup_stage {
+    BRINGUP_PANEL,      /* flush task, core 1 */
+    BRINGUP_BACKLIGHT,  /* flush task, core 1 */
+    BRINGUP_TOUCH,      /* touch task, core 1 */
+    BRINGUP_LVGL,       /* LVGL task, core 0 */
+    BRINGUP_UI,         /* LVGL task, core 0 */
+    BRINGUP_NR_STAGES,
+};
+
+#define BRINGUP_BIT(s)  (1u << (s))
+#define BRINGUP_ALL     (BRINGUP_BIT(BRINGUP_NR_STAGES) - 1)
+
+/* returns 0 or a negative error, the stage counts as done either way */
+typedef int (*bringup_fn_t)(void);
+
+extern void bringup_init(void);
+/* before the scheduler, deps is a mask of BRINGUP_BIT()s run first */
+extern void bringup_register(enum bringup_stage stage, const char *name,
+                             bringup_fn_t fn, uint32_t deps);
+/* from the owning task, waits for deps then runs the stage once */
+extern int bringup_run(enum bringup_stage stage);
+/* blocks until every stage in mask is done, -1 if any of them failed */
+extern int bringup_wait(uint32_t mask);
+
+/*
+ * Driver init sequences use this for their reset and power-up delays:
+ * they sleep once the scheduler runs, so the delays of stages brought up
+ * in parallel overlap instead of adding up.
+ */
+static inline void bringup_delay_ms(uint32_t ms)
+{
+    if (xTaskGetSchedulerState() == taskSCHEDULER_RUNNING)
+        vTaskDelay(pdMS_TO_TICKS(ms) + 1);  /* at least ms, whatever the tick phase */
+    else
+        busy_wait_ms(ms);
+}
+
+#endif
@@ -0,0 +1,55 @@
+// Copyright (c) 2024 embeddedboys developers
+
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef __CABC_H
+#define __CABC_H
+
+#include <stdint.h>
+
+/* luma grid pitch in pixels, one sample per CABC_STRIDE x CABC_STRIDE */
+#define CABC_STRIDE         8
+/* how often the backlight scale is re-evaluated */
+#define CABC_PERIOD_MS      250
+/* never dim below this percent of the user level */
+#define CABC_MIN_PCT        30
+#define CABC_HIST_BINS      16
+
+struct cabc_stats {
+    uint32_t hist[CABC_HIST_BINS];  /* luma of the whole screen, last evaluation */
+    uint8_t p98;                    /* 98th percentile luma, 0..255 */
+    uint8_t level;                  /* backlight scale in percent */
+    uint32_t cost_us;               /* accounting time per flush, last and worst */
+    uint32_t cost_max_us;
+    uint32_t evaluations;
+};
+
+#if CABC_ENABLED
+extern void cabc_init(void);
+/* flush task, before the area is sent to the panel */
+extern void cabc_account(int xs, int ys, int xe, int ye, void *vmem);
+extern void cabc_get_stats(struct cabc_stats *stats);
+#else
+static inline void cabc_init(void) {}
+static inline void cabc_account(int xs, int ys, int xe, int ye, void *vmem) {}
+#endif
+
+#endif
@@ -0,0 +1,57 @@
+// Copyright (c) 2024 embeddedboys developers
+
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef __DECODE_CACHE_H
+#define __DECODE_CACHE_H
+
+#include <stdint.h>
+
+#include "lvgl/lvgl.h"
+
+/* max entries (decoded images + glyphs) tracked by the cache */
+#define DECODE_CACHE_MAX_ENTRIES 96
+/* max fonts that can be wrapped by decode_cache_font() */
+#define DECODE_CACHE_MAX_FONTS   4
+
+struct decode_cache_stats {
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t evictions;
+    uint32_t insert_fails;  /* entry bigger than budget or heap full */
+
+    uint32_t used;          /* bytes currently held */
+    uint32_t peak;          /* high-water mark of used */
+    uint32_t budget;        /* LV_DECODE_CACHE_SIZE */
+    uint32_t entries;
+};
+
+extern int decode_cache_init(void);
+/*
+ * Glyph caching is opt-in per font: only text drawn with the returned
+ * wrapper goes through the cache. The LVGL demos pick their own fonts and
+ * are not wrapped.
+ */
+extern const lv_font_t *decode_cache_font(const lv_font_t *font);
+extern void decode_cache_flush(void);
+extern void decode_cache_get_stats(struct decode_cache_stats *stats);
+extern void decode_cache_dump(void);
+
+#endif
@@ -0,0 +1,74 @@
+// Copyright (c) 2024 embeddedboys developers
+
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef __DISP_POWER_H
+#define __DISP_POWER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* deeper states have higher values */
+enum disp_power_state {
+    DISP_POWER_ACTIVE,
+    DISP_POWER_IDLE,        /* idle colour mode, 8 colours */
+    DISP_POWER_PARTIAL,     /* idle colour and only the partial rows shown */
+    DISP_POWER_SLEEP,       /* backlight off, sleep in or display off */
+    DISP_POWER_NR_STATES,
+};
+
+struct disp_power_cfg {
+    /* UI inactivity before entering the state, 0 skips it */
+    uint32_t timeout_ms[DISP_POWER_NR_STATES];
+    /* rows kept visible in partial mode, partial is skipped while ys > ye */
+    int16_t partial_ys;
+    int16_t partial_ye;
+    /* wake to first visible frame; over it, sleep in is replaced by display off */
+    uint32_t wake_target_ms;
+};
+
+struct disp_power_stats {
+    uint32_t entered[DISP_POWER_NR_STATES];
+    uint32_t wake_last_us[DISP_POWER_NR_STATES];    /* by the state woken from */
+    uint32_t wake_max_us[DISP_POWER_NR_STATES];
+    uint32_t over_target;
+};
+
+#if DISP_POWER_ENABLED
+/* after lv_port_disp_init() */
+extern void disp_power_init(void);
+/* LVGL task; true if the panel was not (fully) visible, i.e. swallow the touch */
+extern bool disp_power_wake(void);
+/* flush task, a whole frame reached the panel */
+extern void disp_power_frame_flushed(void);
+extern enum disp_power_state disp_power_get_state(void);
+/* LVGL task */
+extern void disp_power_set_cfg(const struct disp_power_cfg *cfg);
+extern void disp_power_get_cfg(struct disp_power_cfg *cfg);
+extern void disp_power_get_stats(struct disp_power_stats *stats);
+#else
+static inline void disp_power_init(void) {}
+static inline bool disp_power_wake(void) { return false; }
+static inline void disp_power_frame_flushed(void) {}
+static inline enum disp_power_state disp_power_get_state(void) { return DISP_POWER_ACTIVE; }
+#endif
+
+#endif
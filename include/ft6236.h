@@ -32,6 +32,8 @@
 #define FT6236_PIN_SCL  27
 #define FT6236_PIN_SDA  26
 #define FT6236_PIN_RST  18
+/* INT, set to INDEV_PIN_NONE on boards without it and the touch task polls */
+#define FT6236_PIN_IRQ  21
 
 #define CT_MAX_TOUCH  5
 
@@ -39,11 +41,13 @@
 #define FT_REG_GEST_ID 			0x01    // Gesture ID
 #define FT_REG_TD_STATUS 		0x02    // Touch point status
 
-/* TODO: currently support 1 touch point */
 #define FT_REG_TOUCH1_XH 		0x03    // Touch point 1 X high 8-bit
 #define FT_REG_TOUCH1_XL 		0x04    // Touch point 1 X low 8-bit
 #define FT_REG_TOUCH1_YH 		0x05    // Touch point 1 Y high 8-bit
 #define FT_REG_TOUCH1_YL 		0x06    // Touch point 1 Y low 8-bit
+#define FT_REG_TOUCH1_WEIGHT 	0x07    // Touch point 1 weight
+#define FT_REG_TOUCH1_MISC 		0x08    // Touch point 1 area
+#define FT_REG_TOUCH2_XH 		0x09    // Touch point 2, same layout as point 1
 
 #define FT_REG_TH_GROUP			0x80
 #define FT_REG_PERIODACTIVE	    0x88
@@ -56,4 +60,8 @@
 #define FT_REG_RELEASE_CODE_ID  0xAF
 #define FT_REG_STATE            0xBC
 
+/* FT_REG_G_MODE, trigger mode pulses INT once per new report */
+#define FT_G_MODE_POLLING       0x00
+#define FT_G_MODE_TRIGGER       0x01
+
 #endif
\ No newline at end of file
@@ -0,0 +1,90 @@
+// Copyright (c) 2024 embeddedboys developers
+
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef __I2C_BUS_H
+#define __I2C_BUS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "hardware/i2c.h"
+
+/* task notification slot the synchronous calls block on */
+#define I2C_BUS_NOTIFY_INDEX    1
+/* bytes per transaction, write and read part together */
+#define I2C_BUS_MAX_LEN         64
+/* transactions waiting for the bus, per controller */
+#define I2C_BUS_QUEUE_LEN       4
+#define I2C_BUS_TIMEOUT_MS      20
+
+struct i2c_xfer;
+
+/* runs in interrupt context, status is the byte count or a PICO_ERROR_* */
+typedef void (*i2c_xfer_done_t)(struct i2c_xfer *xfer, int status);
+
+/*
+ * One bus transaction: tx_len bytes written, then (after a repeated start)
+ * rx_len bytes read, then STOP. Either part may be empty.
+ */
+struct i2c_xfer {
+    i2c_inst_t      *i2c;
+    uint8_t         addr;
+    const uint8_t   *tx;
+    size_t          tx_len;
+    uint8_t         *rx;
+    size_t          rx_len;
+
+    i2c_xfer_done_t done;
+    void            *arg;
+};
+
+struct i2c_bus_stats {
+    uint32_t xfers;
+    uint32_t bytes;
+    uint32_t nacks;
+    uint32_t timeouts;
+    uint32_t blocking;  /* went through the polled SDK path */
+    uint32_t busy_us;   /* bus time of completed DMA transactions */
+};
+
+/* after i2c_init(), called by indev_probe() for I2C touch controllers */
+extern int i2c_bus_init(i2c_inst_t *i2c);
+
+/* queue a transaction, done() is called from the I2C interrupt */
+extern int i2c_bus_submit(struct i2c_xfer *xfer);
+
+/*
+ * Blocking helpers with the i2c_*_blocking() return convention. The
+ * calling task sleeps while DMA moves the data. Before the scheduler runs
+ * or on an unregistered controller they fall back to the polled SDK calls.
+ * Not for interrupt context, use i2c_bus_submit() there.
+ */
+extern int i2c_bus_write(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len);
+extern int i2c_bus_read(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len);
+extern int i2c_bus_write_read(i2c_inst_t *i2c, uint8_t addr,
+                              const uint8_t *src, size_t tx_len,
+                              uint8_t *dst, size_t rx_len);
+
+extern void i2c_bus_get_stats(i2c_inst_t *i2c, struct i2c_bus_stats *stats);
+
+#endif
@@ -25,14 +25,22 @@
 #include <stdlib.h>
 #include "pico/stdlib.h"
 #include "hardware/i2c.h"
-// #include "hardware/spi.h"
+#include "hardware/spi.h"
+
+#include "bringup.h"
+
+#include "indev_calib.h"
+#include "indev_filter.h"
+
+/* for indev_spec pins that are not wired */
+#define INDEV_PIN_NONE  0xFF
 
 #define TOUCH_X_RES LCD_HOR_RES
 #define TOUCH_Y_RES LCD_VER_RES
 
 #define ARRAY_SIZE(arr) (sizeof(arr)/sizeof(arr[0]))
 #define udelay(v)   busy_wait_us(v)
-#define mdelay(v)   busy_wait_ms(v)
+#define mdelay(v)   bringup_delay_ms(v)
 #define dm_gpio_set_value(p,v) gpio_put(p, v)
 
 #define write_reg(priv, reg, val) \
@@ -63,6 +71,33 @@ typedef enum {
     INDEV_DIR_SWITCH_XY = 0x04,
 } indev_direction_t;
 
+/* max simultaneous touch points kept in a frame */
+#define INDEV_MAX_POINTS    5
+
+struct indev_point {
+    u8  id;     /* track id, stable while the finger stays down */
+    u16 x;
+    u16 y;
+    u16 size;
+};
+
+/* read_frame: no new report yet, the previous frame still holds */
+#define INDEV_FRAME_NONE    1
+
+/* one multi-touch report, raw from the driver, calibrated by indev_read_frame() */
+struct indev_frame {
+    u8 nr;
+    struct indev_point pt[INDEV_MAX_POINTS];
+};
+
+/* conversions of resistive touch controllers */
+enum {
+    INDEV_ADC_X,
+    INDEV_ADC_Y,
+    INDEV_ADC_Z1,
+    INDEV_ADC_Z2,
+};
+
 struct indev_priv;
 
 struct indev_ops {
@@ -73,14 +108,35 @@ struct indev_ops {
     void    (*write_reg16)(struct indev_priv *priv, u16 reg, u8 val);
     u8      (*read_reg16)(struct indev_priv *priv, u16 reg);
     void    (*write_addr16)(struct indev_priv *priv, u16 reg, u8 *txbuf, u8 len);
-    void    (*read_addr16)(struct indev_priv *priv, u16 reg, u8 *rxbuf, u8 len);
+    int     (*read_addr16)(struct indev_priv *priv, u16 reg, u8 *rxbuf, u8 len);
 
     void    (*init)(struct indev_priv *priv);
     void    (*reset)(struct indev_priv *priv);
     void    (*set_dir)(struct indev_priv *priv, indev_direction_t dir);
     bool    (*is_pressed)(struct indev_priv *priv);
+    /* raw controller coordinates, the calibration matrix does the rest */
     u16     (*read_x)(struct indev_priv *priv);
     u16     (*read_y)(struct indev_priv *priv);
+
+    /*
+     * optional, whole multi-touch report in one go. 0 on a new report,
+     * INDEV_FRAME_NONE while there is nothing new, < 0 on a bus error.
+     */
+    int     (*read_frame)(struct indev_priv *priv, struct indev_frame *frame);
+
+    /*
+     * optional, one 12-bit conversion. Drivers providing it get the
+     * shared resistive pipeline (median, pressure check, one-euro) and
+     * is_pressed only needs to report the pen-down signal.
+     */
+    u16     (*read_adc)(struct indev_priv *priv, u8 channel);
+
+    /*
+     * optional, n X and n Y conversions then Z1 and Z2 in one transfer,
+     * used by the resistive pipeline instead of read_adc. < 0 on error.
+     */
+    int     (*read_adc_burst)(struct indev_priv *priv, u16 *xs, u16 *ys, int n,
+                              u16 *z1, u16 *z2);
 };
 
 struct indev_spec {
@@ -89,6 +145,7 @@ struct indev_spec {
 
     struct {
         u8     addr;
+        u8     addr_alt;    /* strap dependent second address, 0 if none */
         i2c_inst_t  *master;
         u32    speed;
 
@@ -97,6 +154,7 @@ struct indev_spec {
     } i2c;
 
     struct {
+        spi_inst_t  *master;
         u32    speed;
 
         u8     pin_mosi;
@@ -105,6 +163,7 @@ struct indev_spec {
         u8     pin_sck;
     } spi;
 
+    /* usable raw span and its start, for the default calibration */
     u16            x_res;
     u16            y_res;
     int            x_offs;
@@ -112,33 +171,55 @@ struct indev_spec {
 
     /* for res-touch like */
     u8             resolution;
+    const struct indev_filter_cfg *filter;  /* NULL: INDEV_FILTER_CFG_DEFAULT */
 
     u8             pin_irq;
     u8             pin_rst;
 
+    /*
+     * Runtime detection, before ops.init: true if the chip answering at
+     * addr (0 for SPI) is this controller, see indev_detect.c
+     */
+    bool           (*detect)(struct indev_spec *spec, u8 addr);
+
     struct indev_ops ops;
 };
 
 struct indev_priv {
-    u16                 x_res;    /* physical touch resolution */
+    u16                 x_res;    /* screen resolution */
     u16                 y_res;
-    float               sc_x;     /* scaling constant for x_res */
-    float               sc_y;     /* scaling constant for y_res */
 
     indev_direction_t   dir;
-    bool                invert_x;
-    bool                invert_y;
-    bool                switch_xy;
+    struct indev_calib  calib;
+    bool                calib_user;  /* set by indev_set_calib(), dir no longer applies */
+
+    u16                 raw_x;    /* last raw sample, for the calibration wizard */
+    u16                 raw_y;
+
+    struct indev_filter filter;   /* resistive drivers only */
+    u16                 cur_x;    /* filtered sample taken by is_pressed */
+    u16                 cur_y;
 
     struct indev_spec   *spec;
     struct indev_ops    *ops;
 };
 
+/* detects the controller on the bus and probes its driver */
 extern int indev_driver_init(void);
+extern struct indev_spec *indev_detect(void);
+/* bounded-time transfer for spec->detect(), < 0 on NACK or timeout */
+extern int indev_detect_xfer(struct indev_spec *spec, u8 addr, const u8 *tx, size_t tx_len,
+                             u8 *rx, size_t rx_len);
 extern int indev_probe(struct indev_spec *spec);
 extern void indev_set_dir(indev_direction_t dir);
 extern bool indev_is_pressed(void);
-extern u16 indev_read_x(void);
-extern u16 indev_read_y(void);
+extern void indev_read_point(u16 *x, u16 *y);
+extern void indev_get_raw(u16 *x, u16 *y);
+extern void indev_set_calib(const struct indev_calib *cal);
+extern void indev_get_calib(struct indev_calib *cal);
+extern void indev_reset_calib(void);
+extern int indev_get_irq_pin(void);
+extern bool indev_has_frame(void);
+extern int indev_read_frame(struct indev_frame *frame);
 
 #endif
\ No newline at end of file
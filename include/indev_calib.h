@@ -0,0 +1,100 @@
+// Copyright (c) 2024 embeddedboys developers
+
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef __INDEV_CALIB_H
+#define __INDEV_CALIB_H
+
+/* Pure C, no SDK headers, so the math also builds on a host */
+#include <stdint.h>
+#include <stdbool.h>
+
+#define INDEV_CALIB_SHIFT   16
+#define INDEV_CALIB_ONE     (1 << INDEV_CALIB_SHIFT)
+
+/*
+ * Raw controller coordinates to screen pixels, Q16:
+ *
+ *   x' = (a * x + b * y + c) >> 16
+ *   y' = (d * x + e * y + f) >> 16
+ *
+ * Rotation, axis swap, inversion, scale and offset all fold into it.
+ */
+struct indev_calib {
+    int32_t a, b, c;
+    int32_t d, e, f;
+};
+
+struct indev_calib_point {
+    int32_t raw_x;
+    int32_t raw_y;
+    int32_t scr_x;
+    int32_t scr_y;
+};
+
+/* what the per-driver axis setup used to compute, for one output axis */
+struct indev_calib_axis {
+    bool     from_y;    /* fed by the raw y channel */
+    bool     invert;
+    uint16_t res;       /* screen pixels on this axis */
+    uint16_t touch_res; /* usable raw span, 0 if raw is already in pixels */
+    uint8_t  bits;      /* ADC resolution, 0 if raw is already in pixels */
+    int32_t  offs;
+};
+
+extern void indev_calib_identity(struct indev_calib *cal);
+extern void indev_calib_from_axes(struct indev_calib *cal,
+                                  const struct indev_calib_axis *x,
+                                  const struct indev_calib_axis *y);
+
+/*
+ * Fit the matrix to n >= 3 reference points, least squares for n > 3.
+ * Returns -1 when the points are (nearly) collinear.
+ */
+extern int indev_calib_solve(struct indev_calib *cal,
+                             const struct indev_calib_point *pts, int n);
+
+/* largest distance in pixels between a mapped raw point and its target */
+extern int32_t indev_calib_max_error(const struct indev_calib *cal,
+                                     const struct indev_calib_point *pts, int n);
+
+static inline int32_t indev_calib_clamp(int64_t v, uint16_t res)
+{
+    v = (v + (INDEV_CALIB_ONE >> 1)) >> INDEV_CALIB_SHIFT;
+    if (v < 0)
+        return 0;
+    if (v >= res)
+        return res - 1;
+    return (int32_t)v;
+}
+
+/* the per-sample path, two multiply-adds per axis */
+static inline void indev_calib_apply(const struct indev_calib *cal,
+                                     uint16_t *x, uint16_t *y,
+                                     uint16_t x_res, uint16_t y_res)
+{
+    int64_t rx = *x, ry = *y;
+
+    *x = indev_calib_clamp(cal->a * rx + cal->b * ry + cal->c, x_res);
+    *y = indev_calib_clamp(cal->d * rx + cal->e * ry + cal->f, y_res);
+}
+
+#endif
@@ -0,0 +1,46 @@
+// Copyright (c) 2024 embeddedboys developers
+
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef __INDEV_CALIB_UI_H
+#define __INDEV_CALIB_UI_H
+
+/* raw samples averaged per target, after the first few are dropped */
+#define INDEV_CALIB_UI_SAMPLES      8
+#define INDEV_CALIB_UI_SKIP         3
+/* a 5 point fit further off than this at any target is retried */
+#define INDEV_CALIB_UI_MAX_ERR      8
+
+/* result is 0 on success, -1 when the wizard was left without a fit */
+typedef void (*indev_calib_ui_done_t)(int result);
+
+/*
+ * Full screen wizard, touch 3 or 5 crosshairs. Call from the LVGL task,
+ * the previous screen comes back when it is done.
+ */
+extern int indev_calib_ui_start(int nr_points, indev_calib_ui_done_t done);
+
+/* applies the matrix saved by the wizard, after indev_driver_init() */
+extern void indev_calib_ui_load(void);
+/* registers the "calib" console command */
+extern void indev_calib_ui_init(void);
+
+#endif
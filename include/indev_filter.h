@@ -0,0 +1,89 @@
+// Copyright (c) 2024 embeddedboys developers
+
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef __INDEV_FILTER_H
+#define __INDEV_FILTER_H
+
+/* Pure C like indev_calib.h, the filters also build on a host */
+#include <stdint.h>
+#include <stdbool.h>
+
+#define INDEV_FILTER_MAX_N  9
+
+/*
+ * Resistive touch filtering, shared by the TSC2007 style controllers.
+ * Times are in us, frequencies in mHz.
+ */
+struct indev_filter_cfg {
+    uint8_t  median_n;      /* X/Y conversions per sample, odd, <= INDEV_FILTER_MAX_N */
+
+    /* pressure check, rt = x_plate * x / 4096 * (z2 / z1 - 1) */
+    uint16_t z1_min;        /* lighter presses are ignored */
+    uint16_t x_plate_ohms;
+    uint16_t rt_max_ohms;   /* 0: no touch resistance check */
+
+    /*
+     * One-euro filter on the calibrated position, cutoff rises with speed:
+     * fc = min_cutoff + beta * |speed in px/s|. beta 0 leaves a plain
+     * first order IIR at min_cutoff, min_cutoff 0 turns it off.
+     */
+    uint32_t min_cutoff_mhz;
+    uint32_t beta_mhz;      /* per px/s */
+    uint32_t dcutoff_mhz;   /* for the speed estimate */
+};
+
+#define INDEV_FILTER_CFG_DEFAULT {  \
+    .median_n       = 5,            \
+    .z1_min         = 100,          \
+    .x_plate_ohms   = 300,          \
+    .rt_max_ohms    = 3000,         \
+    .min_cutoff_mhz = 1000,         \
+    .beta_mhz       = 7,            \
+    .dcutoff_mhz    = 1000,         \
+}
+
+struct indev_filter_axis {
+    int32_t  x;     /* Q16 px */
+    int32_t  dx;    /* px/s */
+};
+
+struct indev_filter {
+    const struct indev_filter_cfg *cfg;
+    bool     primed;
+    uint32_t last_us;
+    struct indev_filter_axis ax;
+    struct indev_filter_axis ay;
+};
+
+extern void indev_filter_init(struct indev_filter *f, const struct indev_filter_cfg *cfg);
+
+/* sorts v in place */
+extern uint16_t indev_filter_median(uint16_t *v, int n);
+
+extern bool indev_filter_pressure_ok(const struct indev_filter_cfg *cfg,
+                                     uint16_t x, uint16_t z1, uint16_t z2);
+
+/* pen up, the next sample starts a new stroke */
+extern void indev_filter_reset(struct indev_filter *f);
+extern void indev_filter_smooth(struct indev_filter *f, uint16_t *x, uint16_t *y, uint32_t now_us);
+
+#endif
@@ -0,0 +1,71 @@
+// Copyright (c) 2024 embeddedboys developers
+
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef __INDEV_GESTURE_H
+#define __INDEV_GESTURE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "indev.h"
+
+/* fingers closer than this at touch down are not tracked */
+#define INDEV_GESTURE_MIN_DIST      20
+/* how far a gesture has to move before it is reported */
+#define INDEV_GESTURE_PINCH_SLOP    0.06f   /* relative change in distance */
+#define INDEV_GESTURE_ROTATE_SLOP   6.0f    /* degrees */
+
+#define INDEV_GESTURE_PINCH     (1 << 0)
+#define INDEV_GESTURE_ROTATE    (1 << 1)
+
+enum indev_gesture_state {
+    INDEV_GESTURE_BEGIN,
+    INDEV_GESTURE_UPDATE,
+    INDEV_GESTURE_END,
+};
+
+struct indev_gesture {
+    uint8_t type;       /* INDEV_GESTURE_PINCH | INDEV_GESTURE_ROTATE */
+    uint8_t state;      /* enum indev_gesture_state */
+    float   scale;      /* finger distance relative to touch down */
+    float   angle;      /* degrees since touch down, counter clockwise */
+    uint16_t cx;        /* midpoint of the two fingers */
+    uint16_t cy;
+};
+
+struct indev_gesture_ctx {
+    bool    tracking;
+    bool    begun;
+    uint8_t type;
+    uint8_t id[2];      /* track ids of the two fingers */
+    float   dist0;
+    float   angle0;
+    struct indev_gesture last;
+};
+
+extern void indev_gesture_reset(struct indev_gesture_ctx *ctx);
+/* returns true when *g holds something worth reporting */
+extern bool indev_gesture_update(struct indev_gesture_ctx *ctx,
+                                 const struct indev_frame *frame,
+                                 struct indev_gesture *g);
+
+#endif
@@ -0,0 +1,78 @@
+// Copyright (c) 2024 embeddedboys developers
+
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+
+#ifndef __INDEV_PREDICT_H
+#define __INDEV_PREDICT_H
+
+/* Pure C like indev_filter.h, the model also builds on a host */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* samples kept for the velocity and acceleration estimate */
+#define INDEV_PREDICT_HISTORY   4
+
+/*
+ * Drag prediction: the position handed to LVGL is moved ahead along the
+ * finger's path by the time the sample still has to spend in the
+ * pipeline. Times are in us, speeds in px/s.
+ */
+struct indev_predict_cfg {
+    uint32_t lead_us;       /* 0: use the measured pipeline latency */
+    uint16_t max_px;        /* overshoot clamp on the extrapolated distance */
+    uint8_t  accel_pct;     /* weight of the acceleration term, 0: constant velocity */
+    uint16_t min_speed;     /* slower moves are passed through */
+    uint32_t stale_us;      /* no prediction from a sample older than this */
+};
+
+#define INDEV_PREDICT_CFG_DEFAULT { \
+    .lead_us    = 0,                \
+    .max_px     = 24,               \
+    .accel_pct  = 50,               \
+    .min_speed  = 60,               \
+    .stale_us   = 50000,            \
+}
+
+struct indev_predict_sample {
+    uint32_t ts;
+    int16_t  x;
+    int16_t  y;
+};
+
+struct indev_predict {
+    uint8_t  n;     /* valid samples, newest at hist[0] */
+    struct indev_predict_sample hist[INDEV_PREDICT_HISTORY];
+};
+
+/* pen up, the next sample starts a new stroke */
+extern void indev_predict_reset(struct indev_predict *p);
+extern void indev_predict_push(struct indev_predict *p, uint32_t ts, int16_t x, int16_t y);
+
+/*
+ * Position at now_us + lead_us extrapolated from the history, the newest
+ * sample as is when there is too little history, the move is too slow or
+ * the sample too old. Returns true if the position was moved.
+ */
+extern bool indev_predict_get(const struct indev_predict *p, const struct indev_predict_cfg *cfg,
+                              uint32_t now_us, uint32_t lead_us, int16_t *x, int16_t *y);
+
+#endif
@@ -0,0 +1,90 @@
+// Copyright (c) 2024 embeddedboys developers
+
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef __INDEV_REPLAY_H
+#define __INDEV_REPLAY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* LVGL only, the same file drives a host (SDL) LVGL build */
+#include "lvgl/lvgl.h"
+
+#ifndef INDEV_REPLAY_MAX_EVENTS
+#define INDEV_REPLAY_MAX_EVENTS 512
+#endif
+
+struct indev_replay_event {
+    uint32_t t;         /* ms since the start of the recording */
+    int16_t  x;
+    int16_t  y;
+    uint8_t  pressed;
+};
+
+struct indev_replay_stats {
+    uint32_t events;
+    uint32_t duration_ms;
+    uint32_t frames;
+    uint32_t render_ms;     /* sum over frames, from the display monitor_cb */
+    uint32_t render_max_ms;
+    uint32_t px;
+};
+
+#if INDEV_REPLAY_ENABLED
+extern void indev_replay_clear(void);
+extern int indev_replay_add(uint32_t t, int16_t x, int16_t y, bool pressed);
+/* press at (x0, y0), move to (x1, y1) in ms, release, appended at the end */
+extern int indev_replay_swipe(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint32_t ms);
+
+/*
+ * Recording captures what touchpad_read hands to LVGL, into the RAM
+ * buffer and, with echo, also to the console as it happens.
+ */
+extern void indev_replay_record_start(bool echo);
+extern void indev_replay_record_stop(void);
+extern bool indev_replay_recording(void);
+extern void indev_replay_record(const lv_indev_data_t *data);
+
+/* call from the LVGL thread, drives the first pointer input device */
+extern int indev_replay_play(void);
+extern void indev_replay_stop(void);
+extern bool indev_replay_playing(void);
+
+/* read_cb while playing, or the read_cb of a host build */
+extern void indev_replay_read(lv_indev_drv_t *drv, lv_indev_data_t *data);
+
+/* hook for the display driver's monitor_cb */
+extern void indev_replay_frame(uint32_t time_ms, uint32_t px);
+
+extern void indev_replay_get_stats(struct indev_replay_stats *stats);
+/* "# replay begin" .. "# replay end", one "<ms> <x> <y> <pressed>" per line */
+extern void indev_replay_dump(void);
+extern void indev_replay_init(void);
+#else
+static inline void indev_replay_record(const lv_indev_data_t *data) {}
+static inline bool indev_replay_playing(void) { return false; }
+static inline void indev_replay_read(lv_indev_drv_t *drv, lv_indev_data_t *data) {}
+static inline void indev_replay_frame(uint32_t time_ms, uint32_t px) {}
+static inline void indev_replay_init(void) {}
+#endif
+
+#endif
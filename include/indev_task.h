@@ -0,0 +1,61 @@
+// Copyright (c) 2024 embeddedboys developers
+
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef __INDEV_TASK_H
+#define __INDEV_TASK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "indev.h"
+
+/* samples buffered between the touch task and LVGL, power of two */
+#define INDEV_TASK_RING_SIZE    16
+/* sample period while the panel is pressed */
+#define INDEV_TASK_PERIOD_MS    10
+/* poll period for controllers without an INT pin */
+#define INDEV_TASK_POLL_MS      20
+
+struct indev_sample {
+    uint16_t x;
+    uint16_t y;
+    bool     pressed;
+    uint32_t ts;        /* us, low 32 bits of the system timer */
+
+    /* every tracked point, x/y above mirror the first one */
+    struct indev_frame frame;
+};
+
+struct indev_task_stats {
+    uint32_t samples;
+    uint32_t dropped;   /* ring full, LVGL not keeping up */
+    uint32_t irqs;
+};
+
+/* before the scheduler, the task brings the controller up itself */
+extern int indev_task_init(void);
+/* notify is called from the touch task after each queued sample */
+extern void indev_task_set_notify(void (*notify)(void));
+extern bool indev_task_pop(struct indev_sample *s);
+extern bool indev_task_empty(void);
+extern void indev_task_get_stats(struct indev_task_stats *stats);
+
+#endif
@@ -0,0 +1,71 @@
+// Copyright (c) 2024 embeddedboys developers
+
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef __LATENCY_H
+#define __LATENCY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* completed touch-to-photon measurements kept for the statistics */
+#define LATENCY_HISTORY     64
+/* a measurement that stalls this long is dropped, e.g. no redraw */
+#define LATENCY_TIMEOUT_US  500000
+
+/*
+ * One finger-down is followed through these stages in order, a stage is
+ * only taken when the previous one was.
+ */
+enum latency_stage {
+    LATENCY_IRQ,        /* touch INT edge, or first pressed poll */
+    LATENCY_SAMPLE,     /* touch task queued the first pressed sample */
+    LATENCY_READ,       /* LVGL read_cb consumed it */
+    LATENCY_EVENT,      /* LV_EVENT_PRESSED handlers ran */
+    LATENCY_FLUSH,      /* first disp_flush after that */
+    LATENCY_DONE,       /* last area of that frame left the DMA */
+    LATENCY_NR_STAGES,
+};
+
+#if LATENCY_ENABLED
+extern void latency_init(void);
+/* any context, both cores */
+extern void latency_mark(enum latency_stage stage);
+extern void latency_reset(void);
+/* percentile in us from finger-down to stage, over the kept history */
+extern uint32_t latency_percentile(enum latency_stage stage, int pct);
+extern uint32_t latency_count(void);
+#else
+static inline void latency_init(void) {}
+static inline void latency_mark(enum latency_stage stage) {}
+static inline void latency_reset(void) {}
+static inline uint32_t latency_percentile(enum latency_stage stage, int pct) { return 0; }
+static inline uint32_t latency_count(void) { return 0; }
+#endif
+
+/* factory test screen, latency_ui.c */
+#if LATENCY_ENABLED
+extern int latency_ui_start(void);
+#else
+static inline int latency_ui_start(void) { return -1; }
+#endif
+
+#endif
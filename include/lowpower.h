@@ -0,0 +1,56 @@
+// Copyright (c) 2024 embeddedboys developers
+
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef __LOWPOWER_H
+#define __LOWPOWER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+struct lowpower_stats {
+    uint64_t sleep_us[2];       /* per core, time spent in WFI from the idle hooks */
+    uint64_t static_us;         /* time LVGL had no pending timer at all */
+
+    uint32_t wakes;             /* touch wakes out of the static state */
+    uint32_t wakes_no_frame;    /* ... that didn't end up redrawing anything */
+    uint32_t latency_last_us;   /* touch irq to first completed flush */
+    uint32_t latency_min_us;
+    uint32_t latency_max_us;
+    uint64_t latency_sum_us;
+    uint32_t latency_cnt;
+};
+
+#if LOWPOWER_ENABLED
+extern void lowpower_init(void);
+extern void lowpower_lvgl_sleep(bool forever);
+extern void lowpower_touch_wake(void);
+extern void lowpower_frame_flushed(void);
+extern void lowpower_get_stats(struct lowpower_stats *stats);
+extern void lowpower_dump(void);
+#else
+static inline void lowpower_init(void) {}
+static inline void lowpower_lvgl_sleep(bool forever) {}
+static inline void lowpower_touch_wake(void) {}
+static inline void lowpower_frame_flushed(void) {}
+static inline void lowpower_dump(void) {}
+#endif
+
+#endif
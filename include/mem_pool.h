@@ -0,0 +1,69 @@
+// Copyright (c) 2024 embeddedboys developers
+
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef __MEM_POOL_H
+#define __MEM_POOL_H
+
+/* This header is also pulled in by lv_conf.h, keep it free of SDK headers */
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef MEM_POOL_SIZE
+#define MEM_POOL_SIZE   (72 * 1024)
+#endif
+
+/* number of small size classes, see mem_pool_class_size[] */
+#define MEM_POOL_NR_CLASSES 12
+
+struct mem_pool_class_stats {
+    uint32_t size;      /* block payload size */
+    uint32_t allocs;
+    uint32_t frees;
+    int32_t  in_use;
+    uint32_t blocks;    /* blocks carved so far, i.e. the class high-water mark */
+    uint32_t req_bytes; /* bytes actually requested by live allocations */
+};
+
+struct mem_pool_stats {
+    uint32_t arena_size;
+    uint32_t arena_used;    /* bytes taken from the arena by slabs and large blocks */
+    uint32_t arena_hwm;
+
+    uint32_t large_allocs;
+    uint32_t large_in_use;  /* bytes */
+    uint32_t free_bytes;
+    uint32_t largest_free;
+    uint32_t frag_pct;      /* 100 - largest_free / free_bytes */
+    uint32_t failures;
+
+    struct mem_pool_class_stats cls[MEM_POOL_NR_CLASSES];
+};
+
+extern void mem_pool_init(void);
+extern void *mem_pool_alloc(size_t size);
+extern void *mem_pool_realloc(void *ptr, size_t size);
+extern void mem_pool_free(void *ptr);
+
+extern void mem_pool_trim(void);
+extern void mem_pool_get_stats(struct mem_pool_stats *stats);
+extern void mem_pool_dump(void);
+
+#endif
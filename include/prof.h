@@ -0,0 +1,55 @@
+// Copyright (c) 2024 embeddedboys developers
+
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef __PROF_H
+#define __PROF_H
+
+#include <stdint.h>
+
+/* (pc, lr) histogram slots per core, must be a power of two */
+#ifndef PROF_HIST_SIZE
+#define PROF_HIST_SIZE      512
+#endif
+
+/* slightly off 1kHz so the sampler doesn't phase lock with the RTOS tick */
+#define PROF_DEFAULT_HZ     997
+
+struct prof_slot {
+    uint32_t pc;
+    uint32_t lr;
+    uint32_t count;
+};
+
+#if PROF_ENABLED
+extern int prof_start(uint32_t hz);
+extern void prof_stop(void);
+extern void prof_clear(void);
+extern void prof_dump(void);
+extern void prof_init(void);
+#else
+static inline int prof_start(uint32_t hz) { return -1; }
+static inline void prof_stop(void) {}
+static inline void prof_clear(void) {}
+static inline void prof_dump(void) {}
+static inline void prof_init(void) {}
+#endif
+
+#endif
@@ -0,0 +1,77 @@
+// Copyright (c) 2024 embeddedboys developers
+
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef __RTOS_ALLOC_H
+#define __RTOS_ALLOC_H
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "event_groups.h"
+
+/*
+ * Task, queue and event group creation helpers that follow the STATIC_ALLOC_ENABLED
+ * build mode. In static mode the stack, TCB and queue storage are placed
+ * in .bss next to the caller, so they show up in the RAM budget report
+ * and can never fail at runtime. Must be used at function scope.
+ */
+#if configSUPPORT_STATIC_ALLOCATION
+
+#define rtos_task_create(fn, name, depth, arg, prio, handle)                \
+    do {                                                                    \
+        static StackType_t fn##_stack[depth];                               \
+        static StaticTask_t fn##_tcb;                                       \
+        *(handle) = xTaskCreateStatic(fn, name, depth, arg, prio,           \
+                                      fn##_stack, &fn##_tcb);               \
+    } while (0)
+
+#define rtos_queue_create(queue, length, item_size)                         \
+    do {                                                                    \
+        static uint8_t queue##_storage[(length) * (item_size)];             \
+        static StaticQueue_t queue##_struct;                                \
+        queue = xQueueCreateStatic(length, item_size, queue##_storage,      \
+                                   &queue##_struct);                        \
+    } while (0)
+
+#define rtos_event_group_create(group)                                      \
+    do {                                                                    \
+        static StaticEventGroup_t group##_struct;                           \
+        group = xEventGroupCreateStatic(&group##_struct);                   \
+    } while (0)
+
+#else
+
+#define rtos_task_create(fn, name, depth, arg, prio, handle)                \
+    xTaskCreate(fn, name, depth, arg, prio, handle)
+
+#define rtos_queue_create(queue, length, item_size)                         \
+    do {                                                                    \
+        queue = xQueueCreate(length, item_size);                            \
+    } while (0)
+
+#define rtos_event_group_create(group)                                      \
+    do {                                                                    \
+        group = xEventGroupCreate();                                        \
+    } while (0)
+
+#endif
+
+#endif
@@ -0,0 +1,78 @@
+// Copyright (c) 2024 embeddedboys developers
+
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef __RTOS_TRACE_H
+#define __RTOS_TRACE_H
+
+/*
+ * Kernel trace hooks, included at the end of FreeRTOSConfig.h. Keep it to
+ * prototypes and macros, the kernel sources include it everywhere.
+ */
+
+#ifndef __ASSEMBLER__
+
+#include "hardware/timer.h"
+
+#include "trace.h"
+
+#if TASK_STATS_ENABLED
+extern void task_stats_switched_in(void);
+extern void task_stats_switched_out(void);
+#else
+#define task_stats_switched_in()
+#define task_stats_switched_out()
+#endif
+
+#if TRACE_ENABLED
+extern void trace_task_switched_in(void);
+extern void * volatile g_trace_queues[TRACE_MAX_QUEUES];
+
+#define trace_queue_watched(q) \
+    ((void *)(q) == g_trace_queues[0] || (void *)(q) == g_trace_queues[1])
+
+/* only expanded inside queue.c, where Queue_t is visible */
+#define trace_queue(type, q)                                                \
+    do {                                                                    \
+        if (trace_queue_watched(q))                                         \
+            trace_event(type, 0, (uint16_t)(q)->uxMessagesWaiting,          \
+                        (uint32_t)(q));                                     \
+    } while (0)
+
+#define traceQUEUE_SEND(pxQueue)            trace_queue(TRACE_EV_QUEUE_SEND, pxQueue)
+#define traceQUEUE_SEND_FROM_ISR(pxQueue)   trace_queue(TRACE_EV_QUEUE_SEND, pxQueue)
+#define traceQUEUE_RECEIVE(pxQueue)         trace_queue(TRACE_EV_QUEUE_RECV, pxQueue)
+#define traceQUEUE_RECEIVE_FROM_ISR(pxQueue) trace_queue(TRACE_EV_QUEUE_RECV, pxQueue)
+#else
+#define trace_task_switched_in()
+#endif
+
+#if TASK_STATS_ENABLED || TRACE_ENABLED
+#define traceTASK_SWITCHED_IN()                                             \
+    do {                                                                    \
+        task_stats_switched_in();                                           \
+        trace_task_switched_in();                                           \
+    } while (0)
+#define traceTASK_SWITCHED_OUT()    task_stats_switched_out()
+#endif
+
+#endif /* __ASSEMBLER__ */
+
+#endif
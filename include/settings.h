@@ -0,0 +1,59 @@
+// Copyright (c) 2024 embeddedboys developers
+
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef __SETTINGS_H
+#define __SETTINGS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* sectors at the very end of flash, written in turn */
+#ifndef SETTINGS_SECTORS
+#define SETTINGS_SECTORS    2
+#endif
+/* distinct keys the boot scan indexes */
+#define SETTINGS_MAX_KEYS   16
+#define SETTINGS_MAX_LEN    64
+
+/* never renumber, the values live in flash */
+enum settings_key {
+    SETTINGS_KEY_BL_LEVEL       = 1,    /* u8, percent */
+    SETTINGS_KEY_TOUCH_CALIB    = 2,    /* struct indev_calib */
+    SETTINGS_KEY_BUS_CLK_KHZ    = 3,    /* u32, i80 WR clock */
+};
+
+#if SETTINGS_ENABLED
+/* before anything reads a setting, flash reads only */
+extern void settings_init(void);
+/* bytes copied into buf, -1 if the key is not set */
+extern int settings_get(uint16_t key, void *buf, size_t len);
+/* task context, blocks while flash is written; nothing written if unchanged */
+extern int settings_set(uint16_t key, const void *buf, size_t len);
+extern int settings_del(uint16_t key);
+#else
+static inline void settings_init(void) {}
+static inline int settings_get(uint16_t key, void *buf, size_t len) { return -1; }
+static inline int settings_set(uint16_t key, const void *buf, size_t len) { return -1; }
+static inline int settings_del(uint16_t key) { return -1; }
+#endif
+
+#endif
@@ -0,0 +1,52 @@
+// Copyright (c) 2024 embeddedboys developers
+
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef __SPLASH_H
+#define __SPLASH_H
+
+#include <stdint.h>
+
+/* count pixels of one RGB565 colour, runs carry on across rows */
+struct splash_run {
+    uint16_t count;
+    uint16_t color;
+};
+
+/* scripts/splash_rle.py writes one of these into splash_img.c */
+struct splash_img {
+    uint16_t w;
+    uint16_t h;
+    uint16_t bg;        /* the rest of the screen */
+    uint16_t nr_runs;
+    const struct splash_run *runs;
+};
+
+extern const struct splash_img splash_img;
+
+#if SPLASH_ENABLED
+/* right after the panel init sequence, before the flush task runs */
+extern void splash_show(void);
+#else
+static inline void splash_show(void) {}
+#endif
+
+#endif
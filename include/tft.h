@@ -31,6 +31,8 @@
 #include "task.h"
 #include "semphr.h"
 
+#include "bringup.h"
+
 struct tft_priv;
 
 typedef unsigned int u32;
@@ -48,6 +50,16 @@ struct tft_ops {
     int (*set_backlight)(struct tft_priv *priv, uint level);
     void (*set_addr_win)(struct tft_priv *priv, int xs, int ys, int xe, int ye);
     void (*video_sync)(struct tft_priv *priv, int xs, int ys, int xe, int ye, void *vmem, size_t len);
+    /* optional, panel content adaptive brightness, TFT_CABC_* */
+    int (*set_cabc)(struct tft_priv *priv, u8 mode);
+};
+
+/* MIPI DCS 0x55 modes */
+enum {
+    TFT_CABC_OFF,
+    TFT_CABC_UI,
+    TFT_CABC_STILL,
+    TFT_CABC_MOVING,
 };
 
 struct tft_display {
@@ -56,6 +68,8 @@ struct tft_display {
     u32                     bpp;
     u32                     rotate;
     u32                     backlight;
+    /* sleep out to display on in ms, panel specific, 120 if 0 */
+    u32                     wake_ms;
 
     struct tft_ops          tftops;
 };
@@ -85,6 +99,8 @@ struct video_frame {
     int ye;
     void *vmem;
     size_t len;
+    /* if set, run in the flush task in order with the frames, vmem is its arg */
+    void (*fn)(void *arg);
 };
 
 #define TFT_REG_BUF_SIZE 64
@@ -92,13 +108,16 @@ struct video_frame {
 #define TFT_Y_RES LCD_VER_RES
 #define ARRAY_SIZE(arr) (sizeof(arr)/sizeof(arr[0]))
 #define dm_gpio_set_value(p,v) gpio_put(p, v)
-#define mdelay(v) busy_wait_ms(v)
+#define mdelay(v) bringup_delay_ms(v)
 
+extern int tft_gpio_setup(void);
 extern int tft_probe(struct tft_display *display);
 extern int tft_driver_init();
 
 extern int i80_pio_init(uint8_t db_base, uint8_t db_count, uint8_t pin_wr);
 extern int i80_write_buf_rs(void *buf, size_t len, bool rs);
+extern int i80_set_clk_khz(uint32_t khz);
+extern int i80_fill_rs(const void *px, size_t count, bool rs);
 
 extern void fbtft_write_gpio16_wr_rs(struct tft_priv *priv, void *buf, size_t len, bool rs);
 
@@ -110,6 +129,19 @@ extern void fbtft_write_gpio16_wr_rs(struct tft_priv *priv, void *buf, size_t le
 #endif
 
 extern void tft_video_flush(int xs, int ys, int xe, int ye, void *vmem, uint32_t len);
+/* flush task only, the register writes share the bus with the frames; -1 if unsupported */
+extern int tft_set_cabc(u8 mode);
+/* flush task only as well, sleep in/out with the panel's wake delay */
+extern int tft_set_sleep(bool on);
+extern u32 tft_get_wake_ms(void);
+extern void tft_set_display(bool on);
+extern void tft_set_idle(bool on);
+/* rows ys..ye only, ys > ye goes back to normal mode */
+extern void tft_set_partial(int ys, int ye);
+extern void tft_async_call(void (*fn)(void *arg), void *arg);
+/* before the flush task starts, the boot splash draws straight to the bus */
+extern void tft_set_window(int xs, int ys, int xe, int ye);
+extern void tft_fill(u16 px, size_t count);
 extern void tft_async_video_flush(struct video_frame *vf);
 
 extern void tft_write_reg(struct tft_priv *priv, int len, ...);
@@ -0,0 +1,84 @@
+// Copyright (c) 2024 embeddedboys developers
+
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef __TRACE_H
+#define __TRACE_H
+
+/* This header is also pulled in by FreeRTOSConfig.h, keep it free of SDK headers */
+#include <stdint.h>
+
+/* events per core, must be a power of two */
+#ifndef TRACE_RING_SIZE
+#define TRACE_RING_SIZE     256
+#endif
+
+/* queues whose send/receive are traced, see trace_queue_watch() */
+#define TRACE_MAX_QUEUES    2
+
+enum trace_event_type {
+    TRACE_EV_TASK_IN = 1,   /* data: task handle */
+    TRACE_EV_SPAN_BEGIN,    /* id: span id */
+    TRACE_EV_SPAN_END,
+    TRACE_EV_QUEUE_SEND,    /* data: queue handle, arg: items waiting before */
+    TRACE_EV_QUEUE_RECV,
+    TRACE_EV_MARK,          /* id: span id, arg/data: free form */
+};
+
+enum trace_span_id {
+    TRACE_SPAN_LV_TIMER,
+    TRACE_SPAN_DISP_FLUSH,
+    TRACE_SPAN_VIDEO_FLUSH,
+    TRACE_SPAN_TOUCH_READ,
+    TRACE_SPAN_NR,
+};
+
+struct trace_event {
+    uint32_t ts;    /* low 32 bits of the 1MHz timer */
+    uint8_t  type;
+    uint8_t  id;
+    uint16_t arg;
+    uint32_t data;
+};
+
+#if TRACE_ENABLED
+extern void trace_event(uint8_t type, uint8_t id, uint16_t arg, uint32_t data);
+extern void trace_queue_watch(void *queue, const char *name);
+extern void trace_start(void);
+extern void trace_stop(void);
+extern void trace_dump(void);
+extern void trace_init(void);
+
+#define trace_span_begin(id)        trace_event(TRACE_EV_SPAN_BEGIN, id, 0, 0)
+#define trace_span_end(id)          trace_event(TRACE_EV_SPAN_END, id, 0, 0)
+#define trace_mark(id, arg, data)   trace_event(TRACE_EV_MARK, id, arg, data)
+#else
+static inline void trace_queue_watch(void *queue, const char *name) {}
+static inline void trace_start(void) {}
+static inline void trace_stop(void) {}
+static inline void trace_dump(void) {}
+static inline void trace_init(void) {}
+
+#define trace_span_begin(id)
+#define trace_span_end(id)
+#define trace_mark(id, arg, data)
+#endif
+
+#endif
@@ -0,0 +1,184 @@
+#!/usr/bin/env python3
+# Copyright (c) 2024 embeddedboys developers
+
+# Permission is hereby granted, free of charge, to any person obtaining
+# a copy of this software and associated documentation files (the
+# "Software"), to deal in the Software without restriction, including
+# without limitation the rights to use, copy, modify, merge, publish,
+# distribute, sublicense, and/or sell copies of the Software, and to
+# permit persons to whom the Software is furnished to do so, subject to
+# the following conditions:
+
+# The above copyright notice and this permission notice shall be
+# included in all copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+# EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+# NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+# LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+# OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+# WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+# Per-subsystem RAM budget report, run after link on the .elf.map file.
+#
+#   mem_budget.py <file.elf.map> [--limit name=KB ...]
+#
+# Every input section placed in a RAM region (RAM, SCRATCH_X, SCRATCH_Y)
+# is attributed to a subsystem by the object file it came from. Exits
+# non-zero when a subsystem goes over its --limit, so the build fails.
+
+import argparse
+import re
+import sys
+
+# first match wins
+SUBSYSTEMS = [
+    ("stack",    None,  re.compile(r"^\.stack")),
+    ("heap",     None,  re.compile(r"^\.heap")),
+    ("lvgl",     re.compile(r"liblvgl|[/\\]lvgl[/\\]"), None),
+    ("freertos", re.compile(r"FreeRTOS-Kernel|rtos_static\.c"), None),
+    ("mem_pool", re.compile(r"mem_pool\.c"), None),
+    ("trace",    re.compile(r"trace\.c"), None),
+    ("prof",     re.compile(r"prof\.c"), None),
+    ("display",  re.compile(r"tft[^/\\]*\.c|[/\\]pio[/\\]|pio_i80|lv_port_disp|backlight\.c|cabc\.c|disp_power\.c"), None),
+    ("indev",    re.compile(r"indev[^/\\]*\.c|gt911|ft6236|tsc2007|ns2009|xpt2046|i2c_tools|i2c_bus|lv_port_indev"), None),
+    ("pico-sdk", re.compile(r"pico-sdk|pico_sdk|[/\\]rp2_common[/\\]|[/\\]common[/\\]|bs2_default"), None),
+    ("libc",     re.compile(r"libc(_nano)?\.a|libg(_nano)?\.a|libgcc\.a|libm\.a|libnosys\.a|libstdc"), None),
+    ("app",      re.compile(r"\.c\.obj|\.o\b"), None),
+]
+
+RAM_REGIONS = ("RAM", "SCRATCH_X", "SCRATCH_Y")
+
+HEX = r"0x[0-9a-fA-F]+"
+REGION_RE = re.compile(r"^(\S+)\s+(" + HEX + r")\s+(" + HEX + r")")
+ADDR_SIZE_RE = re.compile(r"^\s*(" + HEX + r")\s+(" + HEX + r")\s*(.*)$")
+
+
+def parse_map(path):
+    regions = {}
+    entries = []    # (out_section, in_section, addr, size, obj)
+
+    with open(path, "r", errors="replace") as f:
+        lines = f.read().splitlines()
+
+    i = 0
+    # memory configuration
+    while i < len(lines) and not lines[i].startswith("Memory Configuration"):
+        i += 1
+    while i < len(lines) and not lines[i].startswith("Linker script and memory map"):
+        m = REGION_RE.match(lines[i])
+        if m and m.group(1) in RAM_REGIONS:
+            regions[m.group(1)] = (int(m.group(2), 16), int(m.group(3), 16))
+        i += 1
+
+    out_sec = None
+    pending = None
+    for line in lines[i:]:
+        if not line.strip():
+            continue
+
+        if not line[0].isspace():
+            # output section, may wrap onto the next line when the name is long
+            tok = line.split()
+            if tok[0].startswith("."):
+                out_sec = tok[0]
+            pending = None
+            continue
+
+        if pending is not None:
+            m = ADDR_SIZE_RE.match(line)
+            if m:
+                entries.append((out_sec, pending, int(m.group(1), 16),
+                                int(m.group(2), 16), m.group(3).strip()))
+            pending = None
+            continue
+
+        tok = line.split()
+        name = tok[0]
+        if not (name.startswith(".") or name == "COMMON" or name == "*fill*"):
+            continue
+        if len(tok) == 1:
+            pending = name
+            continue
+        m = ADDR_SIZE_RE.match(line[line.index(name) + len(name):])
+        if m:
+            entries.append((out_sec, name, int(m.group(1), 16),
+                            int(m.group(2), 16), m.group(3).strip()))
+
+    return regions, entries
+
+
+def classify(out_sec, obj):
+    for name, obj_re, sec_re in SUBSYSTEMS:
+        if sec_re is not None and out_sec and sec_re.match(out_sec):
+            return name
+        if obj_re is not None and obj_re.search(obj):
+            return name
+    return "other"
+
+
+def in_regions(regions, addr):
+    for start, length in regions.values():
+        if start <= addr < start + length:
+            return True
+    return False
+
+
+def main():
+    ap = argparse.ArgumentParser(description="per-subsystem RAM budget report")
+    ap.add_argument("map", help="linker map file")
+    ap.add_argument("--limit", action="append", default=[], metavar="NAME=KB",
+                    help="fail when subsystem NAME uses more than KB kilobytes")
+    args = ap.parse_args()
+
+    limits = {}
+    for item in args.limit:
+        name, _, kb = item.partition("=")
+        if not kb:
+            continue
+        limits[name.strip()] = int(float(kb) * 1024)
+
+    regions, entries = parse_map(args.map)
+    if not regions:
+        print("mem_budget: no RAM region found in %s" % args.map, file=sys.stderr)
+        return 1
+
+    usage = {}
+    for out_sec, in_sec, addr, size, obj in entries:
+        if size == 0 or not in_regions(regions, addr):
+            continue
+        name = "padding" if in_sec == "*fill*" else classify(out_sec, obj)
+        usage[name] = usage.get(name, 0) + size
+
+    total = sum(usage.values())
+    capacity = sum(length for _, length in regions.values())
+    failed = []
+
+    print("RAM budget (%s)" % ", ".join(sorted(regions)))
+    print("  %-10s %10s %10s %6s" % ("subsystem", "used", "limit", "%"))
+    for name in sorted(usage, key=lambda n: -usage[n]):
+        used = usage[name]
+        limit = limits.get(name)
+        if limit:
+            pct = "%5.1f" % (used * 100.0 / limit)
+            flag = " OVER" if used > limit else ""
+            if used > limit:
+                failed.append(name)
+            print("  %-10s %10d %10d %6s%s" % (name, used, limit, pct, flag))
+        else:
+            print("  %-10s %10d %10s %6s" % (name, used, "-", "-"))
+    print("  %-10s %10d %10d %5.1f" % ("total", total, capacity, total * 100.0 / capacity))
+
+    for name in limits:
+        if name not in usage:
+            print("mem_budget: warning: no RAM attributed to '%s'" % name)
+
+    if failed:
+        print("mem_budget: over budget: %s" % ", ".join(failed), file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,137 @@
+#!/usr/bin/env python3
+# Copyright (c) 2024 embeddedboys developers
+
+# Permission is hereby granted, free of charge, to any person obtaining
+# a copy of this software and associated documentation files (the
+# "Software"), to deal in the Software without restriction, including
+# without limitation the rights to use, copy, modify, merge, publish,
+# distribute, sublicense, and/or sell copies of the Software, and to
+# permit persons to whom the Software is furnished to do so, subject to
+# the following conditions:
+
+# The above copyright notice and this permission notice shall be
+# included in all copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+# EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+# NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+# LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+# OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+# WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+# Symbolize a "prof dump" captured from the UART console.
+#
+#   prof_symbolize.py uart.log build/src/rp2040-freertos-template.elf
+#
+# Prints a flat profile (self samples per function) and, for the hottest
+# functions, the callers seen in the sampled LR. LR is exact for leaf
+# functions and only a hint for the rest.
+
+import argparse
+import bisect
+import subprocess
+import sys
+
+
+def read_dump(path):
+    dump, last = None, None
+    with open(path, "r", errors="replace") as f:
+        for line in f:
+            line = line.strip()
+            if line.startswith("# prof begin"):
+                dump = []
+            elif line.startswith("# prof end"):
+                if dump is not None:
+                    last = dump
+                dump = None
+            elif dump is not None:
+                dump.append(line)
+    if last is None:
+        sys.exit("no complete '# prof begin' ... '# prof end' block in %s" % path)
+
+    cores, samples = {}, []     # samples: (core, pc, lr, count)
+    for line in last:
+        f = line.split()
+        if len(f) == 4 and f[0] == "C":
+            cores[int(f[1])] = (int(f[2]), int(f[3]))
+        elif len(f) == 5 and f[0] == "P":
+            samples.append((int(f[1]), int(f[2], 16), int(f[3], 16), int(f[4])))
+    return cores, samples
+
+
+class Symbols:
+    def __init__(self, elf, nm):
+        out = subprocess.run([nm, "-n", "-S", "--defined-only", "-C", elf],
+                             check=True, capture_output=True, text=True).stdout
+        self.addrs, self.syms = [], []
+        for line in out.splitlines():
+            f = line.split(None, 3)
+            if len(f) != 4 or f[2] not in "tTwW":
+                continue
+            addr, size = int(f[0], 16) & ~1, int(f[1], 16)
+            self.addrs.append(addr)
+            self.syms.append((addr, size, f[3]))
+
+    def lookup(self, addr):
+        i = bisect.bisect_right(self.addrs, addr) - 1
+        if i >= 0:
+            start, size, name = self.syms[i]
+            if start <= addr < start + max(size, 2):
+                return name
+        return "0x%08x" % addr
+
+
+def main():
+    ap = argparse.ArgumentParser(description="symbolize a UART prof dump")
+    ap.add_argument("log", help="captured console output")
+    ap.add_argument("elf", help="the .elf that was running")
+    ap.add_argument("--nm", default="arm-none-eabi-nm")
+    ap.add_argument("--core", type=int, help="only report this core")
+    ap.add_argument("--top", type=int, default=30, help="functions in the flat report")
+    ap.add_argument("--callers", type=int, default=10,
+                    help="functions that get a caller breakdown")
+    args = ap.parse_args()
+
+    cores, samples = read_dump(args.log)
+    syms = Symbols(args.elf, args.nm)
+
+    if args.core is not None:
+        samples = [s for s in samples if s[0] == args.core]
+
+    total = sum(s[3] for s in samples)
+    if not total:
+        sys.exit("no samples")
+
+    flat, callers = {}, {}
+    for core, pc, lr, count in samples:
+        fn = syms.lookup(pc)
+        flat[fn] = flat.get(fn, 0) + count
+        c = callers.setdefault(fn, {})
+        caller = syms.lookup(lr)
+        c[caller] = c.get(caller, 0) + count
+
+    for core in sorted(cores):
+        n, dropped = cores[core]
+        print("core%d: %d samples, %d dropped" % (core, n, dropped))
+    print()
+
+    ranked = sorted(flat.items(), key=lambda kv: -kv[1])
+
+    print("%8s %7s %7s  %s" % ("samples", "self%", "cum%", "function"))
+    cum = 0
+    for fn, n in ranked[:args.top]:
+        cum += n
+        print("%8d %6.2f%% %6.2f%%  %s" % (n, n * 100.0 / total, cum * 100.0 / total, fn))
+    print()
+
+    print("callers (from LR)")
+    for fn, n in ranked[:args.callers]:
+        print("%s  [%d]" % (fn, n))
+        for caller, cn in sorted(callers[fn].items(), key=lambda kv: -kv[1])[:5]:
+            print("    %6.2f%%  %s" % (cn * 100.0 / n, caller))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
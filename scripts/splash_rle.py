@@ -0,0 +1,116 @@
+#!/usr/bin/env python3
+# Copyright (c) 2024 embeddedboys developers
+
+# Permission is hereby granted, free of charge, to any person obtaining
+# a copy of this software and associated documentation files (the
+# "Software"), to deal in the Software without restriction, including
+# without limitation the rights to use, copy, modify, merge, publish,
+# distribute, sublicense, and/or sell copies of the Software, and to
+# permit persons to whom the Software is furnished to do so, subject to
+# the following conditions:
+
+# The above copyright notice and this permission notice shall be
+# included in all copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+# EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+# NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+# LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+# OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+# WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+# Run-length encode the boot splash into src/splash_img.c.
+#
+#   splash_rle.py [logo.png] [--bg 101418] [-o src/splash_img.c]
+#
+# The image is centered on a screen filled with --bg. Runs of one RGB565
+# colour carry on across rows, the panel window wraps them. Without an
+# input (or Pillow) a plain ring logo is drawn.
+
+import argparse
+import sys
+
+LICENSE = open(__file__).read().split("\n\n# Run-length")[0].split("\n", 1)[1]
+MAX_RUN = 0xFFFF
+
+
+def rgb565(r, g, b):
+    return ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3)
+
+
+def default_logo(bg):
+    size, outer, inner, dot = 96, 46, 32, 14
+    ring, centre = rgb565(0x21, 0x96, 0xF3), rgb565(0xFF, 0xFF, 0xFF)
+    c = (size - 1) / 2.0
+    px = []
+    for y in range(size):
+        for x in range(size):
+            d2 = (x - c) ** 2 + (y - c) ** 2
+            if d2 <= dot * dot:
+                px.append(centre)
+            elif inner * inner <= d2 <= outer * outer:
+                px.append(ring)
+            else:
+                px.append(bg)
+    return size, size, px
+
+
+def load(path, bg):
+    try:
+        from PIL import Image
+    except ImportError:
+        sys.exit("Pillow is needed to read %s" % path)
+    img = Image.open(path).convert("RGBA")
+    w, h = img.size
+    br, bgn, bb = (bg >> 11) << 3, ((bg >> 5) & 0x3F) << 2, (bg & 0x1F) << 3
+    px = []
+    for r, g, b, a in img.getdata():
+        # blend onto the background, the panel has no alpha
+        r = (r * a + br * (255 - a)) // 255
+        g = (g * a + bgn * (255 - a)) // 255
+        b = (b * a + bb * (255 - a)) // 255
+        px.append(rgb565(r, g, b))
+    return w, h, px
+
+
+def encode(px):
+    runs = []
+    for p in px:
+        if runs and runs[-1][1] == p and runs[-1][0] < MAX_RUN:
+            runs[-1][0] += 1
+        else:
+            runs.append([1, p])
+    return runs
+
+
+def main():
+    ap = argparse.ArgumentParser(description="RLE encode the boot splash")
+    ap.add_argument("image", nargs="?", help="logo, any format Pillow reads")
+    ap.add_argument("--bg", default="101418", help="screen colour, RRGGBB")
+    ap.add_argument("-o", "--output", default="src/splash_img.c")
+    args = ap.parse_args()
+
+    v = int(args.bg, 16)
+    bg = rgb565(v >> 16, (v >> 8) & 0xFF, v & 0xFF)
+    w, h, px = load(args.image, bg) if args.image else default_logo(bg)
+    runs = encode(px)
+
+    with open(args.output, "w") as f:
+        f.write("\n".join("//" + l[1:] if l else l for l in LICENSE.split("\n")) + "\n\n")
+        f.write("/* generated by scripts/splash_rle.py, do not edit */\n\n")
+        f.write("#include \"splash.h\"\n\n")
+        f.write("static const struct splash_run splash_runs[] = {\n")
+        for i in range(0, len(runs), 6):
+            f.write("    " + " ".join("{ %5d, 0x%04x }," % tuple(r) for r in runs[i:i + 6]) + "\n")
+        f.write("};\n\n")
+        f.write("const struct splash_img splash_img = {\n")
+        f.write("    .w       = %d,\n    .h       = %d,\n    .bg      = 0x%04x,\n" % (w, h, bg))
+        f.write("    .nr_runs = %d,\n    .runs    = splash_runs,\n};\n" % len(runs))
+
+    print("%dx%d, %d runs, %d bytes -> %s" % (w, h, len(runs), len(runs) * 4, args.output))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
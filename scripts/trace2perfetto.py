@@ -0,0 +1,181 @@
+#!/usr/bin/env python3
+# Copyright (c) 2024 embeddedboys developers
+
+# Permission is hereby granted, free of charge, to any person obtaining
+# a copy of this software and associated documentation files (the
+# "Software"), to deal in the Software without restriction, including
+# without limitation the rights to use, copy, modify, merge, publish,
+# distribute, sublicense, and/or sell copies of the Software, and to
+# permit persons to whom the Software is furnished to do so, subject to
+# the following conditions:
+
+# The above copyright notice and this permission notice shall be
+# included in all copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+# EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+# NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+# LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+# OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+# WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+# Convert a "trace dump" captured from the UART console into a Chrome JSON
+# trace, which opens in https://ui.perfetto.dev or chrome://tracing.
+#
+#   trace2perfetto.py uart.log -o trace.json
+#
+# Other console output around the "# trace begin/end" markers is ignored,
+# if the log holds several dumps the last one is used.
+
+import argparse
+import json
+import sys
+
+EV_TASK_IN = 1
+EV_SPAN_BEGIN = 2
+EV_SPAN_END = 3
+EV_QUEUE_SEND = 4
+EV_QUEUE_RECV = 5
+EV_MARK = 6
+
+PID = 1
+SPAN_TID_BASE = 100
+
+
+def read_dump(path):
+    dump, last = None, None
+    with open(path, "r", errors="replace") as f:
+        for line in f:
+            line = line.strip()
+            if line.startswith("# trace begin"):
+                dump = []
+            elif line.startswith("# trace end"):
+                if dump is not None:
+                    last = dump
+                dump = None
+            elif dump is not None:
+                dump.append(line)
+    if last is None:
+        sys.exit("no complete '# trace begin' ... '# trace end' block in %s" % path)
+    return last
+
+
+def parse(lines):
+    spans, tasks, queues = {}, {}, {}
+    events = {}     # core -> [(ts, type, id, arg, data)]
+
+    for line in lines:
+        tok = line.split(None, 2)
+        if not tok:
+            continue
+        if tok[0] == "S" and len(tok) == 3:
+            spans[int(tok[1])] = tok[2]
+        elif tok[0] == "T" and len(tok) == 3:
+            tasks[int(tok[1], 16)] = tok[2]
+        elif tok[0] == "Q" and len(tok) == 3:
+            queues[int(tok[1], 16)] = tok[2]
+        elif tok[0] == "E":
+            f = line.split()
+            if len(f) != 7:
+                continue
+            core = int(f[1])
+            events.setdefault(core, []).append(
+                (int(f[2]), int(f[3]), int(f[4]), int(f[5]), int(f[6], 16)))
+
+    return spans, tasks, queues, events
+
+
+def unwrap(events):
+    """The device stamps events with the low 32 bits of the us timer."""
+    out = {}
+    for core, evs in events.items():
+        base, prev, res = 0, None, []
+        for ev in evs:
+            ts = ev[0]
+            if prev is not None and ts < prev and prev - ts > (1 << 31):
+                base += 1 << 32
+            prev = ts
+            res.append((ts + base,) + ev[1:])
+        out[core] = res
+    return out
+
+
+def convert(spans, tasks, queues, events):
+    events = unwrap(events)
+    t0 = min((evs[0][0] for evs in events.values() if evs), default=0)
+    out = [{"ph": "M", "pid": PID, "name": "process_name", "args": {"name": "rp2040"}}]
+
+    for core in sorted(events):
+        out.append({"ph": "M", "pid": PID, "tid": core, "name": "thread_name",
+                    "args": {"name": "core%d tasks" % core}})
+        out.append({"ph": "M", "pid": PID, "tid": SPAN_TID_BASE + core, "name": "thread_name",
+                    "args": {"name": "core%d spans" % core}})
+
+        cur_task, cur_ts = None, None
+        open_spans = []
+
+        for ts, typ, sid, arg, data in events[core]:
+            t = ts - t0
+
+            if typ == EV_TASK_IN:
+                if cur_task is not None and not cur_task.startswith("IDLE"):
+                    out.append({"ph": "X", "pid": PID, "tid": core, "name": cur_task,
+                                "ts": cur_ts, "dur": t - cur_ts})
+                cur_task = tasks.get(data, "task %08x" % data)
+                cur_ts = t
+            elif typ == EV_SPAN_BEGIN:
+                open_spans.append(sid)
+                out.append({"ph": "B", "pid": PID, "tid": SPAN_TID_BASE + core,
+                            "name": spans.get(sid, "span %d" % sid), "ts": t})
+            elif typ == EV_SPAN_END:
+                # the ring may have dropped the matching begin
+                if sid not in open_spans:
+                    continue
+                while open_spans:
+                    top = open_spans.pop()
+                    out.append({"ph": "E", "pid": PID, "tid": SPAN_TID_BASE + core,
+                                "name": spans.get(top, "span %d" % top), "ts": t})
+                    if top == sid:
+                        break
+            elif typ in (EV_QUEUE_SEND, EV_QUEUE_RECV):
+                # arg is the depth seen before the operation
+                depth = arg + 1 if typ == EV_QUEUE_SEND else max(arg - 1, 0)
+                name = queues.get(data, "queue %08x" % data)
+                out.append({"ph": "C", "pid": PID, "name": "%s depth" % name,
+                            "ts": t, "args": {"depth": depth}})
+                out.append({"ph": "i", "pid": PID, "tid": core, "s": "t",
+                            "name": "%s %s" % (name, "send" if typ == EV_QUEUE_SEND else "recv"),
+                            "ts": t})
+            elif typ == EV_MARK:
+                out.append({"ph": "i", "pid": PID, "tid": SPAN_TID_BASE + core, "s": "t",
+                            "name": spans.get(sid, "mark %d" % sid), "ts": t,
+                            "args": {"arg": arg, "data": data}})
+
+        if cur_task is not None and not cur_task.startswith("IDLE") and events[core]:
+            end = events[core][-1][0] - t0
+            out.append({"ph": "X", "pid": PID, "tid": core, "name": cur_task,
+                        "ts": cur_ts, "dur": end - cur_ts})
+
+    return {"traceEvents": out, "displayTimeUnit": "ms"}
+
+
+def main():
+    ap = argparse.ArgumentParser(description="convert a UART trace dump to Perfetto JSON")
+    ap.add_argument("log", help="captured console output")
+    ap.add_argument("-o", "--output", default="trace.json")
+    args = ap.parse_args()
+
+    spans, tasks, queues, events = parse(read_dump(args.log))
+    trace = convert(spans, tasks, queues, events)
+
+    with open(args.output, "w") as f:
+        json.dump(trace, f)
+
+    print("%d events from %d cores -> %s" %
+          (sum(len(e) for e in events.values()), len(events), args.output))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -43,8 +43,13 @@
 /* Scheduler Related */
 #define configUSE_PREEMPTION                    1
 #define configUSE_TICKLESS_IDLE                 0
-#define configUSE_IDLE_HOOK                     0
-#define configUSE_TICK_HOOK                     1
+#ifndef LOWPOWER_ENABLED
+#define LOWPOWER_ENABLED                        0
+#endif
+/* idle hooks WFI, see lowpower.c */
+#define configUSE_IDLE_HOOK                     LOWPOWER_ENABLED
+#define configUSE_PASSIVE_IDLE_HOOK             LOWPOWER_ENABLED
+#define configUSE_TICK_HOOK                     0
 #define configUSE_MINIMAL_IDLE_HOOK             0
 #define configTICK_RATE_HZ                      ( ( TickType_t ) 1000 )
 #define configMAX_PRIORITIES                    32
@@ -71,18 +76,34 @@
 #define configMESSAGE_BUFFER_LENGTH_TYPE        size_t
 
 /* Memory allocation related definitions. */
+#ifndef STATIC_ALLOC_ENABLED
+#define STATIC_ALLOC_ENABLED                    0
+#endif
+/* STATIC_ALLOC_ENABLED: every task, queue and kernel object lives in .bss */
+#if STATIC_ALLOC_ENABLED
+#define configSUPPORT_STATIC_ALLOCATION         1
+#define configSUPPORT_DYNAMIC_ALLOCATION        0
+#else
 #define configSUPPORT_STATIC_ALLOCATION         0
 #define configSUPPORT_DYNAMIC_ALLOCATION        1
+#endif
 #define configTOTAL_HEAP_SIZE                   (128*1024)
 #define configAPPLICATION_ALLOCATED_HEAP        0
 
 /* Hook function related definitions. */
-#define configCHECK_FOR_STACK_OVERFLOW          0
+#define configCHECK_FOR_STACK_OVERFLOW          2
 #define configUSE_MALLOC_FAILED_HOOK            0
 #define configUSE_DAEMON_TASK_STARTUP_HOOK      0
 
 /* Run time and task stats gathering related definitions. */
-#define configGENERATE_RUN_TIME_STATS           0
+#ifndef TASK_STATS_ENABLED
+#define TASK_STATS_ENABLED                      0
+#endif
+/* run time counter is the 1MHz system timer, see task_stats.c */
+#define configGENERATE_RUN_TIME_STATS           TASK_STATS_ENABLED
+#define configRUN_TIME_COUNTER_TYPE             uint64_t
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+#define portGET_RUN_TIME_COUNTER_VALUE()        time_us_64()
 #define configUSE_TRACE_FACILITY                1
 #define configUSE_STATS_FORMATTING_FUNCTIONS    0
 
@@ -148,5 +169,6 @@ to exclude the API function. */
 #define INCLUDE_xQueueGetMutexHolder            1
 
 /* A header file that defines trace macro can be included here. */
+#include "rtos_trace.h"
 
 #endif /* FREERTOS_CONFIG_H */
\ No newline at end of file
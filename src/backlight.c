@@ -19,17 +19,58 @@
 // OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
 // WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
+
+/*
+ * Backlight PWM.
+ *
+ * Levels are percent, mapped through a gamma 2.2 table so equal steps
+ * look equal. Content adaptive dimming (cabc.c) scales the user level.
+ * Fades are run by DMA: the ramp is precomputed into a buffer of CC
+ * register words and one is written per wrap of a pacer PWM slice, so a
+ * fade costs no CPU until its completion interrupt.
+ *
+ * The API is called from the console, the flush task (cabc) and
+ * disp_power, the entry points that touch the PWM or the fade DMA
+ * hold the device lock.
+ */
+
+#define pr_fmt(fmt) "backlight: " fmt
+
 #include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "pico/mutex.h"
 #include "hardware/gpio.h"
 #include "hardware/pwm.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/clocks.h"
 
 #include "backlight.h"
+#include "console.h"
+#include "settings.h"
+#include "debug.h"
 
 #define BL_LVL_DEF_MIN 0
 #define BL_LVL_DEF_MAX 100
 #define BL_LVL_DEF_OFFSET 5
 #define BL_LVL_DEF_LVL 100
 
+#define BL_GAMMA            2.2f
+
+/*
+ * The fade is paced by another slice's wrap DREQ, the backlight slice
+ * keeps its full 16-bit carrier. Slice 7 sits on GPIO 14/15, which the
+ * LCD bus drives through PIO, so its counter is free.
+ */
+#define BL_FADE_PACER_SLICE 7
+#define BL_FADE_PACER_HZ    2000000
+#define BL_FADE_MAX_STEPS   256
+/* the pacer wrap is 16-bit, one step lasts at most 32 ms */
+#define BL_FADE_MAX_MS      (BL_FADE_MAX_STEPS * 65536ull * 1000 / BL_FADE_PACER_HZ)
+#define BL_FADE_DMA_IRQ     DMA_IRQ_1
+
 struct backlight_device;
 
 struct backlight_profile {
@@ -53,32 +94,101 @@ struct backlight_ops {
     void (*set_max)(struct backlight_device *dev, u8 max);
     u8 (*get_max)(struct backlight_device *dev);
 
+    /* the hardware level changed behind set_lvl, e.g. at the end of a fade */
     void (*bl_drv_update_cb)(struct backlight_device *dev);
 };
 
+struct backlight_fade {
+    int  dma;
+    uint pacer;
+    volatile bool busy;
+    u8   from;
+    u8   to;
+    u16  steps;
+
+    backlight_fade_done_t done;
+    void *arg;
+
+    /* whole CC words, the other channel of the slice is kept as is */
+    u32  ramp[BL_FADE_MAX_STEPS];
+};
+
 struct backlight_device {
     u8 bl_pin;
     u8 bl_lvl;
+    u8 user_lvl;    /* last level asked for, before adaptive dimming */
+    u8 adapt;       /* content adaptive scale in percent, 100 = none */
+    bool blank;     /* PWM held at 0, levels are still tracked */
+
+    uint slice;
+    uint chan;
 
     struct backlight_profile prof;
-} g_bl_priv;
+    struct backlight_ops *ops;
+    struct backlight_fade fade;
+    /* recursive, a fade's done callback may come back in */
+    recursive_mutex_t lock;
 
+    u16 gamma[101];
+} g_bl_priv;
 
-void __bl_set_lvl(struct backlight_device *dev, u8 level)
+/* percent to PWM level, user level with min/max and offset applied */
+static u8 __bl_percent(struct backlight_device *dev, u8 level)
 {
+    if (level < dev->prof.bl_lvl_min)
+        level = dev->prof.bl_lvl_min;
+    if (level > dev->prof.bl_lvl_max)
+        level = dev->prof.bl_lvl_max;
+
     /* we shouldn't set backlight percent to 0%, otherwise we can't see nothing */
-    u8 percent = (level + dev->prof.bl_lvl_offs) > 100 ? 100 : (level + dev->prof.bl_lvl_offs);
+    return (level + dev->prof.bl_lvl_offs) > 100 ? 100 : (level + dev->prof.bl_lvl_offs);
+}
+
+/* the user level after offset and content adaptive dimming */
+static u8 __bl_target(struct backlight_device *dev, u8 level)
+{
+    dev->user_lvl = level;
+    return __bl_percent(dev, level) * dev->adapt / 100;
+}
+
+/* percent in Q8, interpolated between the gamma table entries */
+static u16 __bl_gamma_q8(struct backlight_device *dev, u32 percent_q8)
+{
+    u32 i = percent_q8 >> 8, frac = percent_q8 & 0xFF;
+
+    if (i >= 100)
+        return dev->gamma[100];
+
+    return dev->gamma[i] + (((int32_t)dev->gamma[i + 1] - dev->gamma[i]) * (int32_t)frac >> 8);
+}
+
+static u32 __bl_cc_word(struct backlight_device *dev, u16 pwm_lvl)
+{
+    u32 cc = pwm_hw->slice[dev->slice].cc;
+
+    if (dev->chan == PWM_CHAN_A)
+        return (cc & PWM_CH0_CC_B_BITS) | pwm_lvl;
+    return (cc & PWM_CH0_CC_A_BITS) | ((u32)pwm_lvl << PWM_CH0_CC_B_LSB);
+}
+
+static void __bl_fade_stop(struct backlight_device *dev);
+
+static void __bl_set_lvl(struct backlight_device *dev, u8 level)
+{
+    u8 percent = __bl_target(dev, level);
 
-    /* To pwm level */
-    u16 pwm_lvl = (percent * 65535 / 100);
-    pwm_set_gpio_level(dev->bl_pin, pwm_lvl);
+    __bl_fade_stop(dev);
+
+    pwm_set_gpio_level(dev->bl_pin, dev->blank ? 0 : dev->gamma[percent]);
 
     dev->bl_lvl = percent;
 }
 
 void backlight_set_level(u8 level)
 {
-    __bl_set_lvl(&g_bl_priv, level);
+    recursive_mutex_enter_blocking(&g_bl_priv.lock);
+    g_bl_priv.ops->set_lvl(&g_bl_priv, level);
+    recursive_mutex_exit(&g_bl_priv.lock);
 }
 
 static u8 __bl_get_lvl(struct backlight_device *dev)
@@ -88,7 +198,7 @@ static u8 __bl_get_lvl(struct backlight_device *dev)
 
 u8 backlight_get_level(void)
 {
-    return __bl_get_lvl(&g_bl_priv);
+    return g_bl_priv.ops->get_lvl(&g_bl_priv);
 }
 
 static void __bl_set_offset(struct backlight_device *dev, uint8_t offset)
@@ -98,7 +208,7 @@ static void __bl_set_offset(struct backlight_device *dev, uint8_t offset)
 
 void backlight_set_offset(u8 offset)
 {
-    __bl_set_offset(&g_bl_priv, offset);
+    g_bl_priv.ops->set_offs(&g_bl_priv, offset);
 }
 
 static u8 __bl_get_offset(struct backlight_device *dev)
@@ -108,7 +218,194 @@ static u8 __bl_get_offset(struct backlight_device *dev)
 
 u8 backlight_get_offset(void)
 {
-    return __bl_get_offset(&g_bl_priv);
+    return g_bl_priv.ops->get_offs(&g_bl_priv);
+}
+
+static void __bl_set_min(struct backlight_device *dev, u8 min)
+{
+    dev->prof.bl_lvl_min = min;
+}
+
+static u8 __bl_get_min(struct backlight_device *dev)
+{
+    return dev->prof.bl_lvl_min;
+}
+
+static void __bl_set_max(struct backlight_device *dev, u8 max)
+{
+    dev->prof.bl_lvl_max = max;
+}
+
+static u8 __bl_get_max(struct backlight_device *dev)
+{
+    return dev->prof.bl_lvl_max;
+}
+
+/* a finished fade leaves the hardware at its target */
+static void __bl_update(struct backlight_device *dev)
+{
+    dev->bl_lvl = dev->fade.to;
+}
+
+static void __bl_fade_irq(void)
+{
+    struct backlight_device *dev = &g_bl_priv;
+    struct backlight_fade *fade = &dev->fade;
+
+    if (!dma_channel_get_irq1_status(fade->dma))
+        return;
+    dma_channel_acknowledge_irq1(fade->dma);
+
+    pwm_set_enabled(fade->pacer, false);
+    dev->ops->bl_drv_update_cb(dev);
+    fade->busy = false;
+
+    if (fade->done)
+        fade->done(fade->arg);
+}
+
+static void __bl_fade_stop(struct backlight_device *dev)
+{
+    struct backlight_fade *fade = &dev->fade;
+    u32 left;
+
+    if (!fade->busy)
+        return;
+
+    pwm_set_enabled(fade->pacer, false);
+
+    /* an abort can raise the completion irq, RP2040-E13 */
+    dma_channel_set_irq1_enabled(fade->dma, false);
+    dma_channel_abort(fade->dma);
+    dma_channel_acknowledge_irq1(fade->dma);
+    dma_channel_set_irq1_enabled(fade->dma, true);
+
+    /* wherever the ramp got to */
+    left = dma_channel_hw_addr(fade->dma)->transfer_count;
+    dev->bl_lvl = fade->from + ((int)fade->to - fade->from) * (int)(fade->steps - left) / fade->steps;
+    fade->busy = false;
+}
+
+static int __bl_fade_to(struct backlight_device *dev, u8 level, u32 duration_ms,
+                        backlight_fade_done_t done, void *arg)
+{
+    struct backlight_fade *fade = &dev->fade;
+    u8 percent = __bl_target(dev, level);
+    u32 step_ticks;
+    int32_t from_q8, delta_q8;
+    int i;
+
+    __bl_fade_stop(dev);
+
+    if (duration_ms > BL_FADE_MAX_MS)
+        duration_ms = BL_FADE_MAX_MS;
+
+    /* about 1 ms per step, which is several carrier periods */
+    fade->steps = duration_ms < BL_FADE_MAX_STEPS ? duration_ms : BL_FADE_MAX_STEPS;
+    if (fade->steps < 2 || percent == dev->bl_lvl || dev->blank) {
+        __bl_set_lvl(dev, level);
+        if (done)
+            done(arg);
+        return 0;
+    }
+
+    fade->from = dev->bl_lvl;
+    fade->to = percent;
+    fade->done = done;
+    fade->arg = arg;
+
+    /* linear in percent, the gamma table makes it linear to the eye */
+    from_q8 = fade->from << 8;
+    delta_q8 = ((int32_t)fade->to - fade->from) << 8;
+    for (i = 0; i < fade->steps; i++)
+        fade->ramp[i] = __bl_cc_word(dev, __bl_gamma_q8(dev, from_q8 + delta_q8 * (i + 1) / fade->steps));
+
+    step_ticks = (uint64_t)duration_ms * BL_FADE_PACER_HZ / 1000 / fade->steps;
+    pwm_set_wrap(fade->pacer, step_ticks - 1);
+    pwm_set_counter(fade->pacer, 0);
+
+    fade->busy = true;
+    dma_channel_set_read_addr(fade->dma, fade->ramp, false);
+    dma_channel_set_trans_count(fade->dma, fade->steps, true);
+    pwm_set_enabled(fade->pacer, true);
+
+    return 0;
+}
+
+int backlight_fade_to(u8 level, u32 duration_ms, backlight_fade_done_t done, void *arg)
+{
+    int ret;
+
+    recursive_mutex_enter_blocking(&g_bl_priv.lock);
+    ret = __bl_fade_to(&g_bl_priv, level, duration_ms, done, arg);
+    recursive_mutex_exit(&g_bl_priv.lock);
+
+    return ret;
+}
+
+int backlight_set_adaptive(u8 pct, u32 fade_ms)
+{
+    struct backlight_device *dev = &g_bl_priv;
+    int ret = -1;
+
+    recursive_mutex_enter_blocking(&dev->lock);
+
+    /* leave a fade someone asked for alone, the caller retries */
+    if (!dev->fade.busy) {
+        dev->adapt = pct > 100 ? 100 : pct;
+        ret = __bl_fade_to(dev, dev->user_lvl, fade_ms, NULL, NULL);
+    }
+
+    recursive_mutex_exit(&dev->lock);
+    return ret;
+}
+
+void backlight_set_blank(bool blank)
+{
+    struct backlight_device *dev = &g_bl_priv;
+
+    recursive_mutex_enter_blocking(&dev->lock);
+    __bl_fade_stop(dev);
+    dev->blank = blank;
+    pwm_set_gpio_level(dev->bl_pin, blank ? 0 : dev->gamma[dev->bl_lvl]);
+    recursive_mutex_exit(&dev->lock);
+}
+
+void backlight_fade_stop(void)
+{
+    recursive_mutex_enter_blocking(&g_bl_priv.lock);
+    __bl_fade_stop(&g_bl_priv);
+    recursive_mutex_exit(&g_bl_priv.lock);
+}
+
+bool backlight_fade_busy(void)
+{
+    return g_bl_priv.fade.busy;
+}
+
+static void backlight_fade_init(struct backlight_device *dev)
+{
+    struct backlight_fade *fade = &dev->fade;
+    dma_channel_config c;
+    pwm_config config;
+
+    fade->pacer = BL_FADE_PACER_SLICE;
+    config = pwm_get_default_config();
+    pwm_config_set_clkdiv_int(&config, clock_get_hz(clk_sys) / BL_FADE_PACER_HZ);
+    pwm_init(fade->pacer, &config, false);
+
+    fade->dma = dma_claim_unused_channel(true);
+    c = dma_channel_get_default_config(fade->dma);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, pwm_get_dreq(fade->pacer));
+    dma_channel_configure(fade->dma, &c, &pwm_hw->slice[dev->slice].cc, fade->ramp, 0, false);
+
+    dma_channel_set_irq1_enabled(fade->dma, true);
+    irq_add_shared_handler(BL_FADE_DMA_IRQ, __bl_fade_irq,
+                           PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(BL_FADE_DMA_IRQ, true);
 }
 
 static void backlight_hw_init(struct backlight_device *dev)
@@ -116,16 +413,35 @@ static void backlight_hw_init(struct backlight_device *dev)
     gpio_init(dev->bl_pin);
     gpio_set_function(dev->bl_pin, GPIO_FUNC_PWM);
 
-    uint slice_num = pwm_gpio_to_slice_num(dev->bl_pin);
+    dev->slice = pwm_gpio_to_slice_num(dev->bl_pin);
+    dev->chan = pwm_gpio_to_channel(dev->bl_pin);
 
     pwm_config config = pwm_get_default_config();
     // Set divider, reduces counter clock to sysclock/this value
     pwm_config_set_clkdiv(&config, 1.f);
-    pwm_init(slice_num, &config, true);
+    pwm_init(dev->slice, &config, true);
 
     pwm_set_gpio_level(dev->bl_pin, 0);
+
+    for (int i = 0; i <= 100; i++)
+        dev->gamma[i] = (u16)(powf(i / 100.f, BL_GAMMA) * 65535.f + 0.5f);
+
+    backlight_fade_init(dev);
 }
 
+static struct backlight_ops g_bl_ops = {
+    .hw_init = backlight_hw_init,
+    .set_lvl = __bl_set_lvl,
+    .get_lvl = __bl_get_lvl,
+    .set_offs = __bl_set_offset,
+    .get_offs = __bl_get_offset,
+    .set_min = __bl_set_min,
+    .get_min = __bl_get_min,
+    .set_max = __bl_set_max,
+    .get_max = __bl_get_max,
+    .bl_drv_update_cb = __bl_update,
+};
+
 struct backlight_profile avaliable_profiles[] = {
     [0] = {
         .bl_lvl_min = 0,
@@ -150,12 +466,43 @@ struct backlight_profile def_bl_profile = {
     .bl_lvl_default = BL_LVL_DEF_LVL,
 };
 
+static int backlight_cmd(int argc, char **argv)
+{
+    u8 level;
+
+    if (argc < 2) {
+        printf("level %d%%%s\n", backlight_get_level(), backlight_fade_busy() ? ", fading" : "");
+        return 0;
+    }
+
+    level = atoi(argv[1]);
+    /* kept across resets */
+    settings_set(SETTINGS_KEY_BL_LEVEL, &level, sizeof(level));
+
+    if (argc > 2)
+        return backlight_fade_to(level, strtoul(argv[2], NULL, 0), NULL, NULL);
+
+    backlight_set_level(level);
+    return 0;
+}
+
+static const struct console_cmd backlight_console_cmd = {
+    .name = "bl",
+    .help = "bl [level [fade ms]], backlight level in percent",
+    .fn = backlight_cmd,
+};
+
 void backlight_driver_init(void)
 {
     /* make default setting */
     g_bl_priv.bl_pin = LCD_PIN_BL;
+    g_bl_priv.ops = &g_bl_ops;
+    g_bl_priv.adapt = 100;
+    recursive_mutex_init(&g_bl_priv.lock);
 
     backlight_load_profile(&g_bl_priv, &def_bl_profile);
 
-    backlight_hw_init(&g_bl_priv);
-}
\ No newline at end of file
+    g_bl_priv.ops->hw_init(&g_bl_priv);
+
+    console_register(&backlight_console_cmd);
+}
@@ -0,0 +1,128 @@
+// Copyright (c) 2024 embeddedboys developers
+
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+/*
+ * Boot timeline.
+ *
+ * Each boot stage marks its end with the us timer, which counts from
+ * reset, so the first stage also covers the boot ROM, boot2 and the SDK
+ * runtime init. Stages brought up in parallel mark from both cores, each
+ * mark keeps the core it came from. The first complete frame closes the
+ * timeline; the LVGL task prints it once, the "boot" console command
+ * prints it again.
+ */
+
+#define pr_fmt(fmt) "boot: " fmt
+
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "hardware/sync.h"
+#include "hardware/timer.h"
+
+#include "boot_time.h"
+#include "console.h"
+#include "debug.h"
+
+#if BOOT_TIME_ENABLED
+
+static struct {
+    struct {
+        const char *name;
+        uint32_t us;
+        uint8_t core;
+    } stage[BOOT_TIME_MAX_STAGES];
+    spin_lock_t *lock;
+    volatile int count;
+    volatile bool frame;
+    bool reported;
+} g_boot;
+
+void boot_mark(const char *name)
+{
+    uint32_t save = 0;
+
+    /* no lock yet means we are still alone on core 0 */
+    if (g_boot.lock)
+        save = spin_lock_blocking(g_boot.lock);
+
+    if (g_boot.count < BOOT_TIME_MAX_STAGES) {
+        g_boot.stage[g_boot.count].name = name;
+        g_boot.stage[g_boot.count].us = time_us_32();
+        g_boot.stage[g_boot.count].core = get_core_num();
+        g_boot.count++;
+    }
+
+    if (g_boot.lock)
+        spin_unlock(g_boot.lock, save);
+}
+
+void boot_time_frame(void)
+{
+    if (g_boot.frame)
+        return;
+
+    boot_mark("first frame");
+    g_boot.frame = true;
+}
+
+void boot_time_dump(void)
+{
+    uint32_t prev = 0;
+
+    printf("%-16s %4s %10s %10s\n", "stage", "core", "at us", "took us");
+    for (int i = 0; i < g_boot.count; i++) {
+        printf("%-16s %4u %10lu %10lu\n", g_boot.stage[i].name, g_boot.stage[i].core,
+               g_boot.stage[i].us, g_boot.stage[i].us - prev);
+        prev = g_boot.stage[i].us;
+    }
+}
+
+void boot_time_report(void)
+{
+    if (g_boot.reported || !g_boot.frame)
+        return;
+    g_boot.reported = true;
+
+    pr_info("first frame %lu ms after reset\n", g_boot.stage[g_boot.count - 1].us / 1000);
+    boot_time_dump();
+}
+
+static int boot_time_cmd(int argc, char **argv)
+{
+    boot_time_dump();
+    return 0;
+}
+
+static const struct console_cmd boot_console_cmd = {
+    .name = "boot",
+    .help = "boot timeline, reset to first frame",
+    .fn = boot_time_cmd,
+};
+
+void boot_time_init(void)
+{
+    g_boot.lock = spin_lock_instance(spin_lock_claim_unused(true));
+    console_register(&boot_console_cmd);
+}
+
+#endif
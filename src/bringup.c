@@ -0,0 +1,118 @@
+// Copyright (c) 2024 embeddedboys developers
+
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+/*
+ * Parallel driver bring-up.
+ *
+ * Panel, backlight, touch and the LVGL UI used to come up one after the
+ * other in main() before the scheduler, with every reset and power-up
+ * delay spun on core 0. Each stage is now run at the top of the task
+ * that owns its hardware later on, so the panel init on core 1 overlaps
+ * with building the UI on core 0, and the touch controller's reset delays
+ * overlap with both. Stages that need another one first list it in their
+ * deps, an event group carries the done and failed bits across tasks.
+ */
+
+#define pr_fmt(fmt) "bringup: " fmt
+
+#include <stdio.h>
+
+#include "hardware/timer.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "event_groups.h"
+
+#include "bringup.h"
+#include "rtos_alloc.h"
+#include "boot_time.h"
+#include "debug.h"
+
+/* failed stages set their done bit and this one */
+#define BRINGUP_FAIL_SHIFT  8
+#define BRINGUP_FAIL_BIT(s) (BRINGUP_BIT(s) << BRINGUP_FAIL_SHIFT)
+
+static EventGroupHandle_t bringup_events;
+
+static struct {
+    const char *name;
+    bringup_fn_t fn;
+    uint32_t deps;
+} g_stages[BRINGUP_NR_STAGES];
+
+void bringup_register(enum bringup_stage stage, const char *name,
+                      bringup_fn_t fn, uint32_t deps)
+{
+    if (stage >= BRINGUP_NR_STAGES)
+        return;
+
+    g_stages[stage].name = name;
+    g_stages[stage].fn = fn;
+    g_stages[stage].deps = deps & ~BRINGUP_BIT(stage);
+}
+
+int bringup_wait(uint32_t mask)
+{
+    EventBits_t bits;
+
+    mask &= BRINGUP_ALL;
+    if (!mask)
+        return 0;
+
+    bits = xEventGroupWaitBits(bringup_events, mask, pdFALSE, pdTRUE, portMAX_DELAY);
+    return (bits & (mask << BRINGUP_FAIL_SHIFT)) ? -1 : 0;
+}
+
+int bringup_run(enum bringup_stage stage)
+{
+    EventBits_t set = BRINGUP_BIT(stage);
+    uint32_t t0, t1;
+    int ret = 0;
+
+    if (stage >= BRINGUP_NR_STAGES)
+        return -1;
+
+    t0 = time_us_32();
+    /* a failed dependency is logged, the stage decides what it still can do */
+    if (bringup_wait(g_stages[stage].deps))
+        pr_warn("%s: a dependency failed\n", g_stages[stage].name);
+    t1 = time_us_32();
+
+    if (g_stages[stage].fn)
+        ret = g_stages[stage].fn();
+    if (ret)
+        set |= BRINGUP_FAIL_BIT(stage);
+
+    if (g_stages[stage].name) {
+        boot_mark(g_stages[stage].name);
+        pr_info("%s %s on core%u, %lu us (waited %lu us)\n", g_stages[stage].name,
+                ret ? "failed" : "done", get_core_num(), time_us_32() - t1, t1 - t0);
+    }
+
+    xEventGroupSetBits(bringup_events, set);
+    return ret;
+}
+
+void bringup_init(void)
+{
+    rtos_event_group_create(bringup_events);
+}
@@ -0,0 +1,203 @@
+// Copyright (c) 2024 embeddedboys developers
+
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+/*
+ * Content adaptive backlight.
+ *
+ * Every flushed area is sub-sampled on a fixed CABC_STRIDE grid into a
+ * luma map of the whole screen, so partial redraws keep the rest of the
+ * picture accounted for. Every CABC_PERIOD_MS the map is histogrammed
+ * and the backlight is scaled by the 98th percentile luma: a dark UI
+ * needs less light for the same perceived contrast. Dimming fades in
+ * slowly, brightening quickly, with some hysteresis so small redraws do
+ * not make the backlight breathe. Panels that support it also get their
+ * own CABC switched to the UI mode while we dim.
+ */
+
+#define pr_fmt(fmt) "cabc: " fmt
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "hardware/timer.h"
+
+#include "lvgl/lvgl.h"
+
+#include "cabc.h"
+#include "tft.h"
+#include "backlight.h"
+#include "console.h"
+#include "debug.h"
+
+#if CABC_ENABLED
+
+#define CABC_GRID_W     ((LCD_HOR_RES + CABC_STRIDE - 1) / CABC_STRIDE)
+#define CABC_GRID_H     ((LCD_VER_RES + CABC_STRIDE - 1) / CABC_STRIDE)
+
+/* scale changes smaller than this are ignored */
+#define CABC_HYST_PCT   4
+#define CABC_DIM_MS     1000
+#define CABC_BRIGHT_MS  200
+
+static struct {
+    bool enabled;
+    bool panel_on;
+    uint32_t last_eval_us;
+    struct cabc_stats stats;
+    uint8_t luma[CABC_GRID_W * CABC_GRID_H];
+} g_cabc;
+
+static inline uint8_t cabc_luma(uint16_t c)
+{
+    uint32_t r, g, b;
+
+#if LV_COLOR_16_SWAP
+    c = (c >> 8) | (c << 8);
+#endif
+    r = (c >> 11) << 3;
+    g = ((c >> 5) & 0x3F) << 2;
+    b = (c & 0x1F) << 3;
+
+    return (77 * r + 150 * g + 29 * b) >> 8;
+}
+
+/* first grid line at or after v */
+static inline int cabc_align(int v)
+{
+    return (v + CABC_STRIDE - 1) / CABC_STRIDE * CABC_STRIDE;
+}
+
+static void cabc_evaluate(void)
+{
+    struct cabc_stats *st = &g_cabc.stats;
+    uint32_t total = CABC_GRID_W * CABC_GRID_H;
+    uint32_t acc = 0;
+    int bin, level;
+
+    memset(st->hist, 0, sizeof(st->hist));
+    for (uint32_t i = 0; i < total; i++)
+        st->hist[g_cabc.luma[i] >> 4]++;
+
+    /* the brightest 2% may be clipped, e.g. a cursor or small icons */
+    for (bin = 0; bin < CABC_HIST_BINS - 1; bin++) {
+        acc += st->hist[bin];
+        if (acc * 100 >= total * 98)
+            break;
+    }
+    st->p98 = bin * 16 + 15;
+    st->evaluations++;
+
+    level = g_cabc.enabled ? CABC_MIN_PCT + (100 - CABC_MIN_PCT) * st->p98 / 255 : 100;
+    if (level != 100 && abs(level - st->level) < CABC_HYST_PCT)
+        return;
+    if (level == st->level)
+        return;
+
+    /* a user fade is running, try again next period */
+    if (backlight_set_adaptive(level, level < st->level ? CABC_DIM_MS : CABC_BRIGHT_MS))
+        return;
+
+    pr_debug("p98 %d, backlight %d%% -> %d%%\n", st->p98, st->level, level);
+    st->level = level;
+
+    if (g_cabc.panel_on != (level < 100)) {
+        g_cabc.panel_on = level < 100;
+        tft_set_cabc(g_cabc.panel_on ? TFT_CABC_UI : TFT_CABC_OFF);
+    }
+}
+
+void cabc_account(int xs, int ys, int xe, int ye, void *vmem)
+{
+    uint16_t *px = vmem;
+    int w = xe - xs + 1;
+    uint32_t t0 = time_us_32(), cost;
+
+    for (int y = cabc_align(ys); y <= ye; y += CABC_STRIDE) {
+        uint16_t *row = px + (y - ys) * w;
+        uint8_t *grid = &g_cabc.luma[(y / CABC_STRIDE) * CABC_GRID_W];
+
+        for (int x = cabc_align(xs); x <= xe; x += CABC_STRIDE)
+            grid[x / CABC_STRIDE] = cabc_luma(row[x - xs]);
+    }
+
+    cost = time_us_32() - t0;
+    g_cabc.stats.cost_us = cost;
+    if (cost > g_cabc.stats.cost_max_us)
+        g_cabc.stats.cost_max_us = cost;
+
+    if (t0 - g_cabc.last_eval_us >= CABC_PERIOD_MS * 1000) {
+        g_cabc.last_eval_us = t0;
+        cabc_evaluate();
+    }
+}
+
+void cabc_get_stats(struct cabc_stats *stats)
+{
+    *stats = g_cabc.stats;
+}
+
+static int cabc_cmd(int argc, char **argv)
+{
+    struct cabc_stats st;
+
+    if (argc > 1) {
+        if (!strcmp(argv[1], "on"))
+            g_cabc.enabled = true;
+        else if (!strcmp(argv[1], "off"))
+            g_cabc.enabled = false;
+        else
+            return -1;
+        /* re-evaluated by the next flush */
+        return 0;
+    }
+
+    cabc_get_stats(&st);
+    printf("%s, p98 luma %d, backlight scale %d%%, panel cabc %s\n",
+           g_cabc.enabled ? "on" : "off", st.p98, st.level, g_cabc.panel_on ? "ui" : "off");
+    printf("accounting %lu us, max %lu us, %lu evaluations\n",
+           st.cost_us, st.cost_max_us, st.evaluations);
+    for (int i = 0; i < CABC_HIST_BINS; i++)
+        printf("  %3d..%3d %6lu\n", i * 16, i * 16 + 15, st.hist[i]);
+
+    return 0;
+}
+
+static const struct console_cmd cabc_console_cmd = {
+    .name = "cabc",
+    .help = "cabc [on|off], content adaptive backlight stats",
+    .fn = cabc_cmd,
+};
+
+void cabc_init(void)
+{
+    /* white until the first frames are accounted, i.e. no dimming */
+    memset(g_cabc.luma, 0xFF, sizeof(g_cabc.luma));
+    g_cabc.stats.level = 100;
+    g_cabc.enabled = true;
+
+    console_register(&cabc_console_cmd);
+    pr_info("%dx%d luma grid, %d bytes\n", CABC_GRID_W, CABC_GRID_H, (int)sizeof(g_cabc.luma));
+}
+
+#endif
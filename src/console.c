@@ -0,0 +1,150 @@
+// Copyright (c) 2024 embeddedboys developers
+
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+/*
+ * Tiny line based command console on the stdio UART.
+ *
+ * Modules register their commands with console_register() during init,
+ * a low priority task polls the UART and dispatches complete lines.
+ */
+
+#define pr_fmt(fmt) "console: " fmt
+
+#include <stdio.h>
+#include <string.h>
+
+#include "pico/stdlib.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "rtos_alloc.h"
+#include "console.h"
+#include "debug.h"
+
+#define CONSOLE_POLL_MS     20
+#define CONSOLE_PROMPT      "> "
+
+static const struct console_cmd *g_cmds[CONSOLE_MAX_CMDS];
+static int g_nr_cmds;
+
+int console_register(const struct console_cmd *cmd)
+{
+    if (g_nr_cmds >= CONSOLE_MAX_CMDS) {
+        pr_error("no room for command %s\n", cmd->name);
+        return -1;
+    }
+
+    g_cmds[g_nr_cmds++] = cmd;
+    return 0;
+}
+
+static int console_help(int argc, char **argv)
+{
+    for (int i = 0; i < g_nr_cmds; i++)
+        printf("  %-10s %s\n", g_cmds[i]->name, g_cmds[i]->help);
+    return 0;
+}
+
+static const struct console_cmd help_cmd = {
+    .name = "help",
+    .help = "list commands",
+    .fn = console_help,
+};
+
+int console_exec(char *line)
+{
+    char *argv[CONSOLE_MAX_ARGS];
+    int argc = 0;
+    char *p = line;
+
+    while (*p && argc < CONSOLE_MAX_ARGS) {
+        while (*p == ' ' || *p == '\t')
+            *p++ = '\0';
+        if (!*p)
+            break;
+        argv[argc++] = p;
+        while (*p && *p != ' ' && *p != '\t')
+            p++;
+    }
+
+    if (!argc)
+        return 0;
+
+    for (int i = 0; i < g_nr_cmds; i++) {
+        if (!strcmp(argv[0], g_cmds[i]->name))
+            return g_cmds[i]->fn(argc, argv);
+    }
+
+    printf("unknown command: %s, try 'help'\n", argv[0]);
+    return -1;
+}
+
+static portTASK_FUNCTION(console_task, pvParameters)
+{
+    char line[CONSOLE_LINE_LEN];
+    int len = 0;
+    int c, prev = 0;
+
+    printf(CONSOLE_PROMPT);
+
+    for (;;) {
+        c = getchar_timeout_us(0);
+        if (c == PICO_ERROR_TIMEOUT) {
+            vTaskDelay(pdMS_TO_TICKS(CONSOLE_POLL_MS));
+            continue;
+        }
+
+        /* treat "\r\n" as one line end */
+        if (c == '\n' && prev == '\r') {
+            prev = c;
+            continue;
+        }
+        prev = c;
+
+        if (c == '\r' || c == '\n') {
+            printf("\n");
+            line[len] = '\0';
+            console_exec(line);
+            len = 0;
+            printf(CONSOLE_PROMPT);
+        } else if (c == '\b' || c == 0x7f) {
+            if (len) {
+                len--;
+                printf("\b \b");
+            }
+        } else if (c >= ' ' && len < CONSOLE_LINE_LEN - 1) {
+            line[len++] = (char)c;
+            putchar(c);
+        }
+    }
+
+    vTaskDelete(NULL);
+}
+
+void console_init(void)
+{
+    TaskHandle_t console_handle;
+
+    console_register(&help_cmd);
+
+    rtos_task_create(console_task, "console", 512, NULL, (tskIDLE_PRIORITY + 1), &console_handle);
+}
@@ -0,0 +1,529 @@
+// Copyright (c) 2024 embeddedboys developers
+
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+/*
+ * Decoded image and glyph bitmap cache.
+ *
+ * Images that can't be drawn straight from flash (indexed, alpha-only or
+ * file based sources) are decoded line by line by LVGL on every redraw.
+ * With this cache they are decoded once into a TRUE_COLOR(_ALPHA) buffer
+ * and handed back to LVGL as `img_data`. Glyph bitmaps of wrapped fonts are
+ * copied into SRAM so repeated labels don't go through the XIP cache.
+ *
+ * Entries are found by a hash of their source and confirmed against the
+ * source itself, so a hash collision is a miss rather than someone else's
+ * pixels. All entries share a single byte budget (LV_DECODE_CACHE_SIZE)
+ * and are evicted in LRU order. Only the LVGL task touches the cache, so no locking.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "lvgl/lvgl.h"
+
+#include "decode_cache.h"
+#include "debug.h"
+
+#ifndef LV_DECODE_CACHE_SIZE
+#define LV_DECODE_CACHE_SIZE 0
+#endif
+
+#define DECODE_CACHE_HASH_SIZE 32
+
+enum {
+    DECODE_CACHE_TAG_IMG = 1,
+    DECODE_CACHE_TAG_GLYPH,
+};
+
+/* what an entry was decoded from */
+struct decode_cache_id {
+    const void *src;    /* image descriptor, file path or the original font */
+    uint32_t   arg;     /* recolour of alpha-only images, glyph letter */
+    bool       path;    /* src is a path, compared by content */
+};
+
+struct decode_cache_entry {
+    uint32_t key;
+    uint8_t  tag;
+    struct decode_cache_id id;  /* a path points behind the data */
+    uint16_t refcnt;    /* > 0 while LVGL holds the decoded image open */
+
+    void     *data;
+    uint32_t size;
+
+    /* LRU list, head is the most recently used */
+    struct decode_cache_entry *prev;
+    struct decode_cache_entry *next;
+
+    /* hash bucket chain, also free list link */
+    struct decode_cache_entry *hnext;
+};
+
+struct decode_cache_font_wrap {
+    lv_font_t       font;   /* handed to LVGL, must be the first member */
+    const lv_font_t *orig;
+};
+
+static struct {
+    struct decode_cache_entry entries[DECODE_CACHE_MAX_ENTRIES];
+    struct decode_cache_entry *buckets[DECODE_CACHE_HASH_SIZE];
+    struct decode_cache_entry *free_list;
+
+    struct decode_cache_entry *lru_head;
+    struct decode_cache_entry *lru_tail;
+
+    struct decode_cache_font_wrap fonts[DECODE_CACHE_MAX_FONTS];
+    int nr_fonts;
+
+    lv_img_decoder_t *decoder;
+    struct decode_cache_stats stats;
+    bool initialized;
+} g_dcache;
+
+static uint32_t fnv1a(uint32_t h, const void *data, size_t len)
+{
+    const uint8_t *p = data;
+
+    while (len--) {
+        h ^= *p++;
+        h *= 16777619u;
+    }
+
+    return h;
+}
+
+#define FNV1A_INIT 2166136261u
+
+/* ----------------------------- LRU core ---------------------------------- */
+
+static void lru_unlink(struct decode_cache_entry *e)
+{
+    if (e->prev)
+        e->prev->next = e->next;
+    else
+        g_dcache.lru_head = e->next;
+
+    if (e->next)
+        e->next->prev = e->prev;
+    else
+        g_dcache.lru_tail = e->prev;
+
+    e->prev = e->next = NULL;
+}
+
+static void lru_push_head(struct decode_cache_entry *e)
+{
+    e->prev = NULL;
+    e->next = g_dcache.lru_head;
+
+    if (g_dcache.lru_head)
+        g_dcache.lru_head->prev = e;
+    else
+        g_dcache.lru_tail = e;
+
+    g_dcache.lru_head = e;
+}
+
+static bool dcache_id_match(const struct decode_cache_id *a, const struct decode_cache_id *b)
+{
+    if (a->arg != b->arg || a->path != b->path)
+        return false;
+
+    return a->path ? !strcmp(a->src, b->src) : a->src == b->src;
+}
+
+static struct decode_cache_entry *dcache_lookup(uint32_t key, uint8_t tag,
+                                                const struct decode_cache_id *id)
+{
+    struct decode_cache_entry *e = g_dcache.buckets[key % DECODE_CACHE_HASH_SIZE];
+
+    for (; e; e = e->hnext) {
+        if (e->key == key && e->tag == tag && dcache_id_match(&e->id, id)) {
+            if (e != g_dcache.lru_head) {
+                lru_unlink(e);
+                lru_push_head(e);
+            }
+            g_dcache.stats.hits++;
+            return e;
+        }
+    }
+
+    g_dcache.stats.misses++;
+    return NULL;
+}
+
+static void dcache_remove(struct decode_cache_entry *e)
+{
+    struct decode_cache_entry **pp = &g_dcache.buckets[e->key % DECODE_CACHE_HASH_SIZE];
+
+    while (*pp && *pp != e)
+        pp = &(*pp)->hnext;
+    if (*pp)
+        *pp = e->hnext;
+
+    lru_unlink(e);
+
+    lv_mem_free(e->data);
+    g_dcache.stats.used -= e->size;
+    g_dcache.stats.entries--;
+
+    e->data = NULL;
+    e->hnext = g_dcache.free_list;
+    g_dcache.free_list = e;
+}
+
+static bool dcache_evict_one(void)
+{
+    struct decode_cache_entry *e;
+
+    for (e = g_dcache.lru_tail; e; e = e->prev) {
+        if (!e->refcnt) {
+            dcache_remove(e);
+            g_dcache.stats.evictions++;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* evict unpinned entries from the tail until `size` more bytes fit */
+static bool dcache_make_room(uint32_t size)
+{
+    while (g_dcache.stats.used + size > g_dcache.stats.budget || !g_dcache.free_list)
+        if (!dcache_evict_one())
+            return false;
+
+    return true;
+}
+
+static struct decode_cache_entry *dcache_insert(uint32_t key, uint8_t tag,
+                                                const struct decode_cache_id *id,
+                                                uint32_t size)
+{
+    struct decode_cache_entry *e;
+    uint32_t total = size;
+    void *data;
+
+    /* the caller's path may not outlive the entry, keep a copy behind the data */
+    if (id->path)
+        total += strlen(id->src) + 1;
+
+    if (!size || total > g_dcache.stats.budget || !dcache_make_room(total))
+        goto err_insert;
+
+    data = lv_mem_alloc(total);
+    /* LVGL heap may be tighter than our budget, give it back some room */
+    while (!data && dcache_evict_one())
+        data = lv_mem_alloc(total);
+    if (!data)
+        goto err_insert;
+
+    e = g_dcache.free_list;
+    g_dcache.free_list = e->hnext;
+
+    e->key = key;
+    e->tag = tag;
+    e->id = *id;
+    if (id->path)
+        e->id.src = strcpy((char *)data + size, id->src);
+    e->refcnt = 0;
+    e->data = data;
+    e->size = total;
+
+    e->hnext = g_dcache.buckets[key % DECODE_CACHE_HASH_SIZE];
+    g_dcache.buckets[key % DECODE_CACHE_HASH_SIZE] = e;
+    lru_push_head(e);
+
+    g_dcache.stats.used += total;
+    g_dcache.stats.entries++;
+    if (g_dcache.stats.used > g_dcache.stats.peak)
+        g_dcache.stats.peak = g_dcache.stats.used;
+
+    return e;
+
+err_insert:
+    g_dcache.stats.insert_fails++;
+    return NULL;
+}
+
+static bool dcache_owns(void *p)
+{
+    return (struct decode_cache_entry *)p >= &g_dcache.entries[0] &&
+           (struct decode_cache_entry *)p < &g_dcache.entries[DECODE_CACHE_MAX_ENTRIES];
+}
+
+/* ---------------------------- Image decoder ------------------------------ */
+
+static bool dcache_img_cf_cacheable(lv_img_cf_t cf)
+{
+    switch (cf) {
+    case LV_IMG_CF_TRUE_COLOR:
+    case LV_IMG_CF_TRUE_COLOR_ALPHA:
+    case LV_IMG_CF_TRUE_COLOR_CHROMA_KEYED:
+    case LV_IMG_CF_INDEXED_1BIT:
+    case LV_IMG_CF_INDEXED_2BIT:
+    case LV_IMG_CF_INDEXED_4BIT:
+    case LV_IMG_CF_INDEXED_8BIT:
+    case LV_IMG_CF_ALPHA_1BIT:
+    case LV_IMG_CF_ALPHA_2BIT:
+    case LV_IMG_CF_ALPHA_4BIT:
+    case LV_IMG_CF_ALPHA_8BIT:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static uint32_t dcache_img_key(lv_img_decoder_dsc_t *dsc, struct decode_cache_id *id)
+{
+    uint32_t h = FNV1A_INIT;
+    lv_img_cf_t cf = dsc->header.cf;
+
+    id->src = dsc->src;
+    id->path = dsc->src_type == LV_IMG_SRC_FILE;
+    id->arg = 0;
+
+    if (id->path)
+        h = fnv1a(h, dsc->src, strlen(dsc->src));
+    else
+        h = fnv1a(h, &dsc->src, sizeof(dsc->src));
+
+    /* alpha-only images are recoloured while decoding */
+    if (cf >= LV_IMG_CF_ALPHA_1BIT && cf <= LV_IMG_CF_ALPHA_8BIT) {
+        id->arg = lv_color_to32(dsc->color);
+        h = fnv1a(h, &dsc->color, sizeof(dsc->color));
+    }
+
+    return h;
+}
+
+static void dcache_img_attach(lv_img_decoder_dsc_t *dsc, struct decode_cache_entry *e)
+{
+    /* line decoding converts every format with alpha to TRUE_COLOR_ALPHA */
+    if (lv_img_cf_has_alpha(dsc->header.cf))
+        dsc->header.cf = LV_IMG_CF_TRUE_COLOR_ALPHA;
+
+    e->refcnt++;
+    dsc->img_data = e->data;
+    dsc->user_data = e;
+}
+
+static lv_res_t dcache_img_open(lv_img_decoder_t *decoder, lv_img_decoder_dsc_t *dsc)
+{
+    struct decode_cache_entry *e;
+    struct decode_cache_id id;
+    lv_img_cf_t cf = dsc->header.cf;
+    uint32_t key, px_size, stride;
+    lv_res_t res;
+
+    if (dsc->src_type != LV_IMG_SRC_VARIABLE && dsc->src_type != LV_IMG_SRC_FILE)
+        return LV_RES_INV;
+
+    key = dcache_img_key(dsc, &id);
+    e = dcache_lookup(key, DECODE_CACHE_TAG_IMG, &id);
+    if (e) {
+        dcache_img_attach(dsc, e);
+        return LV_RES_OK;
+    }
+
+    res = lv_img_decoder_built_in_open(decoder, dsc);
+    /* already directly drawable (e.g. true color in flash), nothing to cache */
+    if (res != LV_RES_OK || dsc->img_data || !dcache_img_cf_cacheable(cf))
+        return res;
+
+    px_size = lv_img_cf_has_alpha(cf) ? LV_IMG_PX_SIZE_ALPHA_BYTE : sizeof(lv_color_t);
+    stride = dsc->header.w * px_size;
+
+    e = dcache_insert(key, DECODE_CACHE_TAG_IMG, &id, stride * dsc->header.h);
+    if (!e)
+        return res;     /* fall back to line by line decoding */
+
+    for (lv_coord_t y = 0; y < dsc->header.h; y++) {
+        res = lv_img_decoder_built_in_read_line(decoder, dsc, 0, y, dsc->header.w,
+                                                (uint8_t *)e->data + y * stride);
+        if (res != LV_RES_OK) {
+            pr_debug("decode_cache: line %d decode failed\n", y);
+            dcache_remove(e);
+            return LV_RES_OK;
+        }
+    }
+
+    /* the decoded copy replaces the built-in decoder's state */
+    lv_img_decoder_built_in_close(decoder, dsc);
+    dcache_img_attach(dsc, e);
+
+    return LV_RES_OK;
+}
+
+static lv_res_t dcache_img_read_line(lv_img_decoder_t *decoder, lv_img_decoder_dsc_t *dsc,
+                                     lv_coord_t x, lv_coord_t y, lv_coord_t len, uint8_t *buf)
+{
+    /* only reached when the image wasn't cached */
+    return lv_img_decoder_built_in_read_line(decoder, dsc, x, y, len, buf);
+}
+
+static void dcache_img_close(lv_img_decoder_t *decoder, lv_img_decoder_dsc_t *dsc)
+{
+    struct decode_cache_entry *e = dsc->user_data;
+
+    if (dcache_owns(e)) {
+        if (e->refcnt)
+            e->refcnt--;
+        dsc->user_data = NULL;
+        return;
+    }
+
+    lv_img_decoder_built_in_close(decoder, dsc);
+}
+
+/* ----------------------------- Glyph cache ------------------------------- */
+
+static const uint8_t *dcache_get_glyph_bitmap(const lv_font_t *font, uint32_t letter)
+{
+    const struct decode_cache_font_wrap *wrap = (const struct decode_cache_font_wrap *)font;
+    const lv_font_t *orig = wrap->orig;
+    const struct decode_cache_id id = { .src = orig, .arg = letter };
+    struct decode_cache_entry *e;
+    lv_font_glyph_dsc_t g;
+    const uint8_t *bitmap;
+    uint32_t key, bpp, size;
+
+    key = fnv1a(FNV1A_INIT, &orig, sizeof(orig));
+    key = fnv1a(key, &letter, sizeof(letter));
+
+    e = dcache_lookup(key, DECODE_CACHE_TAG_GLYPH, &id);
+    if (e)
+        return e->data;
+
+    bitmap = orig->get_glyph_bitmap(orig, letter);
+    if (!bitmap || !orig->get_glyph_dsc(orig, &g, letter, 0))
+        return bitmap;
+
+    /* 3 bpp glyphs are upscaled to 4 bpp when decompressed */
+    bpp = g.bpp == 3 ? 4 : g.bpp;
+    /* fmt_txt bitmaps are packed, rows are not byte aligned */
+    size = (g.box_w * g.box_h * bpp + 7) / 8;
+
+    e = dcache_insert(key, DECODE_CACHE_TAG_GLYPH, &id, size);
+    if (!e)
+        return bitmap;
+
+    memcpy(e->data, bitmap, size);
+    return e->data;
+}
+
+/**
+ * Return a font that behaves like @font but keeps its glyph bitmaps in
+ * the cache. The same wrapper is returned for repeated calls, and for a
+ * font that already is one.
+ */
+const lv_font_t *decode_cache_font(const lv_font_t *font)
+{
+    struct decode_cache_font_wrap *wrap;
+
+    if (!font || !g_dcache.initialized || !g_dcache.stats.budget)
+        return font;
+
+    for (int i = 0; i < g_dcache.nr_fonts; i++) {
+        if (font == &g_dcache.fonts[i].font)
+            return font;
+        if (g_dcache.fonts[i].orig == font)
+            return &g_dcache.fonts[i].font;
+    }
+
+    if (g_dcache.nr_fonts >= DECODE_CACHE_MAX_FONTS) {
+        pr_warn("decode_cache: too many fonts, %p not cached\n", font);
+        return font;
+    }
+
+    wrap = &g_dcache.fonts[g_dcache.nr_fonts++];
+    memcpy(&wrap->font, font, sizeof(lv_font_t));
+    wrap->font.get_glyph_bitmap = dcache_get_glyph_bitmap;
+    wrap->orig = font;
+
+    return &wrap->font;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* drop every unpinned entry, e.g. after a screen with big images is gone */
+void decode_cache_flush(void)
+{
+    struct decode_cache_entry *e = g_dcache.lru_tail;
+    struct decode_cache_entry *prev;
+
+    while (e) {
+        prev = e->prev;
+        if (!e->refcnt)
+            dcache_remove(e);
+        e = prev;
+    }
+}
+
+void decode_cache_get_stats(struct decode_cache_stats *stats)
+{
+    memcpy(stats, &g_dcache.stats, sizeof(*stats));
+}
+
+void decode_cache_dump(void)
+{
+    struct decode_cache_stats *s = &g_dcache.stats;
+    uint32_t lookups = s->hits + s->misses;
+
+    printf("decode cache: %lu/%lu bytes (peak %lu), %lu entries\n",
+           s->used, s->budget, s->peak, s->entries);
+    printf("  hits %lu, misses %lu (%lu%% hit), evictions %lu, insert fails %lu\n",
+           s->hits, s->misses, lookups ? s->hits * 100 / lookups : 0,
+           s->evictions, s->insert_fails);
+}
+
+int decode_cache_init(void)
+{
+    memset(&g_dcache, 0, sizeof(g_dcache));
+
+    g_dcache.stats.budget = LV_DECODE_CACHE_SIZE;
+    if (!g_dcache.stats.budget) {
+        pr_info("decode cache disabled\n");
+        return 0;
+    }
+
+    for (int i = 0; i < DECODE_CACHE_MAX_ENTRIES; i++) {
+        g_dcache.entries[i].hnext = g_dcache.free_list;
+        g_dcache.free_list = &g_dcache.entries[i];
+    }
+
+    g_dcache.decoder = lv_img_decoder_create();
+    if (!g_dcache.decoder) {
+        pr_error("decode_cache: failed to create image decoder\n");
+        return -1;
+    }
+
+    lv_img_decoder_set_info_cb(g_dcache.decoder, lv_img_decoder_built_in_info);
+    lv_img_decoder_set_open_cb(g_dcache.decoder, dcache_img_open);
+    lv_img_decoder_set_read_line_cb(g_dcache.decoder, dcache_img_read_line);
+    lv_img_decoder_set_close_cb(g_dcache.decoder, dcache_img_close);
+
+    g_dcache.initialized = true;
+    pr_info("decode cache budget : %lu bytes\n", g_dcache.stats.budget);
+
+    return 0;
+}
@@ -0,0 +1,396 @@
+// Copyright (c) 2024 embeddedboys developers
+
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+/*
+ * Display power states.
+ *
+ * An LVGL timer follows the UI inactivity time and moves the panel down
+ * through idle colour mode, partial mode and sleep, each after its own
+ * timeout. The timer is re-armed for the next timeout only, and paused in
+ * the deepest state, so a static screen costs no wake-ups. A touch brings
+ * the panel back to active; a touch on a panel that was not fully visible
+ * only wakes it.
+ *
+ * The register writes are queued to the flush task so they are ordered
+ * with the frames on the bus. While asleep disp_flush() drops frames and
+ * the whole screen is redrawn on wake; the backlight comes back with the
+ * first frame. Wake to visible is measured; when waking from sleep in
+ * misses the target (the panel's sleep out delay plus a frame), sleep in
+ * is replaced by display off, which wakes within a frame.
+ */
+
+#define pr_fmt(fmt) "disp_power: " fmt
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "hardware/timer.h"
+
+#include "lvgl/lvgl.h"
+#include "porting/lv_port_disp_template.h"
+#include "porting/lv_port_os.h"
+
+#include "disp_power.h"
+#include "tft.h"
+#include "backlight.h"
+#include "console.h"
+#include "debug.h"
+
+#if DISP_POWER_ENABLED
+
+#ifndef DISP_POWER_WAKE_TARGET_MS
+#define DISP_POWER_WAKE_TARGET_MS   150
+#endif
+
+static const char *const disp_power_names[DISP_POWER_NR_STATES] = {
+    [DISP_POWER_ACTIVE]  = "active",
+    [DISP_POWER_IDLE]    = "idle",
+    [DISP_POWER_PARTIAL] = "partial",
+    [DISP_POWER_SLEEP]   = "sleep",
+};
+
+static struct {
+    struct disp_power_cfg cfg;
+    struct disp_power_stats stats;
+    lv_timer_t *timer;
+
+    /* LVGL task */
+    enum disp_power_state state;
+
+    /* flush task */
+    enum disp_power_state panel;
+    bool panel_sleep_in;        /* the panel is in sleep in, not just off */
+    bool panel_idle;            /* kept through sleep, the panel retains them */
+    bool panel_partial;
+
+    /* false once a wake from sleep in missed the target */
+    volatile bool sleep_in;
+    bool wake_checked;
+
+    /* wake to first frame, set by the LVGL task, completed by the flush task */
+    volatile bool measuring;
+    enum disp_power_state woke_from;
+    uint32_t wake_at;
+} g_dp = {
+    .cfg = {
+        .timeout_ms = {
+            [DISP_POWER_IDLE]    = 30000,
+            [DISP_POWER_SLEEP]   = 60000,
+        },
+        .partial_ys = 1,
+        .partial_ye = 0,
+        .wake_target_ms = DISP_POWER_WAKE_TARGET_MS,
+    },
+    .sleep_in = true,
+};
+
+static bool disp_power_usable(enum disp_power_state s)
+{
+    if (!g_dp.cfg.timeout_ms[s])
+        return false;
+    if (s == DISP_POWER_PARTIAL && g_dp.cfg.partial_ys > g_dp.cfg.partial_ye)
+        return false;
+    return true;
+}
+
+/* flush task, the woken panel shows the whole frame again */
+static void disp_power_wake_done(void)
+{
+    enum disp_power_state from = g_dp.woke_from;
+    uint32_t lat;
+
+    g_dp.measuring = false;
+
+    lat = time_us_32() - g_dp.wake_at;
+    g_dp.stats.wake_last_us[from] = lat;
+    if (lat > g_dp.stats.wake_max_us[from])
+        g_dp.stats.wake_max_us[from] = lat;
+
+    if (lat > g_dp.cfg.wake_target_ms * 1000) {
+        g_dp.stats.over_target++;
+        if (from == DISP_POWER_SLEEP && g_dp.panel_sleep_in) {
+            g_dp.sleep_in = false;
+            pr_warn("wake took %lu us, over the %lu ms target, display off instead of sleep in\n",
+                    lat, g_dp.cfg.wake_target_ms);
+        }
+    }
+}
+
+/* flush task, walks the panel from its state to the target */
+static void disp_power_apply(void *arg)
+{
+    enum disp_power_state to = (enum disp_power_state)(intptr_t)arg;
+    enum disp_power_state from = g_dp.panel;
+    bool idle = to == DISP_POWER_IDLE || to == DISP_POWER_PARTIAL;
+    bool partial = to == DISP_POWER_PARTIAL;
+
+    if (to == from)
+        goto out_wake;
+
+    if (from == DISP_POWER_SLEEP) {
+        if (g_dp.panel_sleep_in)
+            tft_set_sleep(false);
+        else
+            tft_set_display(true);
+        /* the backlight follows with the first frame */
+    }
+
+    if (to == DISP_POWER_SLEEP) {
+        backlight_set_blank(true);
+        g_dp.panel_sleep_in = g_dp.sleep_in;
+        if (g_dp.panel_sleep_in)
+            tft_set_sleep(true);
+        else
+            tft_set_display(false);
+        g_dp.panel = to;
+        return;
+    }
+
+    if (idle != g_dp.panel_idle) {
+        tft_set_idle(idle);
+        g_dp.panel_idle = idle;
+    }
+    if (partial != g_dp.panel_partial) {
+        if (partial)
+            tft_set_partial(g_dp.cfg.partial_ys, g_dp.cfg.partial_ye);
+        else
+            tft_set_partial(1, 0);
+        g_dp.panel_partial = partial;
+    }
+
+    g_dp.panel = to;
+
+out_wake:
+    /*
+     * Idle and partial mode keep the frame on the panel, it is whole again
+     * once the commands above are out; nothing is redrawn to wait for.
+     */
+    if (to == DISP_POWER_ACTIVE && g_dp.measuring && g_dp.woke_from != DISP_POWER_SLEEP)
+        disp_power_wake_done();
+}
+
+/* LVGL task */
+static void disp_power_enter(enum disp_power_state to)
+{
+    enum disp_power_state from = g_dp.state;
+
+    if (to == from)
+        return;
+
+    pr_debug("%s -> %s\n", disp_power_names[from], disp_power_names[to]);
+    g_dp.state = to;
+    g_dp.stats.entered[to]++;
+
+    if (to == DISP_POWER_SLEEP) {
+        /* frames queued before still go out, later ones are dropped */
+        disp_disable_update();
+        tft_async_call(disp_power_apply, (void *)(intptr_t)to);
+        return;
+    }
+
+    /* armed before the flush task can get to the apply */
+    if (to == DISP_POWER_ACTIVE) {
+        g_dp.woke_from = from;
+        g_dp.wake_at = time_us_32();
+        g_dp.measuring = true;
+    }
+
+    tft_async_call(disp_power_apply, (void *)(intptr_t)to);
+
+    if (to == DISP_POWER_ACTIVE) {
+        if (from == DISP_POWER_SLEEP) {
+            disp_enable_update();
+            /* what LVGL drew meanwhile never reached the panel */
+            lv_obj_invalidate(lv_scr_act());
+        }
+    }
+}
+
+/* the next timeout after the current state, 0 if none */
+static uint32_t disp_power_next_ms(void)
+{
+    for (int s = g_dp.state + 1; s < DISP_POWER_NR_STATES; s++)
+        if (disp_power_usable(s))
+            return g_dp.cfg.timeout_ms[s];
+    return 0;
+}
+
+static void disp_power_timer_cb(lv_timer_t *timer)
+{
+    uint32_t inactive = lv_disp_get_inactive_time(NULL);
+    enum disp_power_state to = g_dp.state;
+    uint32_t next;
+
+    /* the panel comes up in parallel with the UI, it is up by the first run */
+    if (!g_dp.wake_checked) {
+        /* a panel slower than the target only ever gets switched off */
+        g_dp.sleep_in = tft_get_wake_ms() < g_dp.cfg.wake_target_ms;
+        g_dp.wake_checked = true;
+    }
+
+    for (int s = g_dp.state + 1; s < DISP_POWER_NR_STATES; s++)
+        if (disp_power_usable(s) && inactive >= g_dp.cfg.timeout_ms[s])
+            to = s;
+    disp_power_enter(to);
+
+    next = disp_power_next_ms();
+    if (!next) {
+        /* deepest state, disp_power_wake() resumes */
+        lv_timer_pause(timer);
+        return;
+    }
+
+    lv_timer_set_period(timer, next > inactive ? next - inactive : 1);
+    lv_timer_reset(timer);
+}
+
+static void disp_power_rearm(void)
+{
+    lv_timer_set_period(g_dp.timer, 1);
+    lv_timer_reset(g_dp.timer);
+    lv_timer_resume(g_dp.timer);
+}
+
+bool disp_power_wake(void)
+{
+    enum disp_power_state from = g_dp.state;
+
+    if (from == DISP_POWER_ACTIVE)
+        return false;
+
+    lv_disp_trig_activity(NULL);
+    disp_power_enter(DISP_POWER_ACTIVE);
+    disp_power_rearm();
+
+    return from >= DISP_POWER_PARTIAL;
+}
+
+void disp_power_frame_flushed(void)
+{
+    /* only a wake from sleep waits for the redraw, see disp_power_apply() */
+    if (!g_dp.measuring || g_dp.woke_from != DISP_POWER_SLEEP)
+        return;
+
+    backlight_set_blank(false);
+    disp_power_wake_done();
+}
+
+enum disp_power_state disp_power_get_state(void)
+{
+    return g_dp.state;
+}
+
+void disp_power_set_cfg(const struct disp_power_cfg *cfg)
+{
+    g_dp.cfg = *cfg;
+    g_dp.cfg.timeout_ms[DISP_POWER_ACTIVE] = 0;
+    g_dp.sleep_in = tft_get_wake_ms() < g_dp.cfg.wake_target_ms;
+
+    /* the new timeouts count from now */
+    disp_power_wake();
+    disp_power_rearm();
+}
+
+void disp_power_get_cfg(struct disp_power_cfg *cfg)
+{
+    *cfg = g_dp.cfg;
+}
+
+void disp_power_get_stats(struct disp_power_stats *stats)
+{
+    *stats = g_dp.stats;
+}
+
+static void disp_power_cfg_cb(void *arg)
+{
+    disp_power_set_cfg(arg);
+}
+
+static void disp_power_force_cb(void *arg)
+{
+    enum disp_power_state to = (enum disp_power_state)(intptr_t)arg;
+
+    if (to == DISP_POWER_ACTIVE) {
+        disp_power_wake();
+        return;
+    }
+
+    disp_power_enter(to);
+    disp_power_rearm();
+}
+
+static int disp_power_cmd(int argc, char **argv)
+{
+    static struct disp_power_cfg cfg;
+    struct disp_power_stats st;
+
+    if (argc > 1) {
+        disp_power_get_cfg(&cfg);
+
+        if (!strcmp(argv[1], "timeout") && argc > 4) {
+            for (int s = DISP_POWER_IDLE; s < DISP_POWER_NR_STATES; s++)
+                cfg.timeout_ms[s] = strtoul(argv[s + 1], NULL, 0);
+        } else if (!strcmp(argv[1], "rows") && argc > 3) {
+            cfg.partial_ys = atoi(argv[2]);
+            cfg.partial_ye = atoi(argv[3]);
+        } else if (!strcmp(argv[1], "target") && argc > 2) {
+            cfg.wake_target_ms = strtoul(argv[2], NULL, 0);
+        } else {
+            for (int s = 0; s < DISP_POWER_NR_STATES; s++)
+                if (!strcmp(argv[1], disp_power_names[s]))
+                    return lv_port_call(disp_power_force_cb, (void *)(intptr_t)s);
+            return -1;
+        }
+
+        return lv_port_call(disp_power_cfg_cb, &cfg);
+    }
+
+    disp_power_get_stats(&st);
+    printf("state %s, panel wakes in %lu ms, %s\n", disp_power_names[g_dp.state],
+           tft_get_wake_ms(), g_dp.sleep_in ? "sleep in" : "display off only");
+    printf("partial rows %d..%d, wake target %lu ms, %lu over\n",
+           g_dp.cfg.partial_ys, g_dp.cfg.partial_ye, g_dp.cfg.wake_target_ms, st.over_target);
+    for (int s = DISP_POWER_IDLE; s < DISP_POWER_NR_STATES; s++)
+        printf("  %-8s after %6lu ms, entered %lu, wake last %lu us, max %lu us\n",
+               disp_power_names[s], g_dp.cfg.timeout_ms[s], st.entered[s],
+               st.wake_last_us[s], st.wake_max_us[s]);
+
+    return 0;
+}
+
+static const struct console_cmd disp_power_console_cmd = {
+    .name = "dpm",
+    .help = "dpm [active|idle|partial|sleep|timeout idle partial sleep|rows ys ye|target ms]",
+    .fn = disp_power_cmd,
+};
+
+void disp_power_init(void)
+{
+    /* the first run works out the real period */
+    g_dp.timer = lv_timer_create(disp_power_timer_cb, 1, NULL);
+
+    console_register(&disp_power_console_cmd);
+}
+
+#endif
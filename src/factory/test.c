@@ -33,6 +33,7 @@
 #include "lvgl/demos/lv_demos.h"
 
 #include "backlight.h"
+#include "decode_cache.h"
 #include "tools.h"
 
 #define LV_PRId32 PRId32
@@ -278,6 +279,10 @@ static const char * btnm_map[] = {
 
 int factory_test(void)
 {
+    /* the test screens redraw the same labels all the time */
+    font_normal = decode_cache_font(&fsex_16);
+    font_large = decode_cache_font(&fsex_20);
+
     /* initialize screens here */
     scr_home = lv_obj_create(NULL);
     lv_scr_load(scr_home);
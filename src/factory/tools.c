@@ -25,6 +25,7 @@
 #include <stdarg.h>
 #include <stdlib.h>
 #include "lvgl/lvgl.h"
+#include "decode_cache.h"
 #include "tools.h"
 
 LV_FONT_DECLARE(fsex_16);
@@ -44,7 +45,7 @@ lv_obj_t *create_label(lv_obj_t *parent, const char *fmt, ...)
 
     lv_obj_t *label = lv_label_create(parent);
     lv_label_set_text(label, text);
-    lv_obj_set_style_text_font(label, font_normal, 0);
+    lv_obj_set_style_text_font(label, decode_cache_font(font_normal), 0);
 
     free(text);
 
@@ -59,7 +60,7 @@ lv_obj_t *create_btn(lv_obj_t *parent, const char *txt, lv_event_cb_t event_cb)
     lv_obj_t *label = lv_label_create(btn);
     lv_obj_set_style_bg_color(btn, lv_color_black(), 0);
     lv_label_set_text(label, txt);
-    lv_obj_set_style_text_font(label, &fsex_16, 0);
+    lv_obj_set_style_text_font(label, decode_cache_font(&fsex_16), 0);
     lv_obj_add_event_cb(btn, event_cb, LV_EVENT_ALL, NULL);
     return btn;
 }
@@ -74,7 +75,7 @@ lv_obj_t *create_passed_if_btn(lv_obj_t *parent, lv_event_cb_t event_cb, bool *p
     lv_obj_set_style_bg_color(btn_passed, lv_palette_main(LV_PALETTE_RED), 0);
 
     lv_obj_t *label_passed = lv_label_create(btn_passed);
-    lv_obj_set_style_text_font(label_passed, &fsex_16, 0);
+    lv_obj_set_style_text_font(label_passed, decode_cache_font(&fsex_16), 0);
     lv_label_set_text_fmt(label_passed, "Passed: %s", *passed ? "Yes" : "No");
     lv_obj_center(label_passed);
 
@@ -22,6 +22,7 @@
 #include <stdio.h>
 
 #include "indev.h"
+#include "i2c_bus.h"
 #include "ft6236.h"
 #include "debug.h"
 
@@ -33,48 +34,87 @@
 #define FT6236_ADDR      0x38
 #define FT6236_DEF_SPEED 400000
 
-extern int i2c_bus_scan(i2c_inst_t *i2c);
+/* FT6206 0x06, FT6236 0x36, FT6336 0x64 */
+static bool ft6236_detect(struct indev_spec *spec, u8 addr)
+{
+    const u8 reg = FT_REG_CHIPER;
+    u8 id;
+
+    if (indev_detect_xfer(spec, addr, &reg, 1, &id, 1) < 0)
+        return false;
+
+    return id == 0x06 || id == 0x36 || id == 0x64;
+}
 
 static void ft6236_write_reg(struct indev_priv *priv, uint8_t reg, uint8_t val)
 {
     uint16_t buf = val << 8 | reg;
-    i2c_write_blocking(priv->spec->i2c.master, priv->spec->i2c.addr, (uint8_t *)&buf, sizeof(buf), false);
+    i2c_bus_write(priv->spec->i2c.master, priv->spec->i2c.addr, (uint8_t *)&buf, sizeof(buf));
 }
 
 static uint8_t ft6236_read_reg(struct indev_priv *priv, uint8_t reg)
 {
     uint8_t val;
-    i2c_write_blocking(priv->spec->i2c.master, priv->spec->i2c.addr, &reg, 1, true);
-    i2c_read_blocking(priv->spec->i2c.master, priv->spec->i2c.addr, &val, 1, false);
+    i2c_bus_write_read(priv->spec->i2c.master, priv->spec->i2c.addr, &reg, 1, &val, 1);
     return val;
 }
 
-static uint16_t ft6236_read_x(struct indev_priv *priv)
+/*
+ * TD_STATUS and both point records in one burst, 6 bytes per point:
+ * event/XH, XL, id/YH, YL, weight, area.
+ */
+#define FT6236_MAX_POINTS   2
+#define FT6236_POINT_LEN    6
+#define FT6236_BURST_LEN    (1 + FT6236_MAX_POINTS * FT6236_POINT_LEN)
+
+/* last decoded frame, backs the single point ops */
+static struct indev_frame ft6236_frame;
+
+static int ft6236_read_frame(struct indev_priv *priv, struct indev_frame *frame)
 {
-    uint8_t val_h = read_reg(priv, FT_REG_TOUCH1_XH) & 0x1f;  /* the MSB is always high, but it shouldn't */
-    uint8_t val_l = read_reg(priv, FT_REG_TOUCH1_XL);
-    uint16_t val = (val_h << 8) | val_l;
-    
-    if (priv->invert_x)
-        return (priv->x_res - val);
+    u8 reg = FT_REG_TD_STATUS;
+    u8 buf[FT6236_BURST_LEN];
+    u8 *rec;
+    int nr, i;
+
+    if (i2c_bus_write_read(priv->spec->i2c.master, priv->spec->i2c.addr,
+                           &reg, 1, buf, sizeof(buf)) < 0)
+        return -1;
+
+    /* reads 0x0F until the first scan after reset */
+    nr = buf[0] & 0x0F;
+    if (nr > FT6236_MAX_POINTS)
+        nr = 0;
+
+    for (i = 0; i < nr; i++) {
+        rec = buf + 1 + i * FT6236_POINT_LEN;
+        frame->pt[i].id   = rec[2] >> 4;
+        frame->pt[i].x    = ((rec[0] & 0x0F) << 8) | rec[1];
+        frame->pt[i].y    = ((rec[2] & 0x0F) << 8) | rec[3];
+        frame->pt[i].size = rec[4];
+    }
+    frame->nr = nr;
 
-    return val;
+    return 0;
+}
+
+static uint16_t ft6236_read_x(struct indev_priv *priv)
+{
+    return ft6236_frame.pt[0].x;
 }
 
 static uint16_t ft6236_read_y(struct indev_priv *priv)
 {
-    uint8_t val_h = read_reg(priv, FT_REG_TOUCH1_YH);
-    uint8_t val_l = read_reg(priv, FT_REG_TOUCH1_YL);
-    if (priv->invert_y)
-        return (priv->y_res - ((val_h << 8) | val_l));
-    else
-        return ((val_h << 8) | val_l);
+    return ft6236_frame.pt[0].y;
 }
 
+/* one burst per sample, read_x/read_y then come from the same frame */
 static bool ft6236_is_pressed(struct indev_priv *priv)
 {
-    uint8_t val = read_reg(priv, FT_REG_TD_STATUS);
-    return val;
+    /* a failed read must not leave an old press behind */
+    if (ft6236_read_frame(priv, &ft6236_frame) < 0)
+        ft6236_frame.nr = 0;
+    return ft6236_frame.nr > 0;
 }
 
 static void ft6236_hw_init(struct indev_priv *priv)
@@ -103,15 +143,25 @@ static void ft6236_hw_init(struct indev_priv *priv)
     priv->ops->reset(priv);
     priv->ops->set_dir(priv, INDEV_DIR_SWITCH_XY | INDEV_DIR_INVERT_Y);
 
-    i2c_bus_scan(priv->spec->i2c.master);
-
-    /* registers are read-only */
+    /* the tuning registers do not take writes on these modules */
     // write_reg(priv, FT_REG_DEVICE_MODE, 0x00);
     // write_reg(priv, FT_REG_TH_GROUP, 22);
     // write_reg(priv, FT_REG_PERIODACTIVE, 12);
+
+    if (priv->spec->pin_irq == INDEV_PIN_NONE)
+        return;
+
+    gpio_init(priv->spec->pin_irq);
+    gpio_set_dir(priv->spec->pin_irq, GPIO_IN);
+    gpio_pull_up(priv->spec->pin_irq);
+
+    /* one INT pulse per report instead of INT held low while touched */
+    write_reg(priv, FT_REG_G_MODE, FT_G_MODE_TRIGGER);
+    if (read_reg(priv, FT_REG_G_MODE) != FT_G_MODE_TRIGGER)
+        pr_warn("ft6236: trigger mode not taken\n");
 }
 
-static struct indev_spec ft6236 = {
+struct indev_spec ft6236_spec = {
     .name = "ft6236",
     .type = INDEV_TYPE_POINTER,
 
@@ -126,9 +176,11 @@ static struct indev_spec ft6236 = {
     .x_res = TOUCH_X_RES,
     .y_res = TOUCH_Y_RES,
 
-    // .pin_irq = FT6236_PIN_IRQ,
+    .pin_irq = FT6236_PIN_IRQ,
     .pin_rst = FT6236_PIN_RST,
 
+    .detect = ft6236_detect,
+
     .ops = {
         .write_reg  = ft6236_write_reg,
         .read_reg   = ft6236_read_reg,
@@ -136,14 +188,8 @@ static struct indev_spec ft6236 = {
         .is_pressed = ft6236_is_pressed,
         .read_x     = ft6236_read_x,
         .read_y     = ft6236_read_y,
+        .read_frame = ft6236_read_frame,
     }
 };
 
-int indev_driver_init(void)
-{
-    printf("%s\n", __func__);
-    indev_probe(&ft6236);
-    return 0;
-}
-
 #endif
\ No newline at end of file
@@ -23,6 +23,7 @@
 #include <string.h>
 
 #include "indev.h"
+#include "i2c_bus.h"
 #include "debug.h"
 
 #if INDEV_DRV_USE_GT911
@@ -41,22 +42,20 @@
 #define GT911_REG_PID   0x8140  // GT911 Product ID Register
 
 #define GT911_REG_GSTID   0x814E  // GT911 Touch state
-#define GT911_REG_TP1_X   0x8150  // Touch Point 1 X Data start Address
-#define GT911_REG_TP1_Y   0x8152  // Touch Point 1 Y Data start Address
-// #define GT911_REG_TP2   0x8158  // Touch Point 2 Data Address
-// #define GT911_REG_TP3   0x8160  // Touch Point 3 Data Address
-// #define GT911_REG_TP4   0x8168  // Touch Point 4 Data Address
-// #define GT911_REG_TP5   0x8170  // Touch Point 5 Data Address
+#define GT911_REG_TP1     0x814F  // Touch Point 1 Data Address
+// #define GT911_REG_TP2   0x8157  // Touch Point 2 Data Address
+// #define GT911_REG_TP3   0x815F  // Touch Point 3 Data Address
+// #define GT911_REG_TP4   0x8167  // Touch Point 4 Data Address
+// #define GT911_REG_TP5   0x816F  // Touch Point 5 Data Address
 
 #define GT911_X_RES     LCD_HOR_RES
 #define GT911_Y_RES     LCD_VER_RES
 
+/* picked by the INT level during reset */
 #define GT911_ADDR      0x14
-// #define GT911_ADDR      0x5D
+#define GT911_ADDR_ALT  0x5D
 #define GT911_DEF_SPEED 400000
 
-extern int i2c_bus_scan(i2c_inst_t *i2c);
-
 // rp2040 i2c write byte
 #define rp_i2c_wb(v) \
     i2c_write_blocking(priv->spec->i2c.master, priv->spec->i2c.addr, (uint8_t []){v}, 1, false);
@@ -84,7 +83,7 @@ static void gt911_write_addr16(struct indev_priv *priv, u16 reg, u8 *txbuf, u8 l
     // for (int i = 0; i < len; i++)
     //     printf("buf[%d] : 0x%x\n", i, buf[i]);
 
-    i2c_write_blocking(priv->spec->i2c.master, priv->spec->i2c.addr, buf, len, false);
+    i2c_bus_write(priv->spec->i2c.master, priv->spec->i2c.addr, buf, len);
 }
 
 // static u8 gt911_read_reg16(struct indev_priv *priv, u16 reg)
@@ -100,47 +99,97 @@ static void gt911_write_addr16(struct indev_priv *priv, u16 reg, u8 *txbuf, u8 l
 //     return buf[0];
 // }
 
-static void gt911_read_addr16(struct indev_priv *priv, u16 reg, u8 *rxbuf, u8 len)
+static int gt911_read_addr16(struct indev_priv *priv, u16 reg, u8 *rxbuf, u8 len)
 {
     u8 buf[2];
 
     buf[0] = reg >> 8;
     buf[1] = reg & 0xFF;
 
-    i2c_write_blocking(priv->spec->i2c.master, priv->spec->i2c.addr, buf, 2, false);
-    i2c_read_blocking(priv->spec->i2c.master, priv->spec->i2c.addr, rxbuf, len, false);
+    return i2c_bus_write_read(priv->spec->i2c.master, priv->spec->i2c.addr, buf, 2, rxbuf, len);
 }
 
-static uint16_t gt911_read_x(struct indev_priv *priv)
+/*
+ * Point records follow the status byte, 8 bytes each:
+ * track id, x lo/hi, y lo/hi, size lo/hi, reserved.
+ */
+#define GT911_STATUS_READY  0x80
+#define GT911_STATUS_NR     0x0F
+#define GT911_POINT_LEN     8
+#define GT911_MAX_POINTS    5
+
+/* last decoded frame, backs the single point ops */
+static struct indev_frame gt911_frame;
+
+/* product ID reads back as ASCII "911" */
+static bool gt911_detect(struct indev_spec *spec, u8 addr)
 {
-    u16 this_x = 0;
+    const u8 reg[2] = { GT911_REG_PID >> 8, GT911_REG_PID & 0xFF };
+    u8 pid[4];
 
-    read_addr16(priv, GT911_REG_TP1_X, (u8  *)&this_x, sizeof(this_x));
-    pr_debug("this_x : %d\n", this_x);
+    if (indev_detect_xfer(spec, addr, reg, sizeof(reg), pid, sizeof(pid)) < 0)
+        return false;
 
-    return this_x;
+    return !memcmp(pid, "911", 3);
 }
 
-static uint16_t gt911_read_y(struct indev_priv *priv)
+static int gt911_read_frame(struct indev_priv *priv, struct indev_frame *frame)
 {
-    u16 this_y = 0;
+    u8 buf[1 + GT911_POINT_LEN * GT911_MAX_POINTS] = {0};
+    u8 *rec;
+    int nr, i;
+
+    /* status and the first point in one burst, covers single touch */
+    if (gt911_read_addr16(priv, GT911_REG_GSTID, buf, 1 + GT911_POINT_LEN) < 0)
+        return -1;
+    if (!(buf[0] & GT911_STATUS_READY))
+        return INDEV_FRAME_NONE;
+
+    nr = buf[0] & GT911_STATUS_NR;
+    if (nr > GT911_MAX_POINTS)
+        nr = GT911_MAX_POINTS;
+    if (nr > INDEV_MAX_POINTS)
+        nr = INDEV_MAX_POINTS;
+
+    /* leave the status set, the controller keeps the report for a retry */
+    if (nr > 1 && gt911_read_addr16(priv, GT911_REG_TP1 + GT911_POINT_LEN,
+                                    buf + 1 + GT911_POINT_LEN,
+                                    (nr - 1) * GT911_POINT_LEN) < 0)
+        return -1;
+
+    /* hand the buffer back to the controller */
+    gt911_write_addr16(priv, GT911_REG_GSTID, (u8 []){0x00}, 1);
 
-    read_addr16(priv, GT911_REG_TP1_Y, (u8  *)&this_y, sizeof(this_y));
-    pr_debug("this_y : %d\n", this_y);
+    for (i = 0; i < nr; i++) {
+        rec = buf + 1 + i * GT911_POINT_LEN;
+        frame->pt[i].id   = rec[0];
+        frame->pt[i].x    = rec[1] | (rec[2] << 8);
+        frame->pt[i].y    = rec[3] | (rec[4] << 8);
+        frame->pt[i].size = rec[5] | (rec[6] << 8);
+    }
+    frame->nr = nr;
 
-    return this_y;
+    pr_debug("frame : %d points, tp1 (%d, %d)\n", nr, frame->pt[0].x, frame->pt[0].y);
+    return 0;
+}
+
+static uint16_t gt911_read_x(struct indev_priv *priv)
+{
+    return gt911_frame.pt[0].x;
 }
 
+static uint16_t gt911_read_y(struct indev_priv *priv)
+{
+    return gt911_frame.pt[0].y;
+}
+
+/* one burst per sample, read_x/read_y then come from the same frame */
 static bool gt911_is_pressed(struct indev_priv *priv)
 {
-    u8 state = 0;
-    gt911_read_addr16(priv, GT911_REG_GSTID, &state, 1);
-    // printf("state : %d\n", state);
-    gt911_write_addr16(priv, GT911_REG_GSTID, (u8 []){0x00}, 1);
-    if (state & 0x80)
-        return true;
-    
-    return false;
+    /* no new report yet, the previous state still holds */
+    if (gt911_read_frame(priv, &gt911_frame) < 0)
+        gt911_frame.nr = 0;
+    return gt911_frame.nr > 0;
 }
 
 static void gt911_hw_init(struct indev_priv *priv)
@@ -176,13 +225,17 @@ static void gt911_hw_init(struct indev_priv *priv)
     pr_debug("chip reset\n");
     priv->ops->reset(priv);
 
+    /*
+     * INT high through reset latches 0x14, whatever address detection
+     * found the chip at before the reset.
+     */
+    priv->spec->i2c.addr = GT911_ADDR;
+
     pr_debug("set irq pin as input\n");
     gpio_init(priv->spec->pin_irq);
     gpio_set_dir(priv->spec->pin_irq, GPIO_IN);
     gpio_pull_down(priv->spec->pin_irq);
 
-    i2c_bus_scan(priv->spec->i2c.master);
-
     u8 temp[5];
     read_addr16(priv, GT911_REG_PID, temp, 4);
     pr_debug("Product ID : %s\n", (char *)temp);
@@ -203,12 +256,13 @@ static void gt911_hw_init(struct indev_priv *priv)
     // priv->ops->set_dir(priv, INDEV_DIR_SWITCH_XY | INDEV_DIR_INVERT_Y);
 }
 
-static struct indev_spec gt911 = {
-    .name = "ft6236",
+struct indev_spec gt911_spec = {
+    .name = "gt911",
     .type = INDEV_TYPE_POINTER,
 
     .i2c = {
         .addr = GT911_ADDR,
+        .addr_alt = GT911_ADDR_ALT,
         .master = i2c1,
         .speed = GT911_DEF_SPEED,
         .pin_scl = GT911_PIN_SCL,
@@ -221,6 +275,8 @@ static struct indev_spec gt911 = {
     .pin_irq = GT911_PIN_IRQ,
     .pin_rst = GT911_PIN_RST,
 
+    .detect = gt911_detect,
+
     .ops = {
         .write_addr16 = gt911_write_addr16,
         // .read_reg16 = gt911_read_reg16,
@@ -229,14 +285,8 @@ static struct indev_spec gt911 = {
         .is_pressed = gt911_is_pressed,
         .read_x     = gt911_read_x,
         .read_y     = gt911_read_y,
+        .read_frame = gt911_read_frame,
     }
 };
 
-int indev_driver_init(void)
-{
-    printf("%s\n", __func__);
-    indev_probe(&gt911);
-    return 0;
-}
-
 #endif
\ No newline at end of file
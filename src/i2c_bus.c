@@ -0,0 +1,486 @@
+// Copyright (c) 2024 embeddedboys developers
+
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+/*
+ * I2C transaction engine.
+ *
+ * Transactions are queued per controller and run by DMA: the TX channel
+ * feeds IC_DATA_CMD with 16-bit command words (data, READ, RESTART, STOP),
+ * the RX channel drains the received bytes. The controller's STOP_DET
+ * interrupt completes a transaction and starts the next queued one, so
+ * the CPU only shows up at the ends. Tasks using the blocking helpers
+ * sleep on a task notification meanwhile.
+ */
+
+#define pr_fmt(fmt) "i2c_bus: " fmt
+
+#include <stdio.h>
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "hardware/dma.h"
+#include "hardware/i2c.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+#include "hardware/timer.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "i2c_bus.h"
+#include "console.h"
+#include "debug.h"
+
+#if I2C_DMA_ENABLED
+
+struct i2c_bus {
+    i2c_inst_t      *i2c;
+    bool            ready;
+    int             dma_tx;
+    int             dma_rx;
+    spin_lock_t     *lock;
+
+    struct i2c_xfer *queue[I2C_BUS_QUEUE_LEN];
+    uint8_t         head;
+    uint8_t         count;
+
+    struct i2c_xfer *cur;
+    int             status;
+    uint32_t        start_us;
+    uint16_t        cmd[I2C_BUS_MAX_LEN];
+
+    struct i2c_bus_stats stats;
+};
+
+static struct i2c_bus g_i2c_bus[NUM_I2CS];
+
+static struct i2c_bus *i2c_bus_get(i2c_inst_t *i2c)
+{
+    struct i2c_bus *bus = &g_i2c_bus[i2c_hw_index(i2c)];
+
+    return bus->ready ? bus : NULL;
+}
+
+/* with the lock held */
+static void i2c_bus_start(struct i2c_bus *bus, struct i2c_xfer *xfer)
+{
+    i2c_hw_t *hw = i2c_get_hw(bus->i2c);
+    size_t n = 0, i;
+
+    for (i = 0; i < xfer->tx_len; i++)
+        bus->cmd[n++] = xfer->tx[i];
+
+    for (i = 0; i < xfer->rx_len; i++) {
+        uint16_t cmd = I2C_IC_DATA_CMD_CMD_BITS;
+
+        if (i == 0 && xfer->tx_len)
+            cmd |= I2C_IC_DATA_CMD_RESTART_BITS;
+        bus->cmd[n++] = cmd;
+    }
+    bus->cmd[n - 1] |= I2C_IC_DATA_CMD_STOP_BITS;
+
+    bus->cur = xfer;
+    bus->status = 0;
+    bus->start_us = time_us_32();
+
+    hw->enable = 0;
+    hw->tar = xfer->addr;
+    hw->enable = 1;
+
+    (void)hw->clr_intr;
+    hw->intr_mask = I2C_IC_INTR_MASK_M_STOP_DET_BITS | I2C_IC_INTR_MASK_M_TX_ABRT_BITS;
+
+    if (xfer->rx_len)
+        dma_channel_transfer_to_buffer_now(bus->dma_rx, xfer->rx, xfer->rx_len);
+    dma_channel_transfer_from_buffer_now(bus->dma_tx, bus->cmd, n);
+}
+
+/* with the lock held, hands back the transaction that was running */
+static struct i2c_xfer *i2c_bus_next(struct i2c_bus *bus)
+{
+    struct i2c_xfer *done = bus->cur;
+
+    bus->cur = NULL;
+    if (bus->count) {
+        struct i2c_xfer *xfer = bus->queue[bus->head];
+
+        bus->head = (bus->head + 1) % I2C_BUS_QUEUE_LEN;
+        bus->count--;
+        i2c_bus_start(bus, xfer);
+    }
+
+    return done;
+}
+
+static void i2c_bus_irq(struct i2c_bus *bus)
+{
+    i2c_hw_t *hw = i2c_get_hw(bus->i2c);
+    uint32_t stat = hw->intr_stat;
+    struct i2c_xfer *xfer;
+    uint32_t save;
+    int status;
+
+    if (stat & I2C_IC_INTR_STAT_R_TX_ABRT_BITS) {
+        /* NACK or lost arbitration, the controller still sends a STOP */
+        (void)hw->clr_tx_abrt;
+        dma_channel_abort(bus->dma_tx);
+        dma_channel_abort(bus->dma_rx);
+        bus->status = PICO_ERROR_GENERIC;
+    }
+
+    if (!(stat & I2C_IC_INTR_STAT_R_STOP_DET_BITS))
+        return;
+    (void)hw->clr_stop_det;
+
+    save = spin_lock_blocking(bus->lock);
+    hw->intr_mask = 0;
+    if (!bus->cur) {
+        spin_unlock(bus->lock, save);
+        return;
+    }
+
+    status = bus->status;
+    if (status == 0) {
+        /* the last bytes are in the RX FIFO, the channel is about done */
+        while (dma_channel_is_busy(bus->dma_rx))
+            tight_loop_contents();
+        status = bus->cur->tx_len + bus->cur->rx_len;
+        bus->stats.bytes += status;
+    } else {
+        bus->stats.nacks++;
+    }
+    bus->stats.xfers++;
+    bus->stats.busy_us += time_us_32() - bus->start_us;
+
+    xfer = i2c_bus_next(bus);
+    spin_unlock(bus->lock, save);
+
+    if (xfer->done)
+        xfer->done(xfer, status);
+}
+
+static void i2c_bus_irq0(void)
+{
+    i2c_bus_irq(&g_i2c_bus[0]);
+}
+
+static void i2c_bus_irq1(void)
+{
+    i2c_bus_irq(&g_i2c_bus[1]);
+}
+
+int i2c_bus_submit(struct i2c_xfer *xfer)
+{
+    struct i2c_bus *bus = i2c_bus_get(xfer->i2c);
+    uint32_t save;
+    int ret = 0;
+
+    if (!bus)
+        return PICO_ERROR_INVALID_ARG;
+    if (!xfer->tx_len && !xfer->rx_len)
+        return PICO_ERROR_INVALID_ARG;
+    if (xfer->tx_len + xfer->rx_len > I2C_BUS_MAX_LEN)
+        return PICO_ERROR_INVALID_ARG;
+
+    save = spin_lock_blocking(bus->lock);
+    if (!bus->cur) {
+        i2c_bus_start(bus, xfer);
+    } else if (bus->count < I2C_BUS_QUEUE_LEN) {
+        bus->queue[(bus->head + bus->count) % I2C_BUS_QUEUE_LEN] = xfer;
+        bus->count++;
+    } else {
+        ret = PICO_ERROR_GENERIC;
+    }
+    spin_unlock(bus->lock, save);
+
+    return ret;
+}
+
+/*
+ * Drop a transaction the caller gave up on, running or still queued.
+ * False when it already completed and done() is on its way.
+ */
+static bool i2c_bus_cancel(struct i2c_bus *bus, struct i2c_xfer *xfer)
+{
+    i2c_hw_t *hw = i2c_get_hw(bus->i2c);
+    bool found = false;
+    uint32_t save;
+    int i, j;
+
+    save = spin_lock_blocking(bus->lock);
+    if (bus->cur == xfer) {
+        hw->intr_mask = 0;
+        dma_channel_abort(bus->dma_tx);
+        dma_channel_abort(bus->dma_rx);
+        /* stuck slave or no STOP seen, abort and flush the controller */
+        hw->enable |= I2C_IC_ENABLE_ABORT_BITS;
+        while (hw->enable & I2C_IC_ENABLE_ABORT_BITS)
+            tight_loop_contents();
+        (void)hw->clr_intr;
+        bus->stats.timeouts++;
+        i2c_bus_next(bus);
+        found = true;
+    } else {
+        for (i = 0; i < bus->count; i++) {
+            if (bus->queue[(bus->head + i) % I2C_BUS_QUEUE_LEN] != xfer)
+                continue;
+            for (j = i; j < bus->count - 1; j++)
+                bus->queue[(bus->head + j) % I2C_BUS_QUEUE_LEN] =
+                    bus->queue[(bus->head + j + 1) % I2C_BUS_QUEUE_LEN];
+            bus->count--;
+            bus->stats.timeouts++;
+            found = true;
+            break;
+        }
+    }
+    spin_unlock(bus->lock, save);
+
+    return found;
+}
+
+struct i2c_bus_waiter {
+    TaskHandle_t task;
+    volatile int status;
+};
+
+static void i2c_bus_wake(struct i2c_xfer *xfer, int status)
+{
+    struct i2c_bus_waiter *w = xfer->arg;
+    BaseType_t woken = pdFALSE;
+
+    w->status = status;
+    vTaskNotifyGiveIndexedFromISR(w->task, I2C_BUS_NOTIFY_INDEX, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+static int i2c_bus_xfer_blocking(struct i2c_xfer *xfer)
+{
+    int ret;
+
+    if (xfer->tx_len) {
+        ret = i2c_write_blocking(xfer->i2c, xfer->addr, xfer->tx, xfer->tx_len, xfer->rx_len != 0);
+        if (ret < 0)
+            return ret;
+    }
+
+    if (xfer->rx_len) {
+        ret = i2c_read_blocking(xfer->i2c, xfer->addr, xfer->rx, xfer->rx_len, false);
+        if (ret < 0)
+            return ret;
+    }
+
+    return xfer->tx_len + xfer->rx_len;
+}
+
+static int i2c_bus_transfer(struct i2c_xfer *xfer)
+{
+    struct i2c_bus *bus = i2c_bus_get(xfer->i2c);
+    struct i2c_bus_waiter w;
+    TickType_t start;
+    int ret;
+
+    if (portCHECK_IF_IN_ISR())
+        return PICO_ERROR_NOT_PERMITTED;
+
+    if (!bus || xTaskGetSchedulerState() != taskSCHEDULER_RUNNING ||
+        xfer->tx_len + xfer->rx_len > I2C_BUS_MAX_LEN) {
+        if (bus)
+            bus->stats.blocking++;
+        return i2c_bus_xfer_blocking(xfer);
+    }
+
+    w.task = xTaskGetCurrentTaskHandle();
+    w.status = PICO_ERROR_TIMEOUT;
+    xfer->done = i2c_bus_wake;
+    xfer->arg = &w;
+
+    /* a wake-up left over from an earlier timed out transaction */
+    ulTaskNotifyValueClearIndexed(NULL, I2C_BUS_NOTIFY_INDEX, ~0u);
+
+    start = xTaskGetTickCount();
+    while ((ret = i2c_bus_submit(xfer)) == PICO_ERROR_GENERIC) {
+        if (xTaskGetTickCount() - start > pdMS_TO_TICKS(I2C_BUS_TIMEOUT_MS))
+            return PICO_ERROR_TIMEOUT;
+        vTaskDelay(1);
+    }
+    if (ret < 0)
+        return ret;
+
+    if (!ulTaskNotifyTakeIndexed(I2C_BUS_NOTIFY_INDEX, pdTRUE, pdMS_TO_TICKS(I2C_BUS_TIMEOUT_MS))) {
+        /* lost the race with the interrupt, xfer and w must outlive done() */
+        if (!i2c_bus_cancel(bus, xfer))
+            ulTaskNotifyTakeIndexed(I2C_BUS_NOTIFY_INDEX, pdTRUE, portMAX_DELAY);
+    }
+
+    return w.status;
+}
+
+int i2c_bus_write(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len)
+{
+    struct i2c_xfer xfer = {
+        .i2c = i2c, .addr = addr,
+        .tx = src, .tx_len = len,
+    };
+
+    return i2c_bus_transfer(&xfer);
+}
+
+int i2c_bus_read(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len)
+{
+    struct i2c_xfer xfer = {
+        .i2c = i2c, .addr = addr,
+        .rx = dst, .rx_len = len,
+    };
+
+    return i2c_bus_transfer(&xfer);
+}
+
+int i2c_bus_write_read(i2c_inst_t *i2c, uint8_t addr,
+                       const uint8_t *src, size_t tx_len,
+                       uint8_t *dst, size_t rx_len)
+{
+    struct i2c_xfer xfer = {
+        .i2c = i2c, .addr = addr,
+        .tx = src, .tx_len = tx_len,
+        .rx = dst, .rx_len = rx_len,
+    };
+    int ret = i2c_bus_transfer(&xfer);
+
+    return ret < 0 ? ret : (int)rx_len;
+}
+
+void i2c_bus_get_stats(i2c_inst_t *i2c, struct i2c_bus_stats *stats)
+{
+    *stats = g_i2c_bus[i2c_hw_index(i2c)].stats;
+}
+
+static int i2c_bus_cmd(int argc, char **argv)
+{
+    struct i2c_bus *bus;
+    int i;
+
+    for (i = 0; i < NUM_I2CS; i++) {
+        bus = &g_i2c_bus[i];
+        if (!bus->ready)
+            continue;
+        printf("i2c%d: %lu xfers, %lu bytes, %lu nacks, %lu timeouts, %lu polled, %lu us on bus\n",
+               i, bus->stats.xfers, bus->stats.bytes, bus->stats.nacks,
+               bus->stats.timeouts, bus->stats.blocking, bus->stats.busy_us);
+    }
+
+    return 0;
+}
+
+static const struct console_cmd i2c_bus_console_cmd = {
+    .name = "i2c",
+    .help = "i2c bus transaction counters",
+    .fn = i2c_bus_cmd,
+};
+
+int i2c_bus_init(i2c_inst_t *i2c)
+{
+    static bool registered;
+    struct i2c_bus *bus = &g_i2c_bus[i2c_hw_index(i2c)];
+    i2c_hw_t *hw = i2c_get_hw(i2c);
+    dma_channel_config c;
+
+    if (bus->ready)
+        return 0;
+
+    bus->i2c = i2c;
+    bus->lock = spin_lock_instance(spin_lock_claim_unused(true));
+    bus->dma_tx = dma_claim_unused_channel(true);
+    bus->dma_rx = dma_claim_unused_channel(true);
+
+    /* halfword writes are replicated on the APB, bits 10:0 land in DATA_CMD */
+    c = dma_channel_get_default_config(bus->dma_tx);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, i2c_get_dreq(i2c, true));
+    dma_channel_configure(bus->dma_tx, &c, &hw->data_cmd, NULL, 0, false);
+
+    c = dma_channel_get_default_config(bus->dma_rx);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, true);
+    channel_config_set_dreq(&c, i2c_get_dreq(i2c, false));
+    dma_channel_configure(bus->dma_rx, &c, NULL, &hw->data_cmd, 0, false);
+
+    hw->dma_cr = I2C_IC_DMA_CR_TDMAE_BITS | I2C_IC_DMA_CR_RDMAE_BITS;
+    hw->intr_mask = 0;
+
+    irq_set_exclusive_handler(I2C0_IRQ + i2c_hw_index(i2c),
+                              i2c_hw_index(i2c) ? i2c_bus_irq1 : i2c_bus_irq0);
+    irq_set_enabled(I2C0_IRQ + i2c_hw_index(i2c), true);
+
+    bus->ready = true;
+
+    if (!registered) {
+        console_register(&i2c_bus_console_cmd);
+        registered = true;
+    }
+
+    pr_debug("i2c%d, dma tx %d rx %d\n", i2c_hw_index(i2c), bus->dma_tx, bus->dma_rx);
+    return 0;
+}
+
+#else
+
+int i2c_bus_init(i2c_inst_t *i2c)
+{
+    return 0;
+}
+
+int i2c_bus_submit(struct i2c_xfer *xfer)
+{
+    return PICO_ERROR_NOT_PERMITTED;
+}
+
+int i2c_bus_write(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len)
+{
+    return i2c_write_blocking(i2c, addr, src, len, false);
+}
+
+int i2c_bus_read(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len)
+{
+    return i2c_read_blocking(i2c, addr, dst, len, false);
+}
+
+int i2c_bus_write_read(i2c_inst_t *i2c, uint8_t addr,
+                       const uint8_t *src, size_t tx_len,
+                       uint8_t *dst, size_t rx_len)
+{
+    int ret = i2c_write_blocking(i2c, addr, src, tx_len, true);
+
+    if (ret < 0)
+        return ret;
+
+    return i2c_read_blocking(i2c, addr, dst, rx_len, false);
+}
+
+void i2c_bus_get_stats(i2c_inst_t *i2c, struct i2c_bus_stats *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+}
+
+#endif /* I2C_DMA_ENABLED */
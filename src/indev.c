@@ -19,15 +19,72 @@
 // OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
 // WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
+#include "hardware/timer.h"
+
 #include "indev.h"
+#include "i2c_bus.h"
 #include "debug.h"
 
 static struct indev_priv g_indev_priv;
+static struct indev_ops g_indev_ops;
+
+static const struct indev_filter_cfg g_indev_filter_default = INDEV_FILTER_CFG_DEFAULT;
+
+/*
+ * Resistive pipeline: median of N X/Y conversions, Z1/Z2 pressure check,
+ * calibration, then one-euro smoothing. The result is kept for
+ * indev_read_point() so the sample is only taken once.
+ */
+static bool indev_resistive_sample(struct indev_priv *priv)
+{
+    const struct indev_filter_cfg *cfg = priv->filter.cfg;
+    u16 xs[INDEV_FILTER_MAX_N], ys[INDEV_FILTER_MAX_N];
+    u16 x, y, z1, z2;
+    int i, n = cfg->median_n;
+
+    if (priv->ops->is_pressed && !priv->ops->is_pressed(priv))
+        goto up;
+
+    if (priv->ops->read_adc_burst) {
+        if (priv->ops->read_adc_burst(priv, xs, ys, n, &z1, &z2) < 0)
+            goto up;
+    } else {
+        for (i = 0; i < n; i++) {
+            xs[i] = priv->ops->read_adc(priv, INDEV_ADC_X);
+            ys[i] = priv->ops->read_adc(priv, INDEV_ADC_Y);
+        }
+        z1 = priv->ops->read_adc(priv, INDEV_ADC_Z1);
+        z2 = priv->ops->read_adc(priv, INDEV_ADC_Z2);
+    }
+    x = indev_filter_median(xs, n);
+    y = indev_filter_median(ys, n);
+
+    if (!indev_filter_pressure_ok(cfg, x, z1, z2))
+        goto up;
+
+    priv->raw_x = x;
+    priv->raw_y = y;
+    indev_calib_apply(&priv->calib, &x, &y, priv->x_res, priv->y_res);
+    indev_filter_smooth(&priv->filter, &x, &y, time_us_32());
+
+    priv->cur_x = x;
+    priv->cur_y = y;
+    return true;
+
+up:
+    indev_filter_reset(&priv->filter);
+    return false;
+}
 
 static bool __indev_is_pressed(struct indev_priv *priv)
 {
+    if (priv->ops->read_adc || priv->ops->read_adc_burst)
+        return indev_resistive_sample(priv);
+
     if (priv->ops->is_pressed)
         return priv->ops->is_pressed(priv);
+
+    return false;
 }
 
 bool indev_is_pressed(void)
@@ -35,81 +92,125 @@ bool indev_is_pressed(void)
     return __indev_is_pressed(&g_indev_priv);
 }
 
-static void swap_float(float *a, float *b)
+/*
+ * INDEV_DIR_* refer to the screen axes: SWITCH_XY feeds screen x from the
+ * raw y channel, INVERT_X/Y mirror the screen axis. Together with the
+ * spec's raw span and offset this becomes the default matrix.
+ */
+static void indev_calib_default(struct indev_priv *priv, struct indev_calib *cal)
 {
-    float temp = *a;
-    *a = *b;
-    *b = temp;
+    struct indev_spec *spec = priv->spec;
+    indev_direction_t dir = priv->dir;
+
+    struct indev_calib_axis x = {
+        .from_y     = dir & INDEV_DIR_SWITCH_XY,
+        .invert     = dir & INDEV_DIR_INVERT_X,
+        .res        = priv->x_res,
+        .touch_res  = spec->x_res,
+        .bits       = spec->resolution,
+        .offs       = spec->x_offs,
+    };
+    struct indev_calib_axis y = {
+        .from_y     = !(dir & INDEV_DIR_SWITCH_XY),
+        .invert     = dir & INDEV_DIR_INVERT_Y,
+        .res        = priv->y_res,
+        .touch_res  = spec->y_res,
+        .bits       = spec->resolution,
+        .offs       = spec->y_offs,
+    };
+
+    indev_calib_from_axes(cal, &x, &y);
 }
 
 static void __indev_set_dir(struct indev_priv *priv, indev_direction_t dir)
 {
     priv->dir = dir;
 
-    if (dir & INDEV_DIR_INVERT_X) {
-        priv->invert_x = true;
-    } else {
-        priv->invert_x = false;
-    }
-
-    if (dir & INDEV_DIR_INVERT_Y) {
-        priv->invert_y = true;
-    } else {
-        priv->invert_y = false;
-    }
+    /* a wizard calibration already covers the orientation */
+    if (!priv->calib_user)
+        indev_calib_default(priv, &priv->calib);
+}
 
-    if (dir & INDEV_DIR_SWITCH_XY) {
-        priv->switch_xy = true;
+void indev_set_dir(indev_direction_t dir)
+{
+    __indev_set_dir(&g_indev_priv, dir);
+}
 
-        priv->ops->read_x = priv->spec->ops.read_y;
-        priv->ops->read_y = priv->spec->ops.read_x;
+void indev_read_point(u16 *x, u16 *y)
+{
+    struct indev_priv *priv = &g_indev_priv;
 
-        bool invert_tmp = priv->invert_x;
-        priv->invert_x = priv->invert_y;
-        priv->invert_y = invert_tmp;
+    if (priv->ops->read_adc || priv->ops->read_adc_burst) {
+        *x = priv->cur_x;
+        *y = priv->cur_y;
+        return;
+    }
 
-        u16 offs_tmp = priv->spec->x_offs;
-        priv->spec->x_offs = priv->spec->y_offs;
-        priv->spec->y_offs = offs_tmp;
+    *x = priv->ops->read_x(priv);
+    *y = priv->ops->read_y(priv);
+    priv->raw_x = *x;
+    priv->raw_y = *y;
 
-        swap_float(&priv->sc_x, &priv->sc_y);
+    indev_calib_apply(&priv->calib, x, y, priv->x_res, priv->y_res);
+}
 
-        u16 res_tmp = priv->x_res;
-        priv->x_res = priv->y_res;
-        priv->y_res = res_tmp;
-    } else {
-        priv->switch_xy = false;
+void indev_get_raw(u16 *x, u16 *y)
+{
+    *x = g_indev_priv.raw_x;
+    *y = g_indev_priv.raw_y;
+}
 
-        priv->ops->read_x = priv->spec->ops.read_x;
-        priv->ops->read_y = priv->spec->ops.read_y;
-    }
+void indev_set_calib(const struct indev_calib *cal)
+{
+    g_indev_priv.calib = *cal;
+    g_indev_priv.calib_user = true;
 }
 
-void indev_set_dir(indev_direction_t dir)
+void indev_get_calib(struct indev_calib *cal)
 {
-    __indev_set_dir(&g_indev_priv, dir);
+    *cal = g_indev_priv.calib;
 }
 
-static u16 __indev_read_x(struct indev_priv *priv)
+void indev_reset_calib(void)
 {
-    if (priv->ops->read_x)
-        return priv->ops->read_x(priv);
+    struct indev_priv *priv = &g_indev_priv;
+
+    priv->calib_user = false;
+    __indev_set_dir(priv, priv->dir);
 }
 
-u16 indev_read_x(void)
+bool indev_has_frame(void)
 {
-    return __indev_read_x(&g_indev_priv);
+    return g_indev_priv.ops->read_frame != NULL;
 }
 
-static u16 __indev_read_y(struct indev_priv *priv)
+int indev_read_frame(struct indev_frame *frame)
 {
-    if (priv->ops->read_y)
-        return priv->ops->read_y(priv);
+    struct indev_priv *priv = &g_indev_priv;
+    int ret;
+
+    if (!priv->ops->read_frame)
+        return -1;
+
+    ret = priv->ops->read_frame(priv, frame);
+    if (ret)
+        return ret;
+
+    if (frame->nr) {
+        priv->raw_x = frame->pt[0].x;
+        priv->raw_y = frame->pt[0].y;
+    }
+
+    for (int i = 0; i < frame->nr; i++)
+        indev_calib_apply(&priv->calib, &frame->pt[i].x, &frame->pt[i].y,
+                          priv->x_res, priv->y_res);
+
+    return ret;
 }
 
-u16 indev_read_y(void)
+int indev_get_irq_pin(void)
 {
-    return __indev_read_y(&g_indev_priv);
+    return g_indev_priv.spec->pin_irq;
 }
 
 static void indev_reset(struct indev_priv *priv)
@@ -153,6 +254,12 @@ static void indev_merge_ops(struct indev_ops *dst, struct indev_ops *src)
         dst->read_x = src->read_x;
     if (src->read_y)
         dst->read_y = src->read_y;
+    if (src->read_frame)
+        dst->read_frame = src->read_frame;
+    if (src->read_adc)
+        dst->read_adc = src->read_adc;
+    if (src->read_adc_burst)
+        dst->read_adc_burst = src->read_adc_burst;
 }
 
 int indev_probe(struct indev_spec *spec)
@@ -170,35 +277,30 @@ int indev_probe(struct indev_spec *spec)
 
     priv->spec = spec;
 
-    priv->ops = (struct indev_ops *)malloc(sizeof(struct indev_ops));
-    if (!priv->ops) {
-        pr_error("failed to allocate memory!\n");
-        return -1;
-    }
+    priv->ops = &g_indev_ops;
 
     priv->x_res = LCD_HOR_RES;
     priv->y_res = LCD_VER_RES;
 
-    priv->invert_x = false;
-    priv->invert_y = false;
-
     priv->ops->reset = indev_reset;
     priv->ops->set_dir = __indev_set_dir;
 
-    float tft_x = LCD_HOR_RES;
-    float tft_y = LCD_VER_RES;
-
-    float touch_x = priv->spec->x_res;
-    float touch_y = priv->spec->y_res;
-
-    priv->sc_x = (float)(tft_x / touch_x);
-    priv->sc_y = (float)(tft_y / touch_y);
+    priv->calib_user = false;
+    __indev_set_dir(priv, INDEV_DIR_NOP);
 
-    pr_debug("sc_x : %f, sc_y : %f", priv->sc_x, priv->sc_y);
+    indev_filter_init(&priv->filter, spec->filter ? spec->filter : &g_indev_filter_default);
+    if (priv->filter.cfg->median_n < 1 || priv->filter.cfg->median_n > INDEV_FILTER_MAX_N) {
+        pr_error("%s: median_n out of range\n", spec->name);
+        return -1;
+    }
 
     indev_merge_ops(priv->ops, &spec->ops);
 
     priv->ops->init(priv);
 
+    /* touch bus transfers go through DMA once the scheduler runs */
+    if (spec->i2c.master)
+        i2c_bus_init(spec->i2c.master);
+
     return 0;
 }
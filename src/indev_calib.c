@@ -0,0 +1,174 @@
+// Copyright (c) 2024 embeddedboys developers
+
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+/*
+ * Touch calibration math.
+ *
+ * The matrix is built once, either from the driver's axis description or
+ * by fitting wizard samples, and then applied to every sample in Q16.
+ * Floating point is only used here, never per sample.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "indev_calib.h"
+
+static int32_t indev_calib_q16(double v)
+{
+    return (int32_t)lround(v * INDEV_CALIB_ONE);
+}
+
+void indev_calib_identity(struct indev_calib *cal)
+{
+    memset(cal, 0, sizeof(*cal));
+    cal->a = INDEV_CALIB_ONE;
+    cal->e = INDEV_CALIB_ONE;
+}
+
+/*
+ * out = ((invert ? res - k * raw : k * raw) + offs) * res / touch_res
+ * with k = res / 2^bits, the scaling the resistive drivers did in float.
+ */
+static void indev_calib_axis_coef(const struct indev_calib_axis *axis,
+                                  double *gain, double *offset)
+{
+    double k = axis->bits ? (double)axis->res / (1 << axis->bits) : 1.0;
+    double sc = axis->touch_res ? (double)axis->res / axis->touch_res : 1.0;
+
+    *gain = (axis->invert ? -k : k) * sc;
+    *offset = ((axis->invert ? axis->res : 0) + axis->offs) * sc;
+}
+
+void indev_calib_from_axes(struct indev_calib *cal,
+                           const struct indev_calib_axis *x,
+                           const struct indev_calib_axis *y)
+{
+    double gain, offset;
+
+    memset(cal, 0, sizeof(*cal));
+
+    indev_calib_axis_coef(x, &gain, &offset);
+    if (x->from_y)
+        cal->b = indev_calib_q16(gain);
+    else
+        cal->a = indev_calib_q16(gain);
+    cal->c = indev_calib_q16(offset);
+
+    indev_calib_axis_coef(y, &gain, &offset);
+    if (y->from_y)
+        cal->e = indev_calib_q16(gain);
+    else
+        cal->d = indev_calib_q16(gain);
+    cal->f = indev_calib_q16(offset);
+}
+
+static double det3(const double m[3][3])
+{
+    return m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) -
+           m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) +
+           m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+}
+
+/* Cramer's rule on the 3x3 normal equations */
+static void solve3(const double m[3][3], double det, const double r[3], double out[3])
+{
+    double t[3][3];
+
+    for (int col = 0; col < 3; col++) {
+        memcpy(t, m, sizeof(t));
+        for (int row = 0; row < 3; row++)
+            t[row][col] = r[row];
+        out[col] = det3(t) / det;
+    }
+}
+
+int indev_calib_solve(struct indev_calib *cal,
+                      const struct indev_calib_point *pts, int n)
+{
+    double m[3][3] = { { 0 } };
+    double rx[3] = { 0 }, ry[3] = { 0 };
+    double cx[3], cy[3];
+    double det, scale = 0;
+    int i;
+
+    if (n < 3)
+        return -1;
+
+    for (i = 0; i < n; i++) {
+        double x = pts[i].raw_x, y = pts[i].raw_y;
+
+        m[0][0] += x * x;
+        m[0][1] += x * y;
+        m[0][2] += x;
+        m[1][1] += y * y;
+        m[1][2] += y;
+
+        rx[0] += x * pts[i].scr_x;
+        rx[1] += y * pts[i].scr_x;
+        rx[2] += pts[i].scr_x;
+        ry[0] += x * pts[i].scr_y;
+        ry[1] += y * pts[i].scr_y;
+        ry[2] += pts[i].scr_y;
+    }
+    m[1][0] = m[0][1];
+    m[2][0] = m[0][2];
+    m[2][1] = m[1][2];
+    m[2][2] = n;
+
+    /* relative threshold, raw spans differ by orders of magnitude */
+    for (i = 0; i < 3; i++)
+        scale = fmax(scale, fabs(m[i][i]));
+    det = det3(m);
+    if (fabs(det) <= scale * scale * n * 1e-9)
+        return -1;
+
+    solve3(m, det, rx, cx);
+    solve3(m, det, ry, cy);
+
+    cal->a = indev_calib_q16(cx[0]);
+    cal->b = indev_calib_q16(cx[1]);
+    cal->c = indev_calib_q16(cx[2]);
+    cal->d = indev_calib_q16(cy[0]);
+    cal->e = indev_calib_q16(cy[1]);
+    cal->f = indev_calib_q16(cy[2]);
+    return 0;
+}
+
+int32_t indev_calib_max_error(const struct indev_calib *cal,
+                              const struct indev_calib_point *pts, int n)
+{
+    int32_t worst = 0;
+
+    for (int i = 0; i < n; i++) {
+        int64_t rx = pts[i].raw_x, ry = pts[i].raw_y;
+        int64_t x = (cal->a * rx + cal->b * ry + cal->c + (INDEV_CALIB_ONE >> 1)) >> INDEV_CALIB_SHIFT;
+        int64_t y = (cal->d * rx + cal->e * ry + cal->f + (INDEV_CALIB_ONE >> 1)) >> INDEV_CALIB_SHIFT;
+        int32_t err = (int32_t)lround(sqrt((double)((x - pts[i].scr_x) * (x - pts[i].scr_x) +
+                                                    (y - pts[i].scr_y) * (y - pts[i].scr_y))));
+
+        if (err > worst)
+            worst = err;
+    }
+
+    return worst;
+}
@@ -0,0 +1,266 @@
+// Copyright (c) 2024 embeddedboys developers
+
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+/*
+ * Touch calibration wizard.
+ *
+ * Shows crosshairs near the screen edges, averages the raw controller
+ * coordinates while each one is pressed and fits the affine matrix to
+ * them. LVGL still delivers the presses through the old calibration,
+ * which is fine as the wizard screen takes input anywhere.
+ */
+
+#define pr_fmt(fmt) "calib: " fmt
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lvgl/lvgl.h"
+
+#include "indev.h"
+#include "indev_calib.h"
+#include "indev_calib_ui.h"
+#include "console.h"
+#include "settings.h"
+#include "porting/lv_port_os.h"
+#include "debug.h"
+
+#define CALIB_MAX_POINTS    5
+#define CALIB_CROSS_LEN     21
+
+static struct {
+    lv_obj_t *scr;
+    lv_obj_t *prev;
+    lv_obj_t *label;
+    lv_obj_t *cross_h;
+    lv_obj_t *cross_v;
+
+    int nr_points;
+    int cur;
+    struct indev_calib_point pts[CALIB_MAX_POINTS];
+
+    int32_t sum_x, sum_y;
+    int samples;
+
+    indev_calib_ui_done_t done;
+} g_calib_ui;
+
+/* in tenths of the screen, corners first so 3 points span a triangle */
+static const uint8_t calib_targets[CALIB_MAX_POINTS][2] = {
+    { 1, 1 }, { 9, 5 }, { 5, 9 }, { 1, 9 }, { 9, 1 },
+};
+static const uint8_t calib_targets_5[CALIB_MAX_POINTS][2] = {
+    { 1, 1 }, { 9, 1 }, { 9, 9 }, { 1, 9 }, { 5, 5 },
+};
+
+static void calib_ui_show_target(void)
+{
+    const uint8_t (*t)[2] = g_calib_ui.nr_points == 5 ? calib_targets_5 : calib_targets;
+    struct indev_calib_point *p = &g_calib_ui.pts[g_calib_ui.cur];
+
+    p->scr_x = LCD_HOR_RES * t[g_calib_ui.cur][0] / 10;
+    p->scr_y = LCD_VER_RES * t[g_calib_ui.cur][1] / 10;
+
+    lv_obj_set_pos(g_calib_ui.cross_h, p->scr_x - CALIB_CROSS_LEN / 2, p->scr_y);
+    lv_obj_set_pos(g_calib_ui.cross_v, p->scr_x, p->scr_y - CALIB_CROSS_LEN / 2);
+
+    lv_label_set_text_fmt(g_calib_ui.label, "Touch the crosshair (%d/%d)",
+                          g_calib_ui.cur + 1, g_calib_ui.nr_points);
+}
+
+static void calib_ui_finish(int result)
+{
+    indev_calib_ui_done_t done = g_calib_ui.done;
+
+    lv_scr_load(g_calib_ui.prev);
+    lv_obj_del_async(g_calib_ui.scr);
+    g_calib_ui.scr = NULL;
+
+    if (done)
+        done(result);
+}
+
+static void calib_ui_fit(void)
+{
+    struct indev_calib cal;
+    int32_t err;
+
+    if (indev_calib_solve(&cal, g_calib_ui.pts, g_calib_ui.nr_points) < 0) {
+        pr_warn("points are collinear, again\n");
+        goto retry;
+    }
+
+    err = indev_calib_max_error(&cal, g_calib_ui.pts, g_calib_ui.nr_points);
+    if (err > INDEV_CALIB_UI_MAX_ERR) {
+        pr_warn("fit is off by %ld px, again\n", err);
+        goto retry;
+    }
+
+    pr_info("a %ld b %ld c %ld d %ld e %ld f %ld, max error %ld px\n",
+            cal.a, cal.b, cal.c, cal.d, cal.e, cal.f, err);
+    indev_set_calib(&cal);
+    settings_set(SETTINGS_KEY_TOUCH_CALIB, &cal, sizeof(cal));
+    calib_ui_finish(0);
+    return;
+
+retry:
+    g_calib_ui.cur = 0;
+    calib_ui_show_target();
+}
+
+static void calib_ui_event_cb(lv_event_t *e)
+{
+    struct indev_calib_point *p = &g_calib_ui.pts[g_calib_ui.cur];
+    u16 x, y;
+
+    switch (lv_event_get_code(e)) {
+    case LV_EVENT_PRESSED:
+        g_calib_ui.sum_x = 0;
+        g_calib_ui.sum_y = 0;
+        g_calib_ui.samples = -INDEV_CALIB_UI_SKIP;
+        break;
+
+    case LV_EVENT_PRESSING:
+        /* the first samples of a press are still settling */
+        if (g_calib_ui.samples++ < 0 || g_calib_ui.samples > INDEV_CALIB_UI_SAMPLES)
+            break;
+        indev_get_raw(&x, &y);
+        g_calib_ui.sum_x += x;
+        g_calib_ui.sum_y += y;
+        break;
+
+    case LV_EVENT_RELEASED:
+        if (g_calib_ui.samples > INDEV_CALIB_UI_SAMPLES)
+            g_calib_ui.samples = INDEV_CALIB_UI_SAMPLES;
+        if (g_calib_ui.samples < INDEV_CALIB_UI_SAMPLES / 2)
+            break;  /* too short a tap, keep this target */
+
+        p->raw_x = g_calib_ui.sum_x / g_calib_ui.samples;
+        p->raw_y = g_calib_ui.sum_y / g_calib_ui.samples;
+        pr_debug("target %d (%ld, %ld) raw (%ld, %ld)\n", g_calib_ui.cur,
+                 p->scr_x, p->scr_y, p->raw_x, p->raw_y);
+
+        if (++g_calib_ui.cur == g_calib_ui.nr_points)
+            calib_ui_fit();
+        else
+            calib_ui_show_target();
+        break;
+
+    default:
+        break;
+    }
+}
+
+static lv_obj_t *calib_ui_line(lv_obj_t *parent, lv_coord_t w, lv_coord_t h)
+{
+    lv_obj_t *obj = lv_obj_create(parent);
+
+    lv_obj_remove_style_all(obj);
+    lv_obj_set_size(obj, w, h);
+    lv_obj_set_style_bg_color(obj, lv_color_white(), 0);
+    lv_obj_set_style_bg_opa(obj, LV_OPA_COVER, 0);
+    lv_obj_clear_flag(obj, LV_OBJ_FLAG_CLICKABLE);
+
+    return obj;
+}
+
+int indev_calib_ui_start(int nr_points, indev_calib_ui_done_t done)
+{
+    if (g_calib_ui.scr)
+        return -1;
+    if (nr_points != 3 && nr_points != 5)
+        return -1;
+
+    g_calib_ui.nr_points = nr_points;
+    g_calib_ui.cur = 0;
+    g_calib_ui.done = done;
+    g_calib_ui.prev = lv_scr_act();
+
+    g_calib_ui.scr = lv_obj_create(NULL);
+    lv_obj_set_style_bg_color(g_calib_ui.scr, lv_color_black(), 0);
+    lv_obj_clear_flag(g_calib_ui.scr, LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_add_event_cb(g_calib_ui.scr, calib_ui_event_cb, LV_EVENT_ALL, NULL);
+
+    g_calib_ui.label = lv_label_create(g_calib_ui.scr);
+    lv_obj_set_style_text_color(g_calib_ui.label, lv_color_white(), 0);
+    lv_obj_center(g_calib_ui.label);
+
+    g_calib_ui.cross_h = calib_ui_line(g_calib_ui.scr, CALIB_CROSS_LEN, 1);
+    g_calib_ui.cross_v = calib_ui_line(g_calib_ui.scr, 1, CALIB_CROSS_LEN);
+
+    calib_ui_show_target();
+    lv_scr_load(g_calib_ui.scr);
+
+    return 0;
+}
+
+static void calib_ui_call(void *arg)
+{
+    indev_calib_ui_start((int)(intptr_t)arg, NULL);
+}
+
+static int calib_cmd(int argc, char **argv)
+{
+    struct indev_calib cal;
+
+    if (argc > 1 && !strcmp(argv[1], "reset")) {
+        indev_reset_calib();
+        settings_del(SETTINGS_KEY_TOUCH_CALIB);
+    } else if (argc > 1 && !strcmp(argv[1], "wizard")) {
+        int n = argc > 2 ? atoi(argv[2]) : 5;
+
+        if (n != 3 && n != 5) {
+            printf("usage: calib wizard [3|5]\n");
+            return -1;
+        }
+        /* LVGL objects belong to the LVGL task */
+        return lv_port_call(calib_ui_call, (void *)(intptr_t)n);
+    }
+
+    indev_get_calib(&cal);
+    printf("x' = (%ld * x + %ld * y + %ld) >> %d\n", cal.a, cal.b, cal.c, INDEV_CALIB_SHIFT);
+    printf("y' = (%ld * x + %ld * y + %ld) >> %d\n", cal.d, cal.e, cal.f, INDEV_CALIB_SHIFT);
+    return 0;
+}
+
+static const struct console_cmd calib_console_cmd = {
+    .name = "calib",
+    .help = "calib [reset|wizard [3|5]], touch calibration matrix",
+    .fn = calib_cmd,
+};
+
+void indev_calib_ui_load(void)
+{
+    struct indev_calib cal;
+
+    /* a matrix from an earlier wizard run replaces the driver's axis setup */
+    if (settings_get(SETTINGS_KEY_TOUCH_CALIB, &cal, sizeof(cal)) == sizeof(cal)) {
+        indev_set_calib(&cal);
+        pr_info("calibration loaded from flash\n");
+    }
+}
+
+void indev_calib_ui_init(void)
+{
+    console_register(&calib_console_cmd);
+}
@@ -0,0 +1,182 @@
+// Copyright (c) 2024 embeddedboys developers
+
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+/*
+ * Runtime touch controller detection.
+ *
+ * Every driver built in puts its spec in the table below. At boot only
+ * the addresses those specs name are probed, each with an ID register
+ * read that gives up after INDEV_DETECT_TIMEOUT_US (SPI controllers run
+ * their own check), and the first spec
+ * whose detect() recognizes the chip is handed to indev_probe(). One
+ * image then runs on every board variant, and a missing or stuck
+ * controller costs a few ms instead of a 128 address scan.
+ */
+
+#define pr_fmt(fmt) "indev: " fmt
+
+#include <stdio.h>
+
+#include "hardware/timer.h"
+
+#include "indev.h"
+#include "debug.h"
+
+#define INDEV_DETECT_SPEED      100000
+#define INDEV_DETECT_TIMEOUT_US 2000
+
+extern struct indev_spec gt911_spec;
+extern struct indev_spec ft6236_spec;
+extern struct indev_spec tsc2007_spec;
+extern struct indev_spec ns2009_spec;
+extern struct indev_spec xpt2046_spec;
+
+/*
+ * Controllers with an ID register first. TSC2007 and NS2009 both sit at
+ * 0x48 and have nothing to identify them by, the first one built in wins.
+ * XPT2046 shares the header pins with the I2C parts and switches them to
+ * SPI, so it goes last.
+ */
+static struct indev_spec *const g_indev_table[] = {
+#if INDEV_DRV_USE_GT911
+    &gt911_spec,
+#endif
+#if INDEV_DRV_USE_FT6236
+    &ft6236_spec,
+#endif
+#if INDEV_DRV_USE_TSC2007
+    &tsc2007_spec,
+#endif
+#if INDEV_DRV_USE_NS2009
+    &ns2009_spec,
+#endif
+#if INDEV_DRV_USE_XPT2046
+    &xpt2046_spec,
+#endif
+    NULL,
+};
+
+int indev_detect_xfer(struct indev_spec *spec, u8 addr, const u8 *tx, size_t tx_len,
+                      u8 *rx, size_t rx_len)
+{
+    i2c_inst_t *i2c = spec->i2c.master;
+    int ret;
+
+    if (tx_len) {
+        ret = i2c_write_timeout_us(i2c, addr, tx, tx_len, rx_len > 0, INDEV_DETECT_TIMEOUT_US);
+        if (ret < 0)
+            return ret;
+    }
+
+    if (rx_len) {
+        ret = i2c_read_timeout_us(i2c, addr, rx, rx_len, false, INDEV_DETECT_TIMEOUT_US);
+        if (ret < 0)
+            return ret;
+    }
+
+    return 0;
+}
+
+static void indev_detect_bus(struct indev_spec *spec)
+{
+    static i2c_inst_t *cur_i2c;
+    static u8 cur_scl, cur_sda;
+
+    /* most boards share one set of pins, set it up once */
+    if (cur_i2c == spec->i2c.master && cur_scl == spec->i2c.pin_scl &&
+        cur_sda == spec->i2c.pin_sda)
+        return;
+
+    i2c_init(spec->i2c.master, INDEV_DETECT_SPEED);
+    gpio_set_function(spec->i2c.pin_scl, GPIO_FUNC_I2C);
+    gpio_set_function(spec->i2c.pin_sda, GPIO_FUNC_I2C);
+    gpio_pull_up(spec->i2c.pin_scl);
+    gpio_pull_up(spec->i2c.pin_sda);
+
+    cur_i2c = spec->i2c.master;
+    cur_scl = spec->i2c.pin_scl;
+    cur_sda = spec->i2c.pin_sda;
+}
+
+static bool indev_detect_one(struct indev_spec *spec)
+{
+    const u8 addrs[] = { spec->i2c.addr, spec->i2c.addr_alt };
+    u8 dummy;
+    int i;
+
+    for (i = 0; i < ARRAY_SIZE(addrs); i++) {
+        if (!addrs[i])
+            continue;
+
+        if (spec->detect ? spec->detect(spec, addrs[i])
+                         : indev_detect_xfer(spec, addrs[i], NULL, 0, &dummy, 1) == 0) {
+            spec->i2c.addr = addrs[i];
+            return true;
+        }
+    }
+
+    return false;
+}
+
+struct indev_spec *indev_detect(void)
+{
+    struct indev_spec *const *p;
+    struct indev_spec *found = NULL;
+    u32 start = time_us_32();
+
+    for (p = g_indev_table; *p; p++) {
+        /* SPI controllers sit on their own bus and check themselves */
+        if ((*p)->spi.master) {
+            if (!(*p)->detect || (*p)->detect(*p, 0)) {
+                found = *p;
+                break;
+            }
+            continue;
+        }
+
+        indev_detect_bus(*p);
+        if (indev_detect_one(*p)) {
+            found = *p;
+            break;
+        }
+    }
+
+    if (found)
+        pr_info("%s detected in %lu us\n", found->name, time_us_32() - start);
+    else
+        pr_warn("no touch controller found in %lu us\n", time_us_32() - start);
+
+    return found;
+}
+
+int indev_driver_init(void)
+{
+    struct indev_spec *spec;
+
+    pr_debug("%s\n", __func__);
+
+    spec = indev_detect();
+    if (!spec)
+        return -1;
+
+    return indev_probe(spec);
+}
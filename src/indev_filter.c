@@ -0,0 +1,140 @@
+// Copyright (c) 2024 embeddedboys developers
+
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+/*
+ * Resistive touch filtering.
+ *
+ * Median of N conversions against spikes, Z1/Z2 pressure validation
+ * against the half-pressed edge of a stroke, and a fixed point one-euro
+ * filter against jitter that still follows fast moves.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "indev_filter.h"
+
+/* 1 / (2 * pi) in us * mHz */
+#define ONE_EURO_TAU_NUM    159154943u
+
+void indev_filter_init(struct indev_filter *f, const struct indev_filter_cfg *cfg)
+{
+    memset(f, 0, sizeof(*f));
+    f->cfg = cfg;
+}
+
+uint16_t indev_filter_median(uint16_t *v, int n)
+{
+    /* insertion sort, n is tiny */
+    for (int i = 1; i < n; i++) {
+        uint16_t t = v[i];
+        int j = i - 1;
+
+        while (j >= 0 && v[j] > t) {
+            v[j + 1] = v[j];
+            j--;
+        }
+        v[j + 1] = t;
+    }
+
+    return v[n / 2];
+}
+
+bool indev_filter_pressure_ok(const struct indev_filter_cfg *cfg,
+                              uint16_t x, uint16_t z1, uint16_t z2)
+{
+    uint32_t rt;
+
+    if (z1 < cfg->z1_min)
+        return false;
+
+    /* controllers without Z2 only get the Z1 threshold */
+    if (!cfg->rt_max_ohms || !z2 || z2 <= z1)
+        return true;
+
+    rt = (uint32_t)(z2 - z1) * x;
+    rt = (uint32_t)(((uint64_t)rt * cfg->x_plate_ohms / z1 + 2047) >> 12);
+
+    return rt <= cfg->rt_max_ohms;
+}
+
+void indev_filter_reset(struct indev_filter *f)
+{
+    f->primed = false;
+}
+
+/* smoothing factor for cutoff fc over dt, Q16 */
+static int32_t one_euro_alpha(uint32_t fc_mhz, uint32_t dt_us)
+{
+    uint32_t tau_us;
+
+    if (!fc_mhz)
+        return 1 << 16;
+
+    tau_us = ONE_EURO_TAU_NUM / fc_mhz;
+    return (int32_t)(((uint64_t)dt_us << 16) / (dt_us + tau_us));
+}
+
+static uint16_t one_euro_step(const struct indev_filter_cfg *cfg,
+                              struct indev_filter_axis *a, uint16_t v, uint32_t dt_us)
+{
+    int32_t target = (int32_t)v << 16;
+    int32_t dx, alpha;
+    uint32_t fc;
+
+    /* speed of the raw input against the last estimate, px/s */
+    dx = (int32_t)(((int64_t)(target - a->x) * 1000000 / dt_us) >> 16);
+    alpha = one_euro_alpha(cfg->dcutoff_mhz, dt_us);
+    a->dx += (int32_t)(((int64_t)(dx - a->dx) * alpha) >> 16);
+
+    fc = cfg->min_cutoff_mhz + cfg->beta_mhz * (uint32_t)abs(a->dx);
+    alpha = one_euro_alpha(fc, dt_us);
+    a->x += (int32_t)(((int64_t)(target - a->x) * alpha) >> 16);
+
+    return (uint16_t)((a->x + (1 << 15)) >> 16);
+}
+
+void indev_filter_smooth(struct indev_filter *f, uint16_t *x, uint16_t *y, uint32_t now_us)
+{
+    uint32_t dt;
+
+    if (!f->cfg->min_cutoff_mhz)
+        return;
+
+    if (!f->primed) {
+        f->ax.x = (int32_t)*x << 16;
+        f->ay.x = (int32_t)*y << 16;
+        f->ax.dx = 0;
+        f->ay.dx = 0;
+        f->last_us = now_us;
+        f->primed = true;
+        return;
+    }
+
+    dt = now_us - f->last_us;
+    if (!dt)
+        dt = 1;
+    f->last_us = now_us;
+
+    *x = one_euro_step(f->cfg, &f->ax, *x, dt);
+    *y = one_euro_step(f->cfg, &f->ay, *y, dt);
+}
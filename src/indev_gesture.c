@@ -0,0 +1,136 @@
+// Copyright (c) 2024 embeddedboys developers
+
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+/*
+ * Two finger gesture recognizer.
+ *
+ * Works on the multi-touch frames from the touch task. The first two
+ * track ids seen together are followed until either finger lifts, scale
+ * and angle are relative to where the fingers came down. Pinch and rotate
+ * are reported once the movement leaves the slop, both can be active at
+ * the same time.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "indev_gesture.h"
+
+static const struct indev_point *indev_gesture_find(const struct indev_frame *frame, uint8_t id)
+{
+    for (int i = 0; i < frame->nr; i++)
+        if (frame->pt[i].id == id)
+            return &frame->pt[i];
+
+    return NULL;
+}
+
+static void indev_gesture_measure(const struct indev_point *a, const struct indev_point *b,
+                                  float *dist, float *angle)
+{
+    float dx = (float)b->x - (float)a->x;
+    float dy = (float)b->y - (float)a->y;
+
+    *dist = sqrtf(dx * dx + dy * dy);
+    /* screen y grows downwards, flip it so positive is counter clockwise */
+    *angle = atan2f(-dy, dx) * (180.0f / (float)M_PI);
+}
+
+void indev_gesture_reset(struct indev_gesture_ctx *ctx)
+{
+    memset(ctx, 0, sizeof(*ctx));
+}
+
+bool indev_gesture_update(struct indev_gesture_ctx *ctx,
+                          const struct indev_frame *frame,
+                          struct indev_gesture *g)
+{
+    const struct indev_point *a, *b;
+    float dist, angle;
+
+    if (ctx->tracking) {
+        a = indev_gesture_find(frame, ctx->id[0]);
+        b = indev_gesture_find(frame, ctx->id[1]);
+
+        if (!a || !b) {
+            bool report = ctx->begun;
+
+            if (report) {
+                *g = ctx->last;
+                g->state = INDEV_GESTURE_END;
+            }
+            indev_gesture_reset(ctx);
+            return report;
+        }
+    } else {
+        if (frame->nr < 2)
+            return false;
+
+        a = &frame->pt[0];
+        b = &frame->pt[1];
+        /* keep the pair ordered so the angle does not flip by 180 */
+        if (a->id > b->id) {
+            const struct indev_point *t = a;
+            a = b;
+            b = t;
+        }
+
+        indev_gesture_measure(a, b, &dist, &angle);
+        if (dist < INDEV_GESTURE_MIN_DIST)
+            return false;
+
+        ctx->tracking = true;
+        ctx->begun = false;
+        ctx->type = 0;
+        ctx->id[0] = a->id;
+        ctx->id[1] = b->id;
+        ctx->dist0 = dist;
+        ctx->angle0 = angle;
+        return false;
+    }
+
+    indev_gesture_measure(a, b, &dist, &angle);
+
+    g->scale = dist / ctx->dist0;
+    g->angle = angle - ctx->angle0;
+    if (g->angle > 180.0f)
+        g->angle -= 360.0f;
+    else if (g->angle < -180.0f)
+        g->angle += 360.0f;
+
+    if (fabsf(g->scale - 1.0f) > INDEV_GESTURE_PINCH_SLOP)
+        ctx->type |= INDEV_GESTURE_PINCH;
+    if (fabsf(g->angle) > INDEV_GESTURE_ROTATE_SLOP)
+        ctx->type |= INDEV_GESTURE_ROTATE;
+
+    if (!ctx->type)
+        return false;
+
+    g->type = ctx->type;
+    g->state = ctx->begun ? INDEV_GESTURE_UPDATE : INDEV_GESTURE_BEGIN;
+    g->cx = (a->x + b->x) / 2;
+    g->cy = (a->y + b->y) / 2;
+
+    ctx->begun = true;
+    ctx->last = *g;
+    return true;
+}
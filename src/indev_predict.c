@@ -0,0 +1,137 @@
+// Copyright (c) 2024 embeddedboys developers
+
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+
+/*
+ * Drag prediction.
+ *
+ * A sample reaches the glass one to two frames after it was taken, so a
+ * dragged object trails the finger. The newest three samples give a
+ * velocity and an acceleration per axis, the position is extrapolated
+ * by the sample's age plus the pipeline lead:
+ *
+ *   p = p0 + v * T + accel_pct / 100 * a * T^2 / 2
+ *
+ * The extrapolated distance is clamped to max_px and never points back
+ * against the current direction of motion, so a finger that stops or
+ * turns costs at most a short overshoot that the next sample corrects.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "indev_predict.h"
+
+void indev_predict_reset(struct indev_predict *p)
+{
+    p->n = 0;
+}
+
+void indev_predict_push(struct indev_predict *p, uint32_t ts, int16_t x, int16_t y)
+{
+    /* a repeated sample carries no motion */
+    if (p->n && p->hist[0].ts == ts)
+        return;
+
+    memmove(&p->hist[1], &p->hist[0], sizeof(p->hist[0]) * (INDEV_PREDICT_HISTORY - 1));
+    p->hist[0].ts = ts;
+    p->hist[0].x = x;
+    p->hist[0].y = y;
+
+    if (p->n < INDEV_PREDICT_HISTORY)
+        p->n++;
+}
+
+/* px/s from b to a */
+static int32_t indev_predict_speed(int16_t a, int16_t b, uint32_t dt)
+{
+    return (int32_t)((int64_t)(a - b) * 1000000 / dt);
+}
+
+/* extrapolated offset in px along one axis */
+static int32_t indev_predict_axis(const struct indev_predict_cfg *cfg, int32_t v, int32_t a,
+                                  uint32_t t)
+{
+    int64_t off;
+
+    off = (int64_t)v * t / 1000000;
+    off += (int64_t)a * cfg->accel_pct / 100 * t / 1000 * t / 1000 / 2000000;
+
+    /* decelerating: stop at the turning point instead of going back */
+    if ((v > 0 && off < 0) || (v < 0 && off > 0) || v == 0)
+        off = 0;
+
+    if (off > cfg->max_px)
+        off = cfg->max_px;
+    if (off < -(int64_t)cfg->max_px)
+        off = -(int64_t)cfg->max_px;
+
+    return (int32_t)off;
+}
+
+bool indev_predict_get(const struct indev_predict *p, const struct indev_predict_cfg *cfg,
+                       uint32_t now_us, uint32_t lead_us, int16_t *x, int16_t *y)
+{
+    const struct indev_predict_sample *s0 = &p->hist[0];
+    const struct indev_predict_sample *s1 = &p->hist[1];
+    const struct indev_predict_sample *s2 = &p->hist[2];
+    int32_t vx, vy, vx1, vy1, ax = 0, ay = 0;
+    uint32_t dt0, dt1, age;
+
+    if (!p->n)
+        return false;
+
+    *x = s0->x;
+    *y = s0->y;
+
+    if (p->n < 2)
+        return false;
+
+    age = now_us - s0->ts;
+    if (age > cfg->stale_us)
+        return false;
+
+    dt0 = s0->ts - s1->ts;
+    if (!dt0)
+        return false;
+
+    vx = indev_predict_speed(s0->x, s1->x, dt0);
+    vy = indev_predict_speed(s0->y, s1->y, dt0);
+    if ((uint32_t)(abs(vx) + abs(vy)) < cfg->min_speed)
+        return false;
+
+    if (p->n >= 3 && cfg->accel_pct) {
+        dt1 = s1->ts - s2->ts;
+        if (dt1) {
+            vx1 = indev_predict_speed(s1->x, s2->x, dt1);
+            vy1 = indev_predict_speed(s1->y, s2->y, dt1);
+            /* the speeds belong to the middles of their intervals */
+            ax = (int32_t)((int64_t)(vx - vx1) * 2000000 / (dt0 + dt1));
+            ay = (int32_t)((int64_t)(vy - vy1) * 2000000 / (dt0 + dt1));
+        }
+    }
+
+    *x = s0->x + indev_predict_axis(cfg, vx, ax, age + lead_us);
+    *y = s0->y + indev_predict_axis(cfg, vy, ay, age + lead_us);
+
+    return true;
+}
@@ -0,0 +1,391 @@
+// Copyright (c) 2024 embeddedboys developers
+
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+/*
+ * Touch record and replay.
+ *
+ * The recorder keeps the pointer state LVGL was given, one event per
+ * change, with ms timestamps. Playback takes over the pointer device's
+ * read_cb and hands the events back at their original time: the read
+ * timer period is set to the gap to the next event, so the LVGL task
+ * sleeps in between like it does with a real finger. Frames rendered
+ * during playback are counted through the display monitor_cb, which
+ * makes a recording a repeatable benchmark.
+ *
+ * Only LVGL is needed, the console glue is left out off target.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "indev_replay.h"
+
+#if INDEV_REPLAY_ENABLED
+
+enum {
+    REPLAY_IDLE,
+    REPLAY_RECORDING,
+    REPLAY_PLAYING,
+};
+
+static struct {
+    struct indev_replay_event events[INDEV_REPLAY_MAX_EVENTS];
+    uint32_t n;
+    uint8_t  state;
+    bool     echo;
+
+    /* recording */
+    uint32_t start;
+    struct indev_replay_event last;
+
+    /* playback */
+    uint32_t pos;
+    struct indev_replay_event cur;
+    lv_indev_t *indev;
+    uint32_t saved_period;
+
+    struct indev_replay_stats stats;
+} g_replay;
+
+void indev_replay_clear(void)
+{
+    g_replay.n = 0;
+}
+
+int indev_replay_add(uint32_t t, int16_t x, int16_t y, bool pressed)
+{
+    struct indev_replay_event *e;
+
+    if (g_replay.n >= INDEV_REPLAY_MAX_EVENTS)
+        return -1;
+    /* playback relies on the order */
+    if (g_replay.n && t < g_replay.events[g_replay.n - 1].t)
+        return -1;
+
+    e = &g_replay.events[g_replay.n++];
+    e->t = t;
+    e->x = x;
+    e->y = y;
+    e->pressed = pressed;
+    return 0;
+}
+
+int indev_replay_swipe(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint32_t ms)
+{
+    const uint32_t step = 10;   /* like a controller sampling at 100 Hz */
+    uint32_t t0 = g_replay.n ? g_replay.events[g_replay.n - 1].t + 100 : 0;
+    uint32_t t;
+
+    if (!ms)
+        return -1;
+
+    for (t = 0; t <= ms; t += step) {
+        int16_t x = x0 + (int32_t)(x1 - x0) * (int32_t)t / (int32_t)ms;
+        int16_t y = y0 + (int32_t)(y1 - y0) * (int32_t)t / (int32_t)ms;
+
+        if (indev_replay_add(t0 + t, x, y, true))
+            return -1;
+    }
+
+    return indev_replay_add(t0 + ms + step, x1, y1, false);
+}
+
+void indev_replay_record_start(bool echo)
+{
+    if (g_replay.state != REPLAY_IDLE)
+        return;
+
+    indev_replay_clear();
+    g_replay.echo = echo;
+    memset(&g_replay.last, 0, sizeof(g_replay.last));
+    g_replay.start = lv_tick_get();
+    g_replay.state = REPLAY_RECORDING;
+}
+
+void indev_replay_record_stop(void)
+{
+    if (g_replay.state == REPLAY_RECORDING)
+        g_replay.state = REPLAY_IDLE;
+}
+
+bool indev_replay_recording(void)
+{
+    return g_replay.state == REPLAY_RECORDING;
+}
+
+void indev_replay_record(const lv_indev_data_t *data)
+{
+    bool pressed = data->state == LV_INDEV_STATE_PR;
+
+    if (g_replay.state != REPLAY_RECORDING)
+        return;
+
+    /* only changes, a held finger is one event */
+    if (g_replay.n && g_replay.last.pressed == pressed &&
+        g_replay.last.x == data->point.x && g_replay.last.y == data->point.y)
+        return;
+
+    /* a full buffer ends the recording */
+    if (indev_replay_add(lv_tick_elaps(g_replay.start), data->point.x, data->point.y, pressed)) {
+        g_replay.state = REPLAY_IDLE;
+        return;
+    }
+
+    g_replay.last = g_replay.events[g_replay.n - 1];
+    if (g_replay.echo)
+        printf("%u %d %d %u\n", (unsigned)g_replay.last.t, g_replay.last.x,
+               g_replay.last.y, g_replay.last.pressed);
+}
+
+static lv_indev_t *indev_replay_find_pointer(void)
+{
+    lv_indev_t *indev = NULL;
+
+    while ((indev = lv_indev_get_next(indev)) != NULL)
+        if (indev->driver->type == LV_INDEV_TYPE_POINTER)
+            return indev;
+
+    return NULL;
+}
+
+int indev_replay_play(void)
+{
+    lv_timer_t *timer;
+
+    if (g_replay.state != REPLAY_IDLE || !g_replay.n)
+        return -1;
+
+    g_replay.indev = indev_replay_find_pointer();
+    if (!g_replay.indev)
+        return -1;
+
+    memset(&g_replay.stats, 0, sizeof(g_replay.stats));
+    memset(&g_replay.cur, 0, sizeof(g_replay.cur));
+    g_replay.pos = 0;
+    g_replay.start = lv_tick_get();
+    g_replay.state = REPLAY_PLAYING;
+
+    timer = g_replay.indev->driver->read_timer;
+    g_replay.saved_period = timer->period;
+    lv_timer_set_period(timer, 1);
+    lv_timer_resume(timer);
+    lv_timer_ready(timer);
+    return 0;
+}
+
+bool indev_replay_playing(void)
+{
+    return g_replay.state == REPLAY_PLAYING;
+}
+
+void indev_replay_stop(void)
+{
+    if (g_replay.state != REPLAY_PLAYING)
+        return;
+
+    g_replay.state = REPLAY_IDLE;
+    g_replay.stats.events = g_replay.pos;
+    g_replay.stats.duration_ms = lv_tick_elaps(g_replay.start);
+    lv_timer_set_period(g_replay.indev->driver->read_timer, g_replay.saved_period);
+
+    printf("replay: %u events in %u ms, %u frames, render avg %u ms max %u ms\n",
+                (unsigned)g_replay.stats.events, (unsigned)g_replay.stats.duration_ms,
+                (unsigned)g_replay.stats.frames,
+                (unsigned)(g_replay.stats.frames ? g_replay.stats.render_ms / g_replay.stats.frames : 0),
+                (unsigned)g_replay.stats.render_max_ms);
+}
+
+void indev_replay_read(lv_indev_drv_t *drv, lv_indev_data_t *data)
+{
+    uint32_t elapsed = lv_tick_elaps(g_replay.start);
+    struct indev_replay_event *next;
+
+    if (g_replay.state == REPLAY_PLAYING && g_replay.pos < g_replay.n &&
+        g_replay.events[g_replay.pos].t <= elapsed)
+        g_replay.cur = g_replay.events[g_replay.pos++];
+
+    data->point.x = g_replay.cur.x;
+    data->point.y = g_replay.cur.y;
+    data->state = g_replay.cur.pressed ? LV_INDEV_STATE_PR : LV_INDEV_STATE_REL;
+    data->continue_reading = false;
+
+    if (g_replay.state != REPLAY_PLAYING)
+        return;
+
+    if (g_replay.pos == g_replay.n) {
+        indev_replay_stop();
+        return;
+    }
+
+    next = &g_replay.events[g_replay.pos];
+    if (next->t <= elapsed) {
+        /* behind schedule, let LVGL see every event anyway */
+        data->continue_reading = true;
+    } else {
+        /* sleep until the next event is due */
+        lv_timer_set_period(drv->read_timer, next->t - elapsed);
+    }
+}
+
+void indev_replay_frame(uint32_t time_ms, uint32_t px)
+{
+    if (g_replay.state != REPLAY_PLAYING)
+        return;
+
+    g_replay.stats.frames++;
+    g_replay.stats.render_ms += time_ms;
+    g_replay.stats.px += px;
+    if (time_ms > g_replay.stats.render_max_ms)
+        g_replay.stats.render_max_ms = time_ms;
+}
+
+void indev_replay_get_stats(struct indev_replay_stats *stats)
+{
+    *stats = g_replay.stats;
+}
+
+void indev_replay_dump(void)
+{
+    printf("# replay begin %u\n", (unsigned)g_replay.n);
+    for (uint32_t i = 0; i < g_replay.n; i++)
+        printf("%u %d %d %u\n", (unsigned)g_replay.events[i].t, g_replay.events[i].x,
+               g_replay.events[i].y, g_replay.events[i].pressed);
+    printf("# replay end\n");
+}
+
+#if PICO_ON_DEVICE
+
+#include "console.h"
+#include "porting/lv_port_os.h"
+
+/* the event list and LVGL state belong to the LVGL task */
+static struct {
+    uint32_t ms;
+    int16_t x0, y0, x1, y1;
+    bool pressed;
+} replay_args;
+
+static void replay_call_rec(void *arg)
+{
+    indev_replay_record_start((bool)(intptr_t)arg);
+}
+
+static void replay_call_clear(void *arg)
+{
+    if (indev_replay_playing())
+        printf("replay: busy\n");
+    else
+        indev_replay_clear();
+}
+
+static void replay_call_add(void *arg)
+{
+    if (indev_replay_add(replay_args.ms, replay_args.x0, replay_args.y0, replay_args.pressed))
+        printf("replay: event rejected\n");
+}
+
+static void replay_call_swipe(void *arg)
+{
+    if (indev_replay_swipe(replay_args.x0, replay_args.y0, replay_args.x1, replay_args.y1,
+                           replay_args.ms))
+        printf("replay: swipe rejected\n");
+}
+
+static void replay_call_play(void *arg)
+{
+    if (indev_replay_play())
+        printf("replay: nothing to play\n");
+}
+
+static void replay_call_stop(void *arg)
+{
+    indev_replay_stop();
+    indev_replay_record_stop();
+}
+
+static int replay_cmd(int argc, char **argv)
+{
+    struct indev_replay_stats st;
+    const char *op = argc > 1 ? argv[1] : "";
+
+    if (!strcmp(op, "rec")) {
+        return lv_port_call(replay_call_rec,
+                            (void *)(intptr_t)(argc > 2 && !strcmp(argv[2], "echo")));
+    } else if (!strcmp(op, "stop")) {
+        return lv_port_call(replay_call_stop, NULL);
+    } else if (!strcmp(op, "play")) {
+        return lv_port_call(replay_call_play, NULL);
+    } else if (!strcmp(op, "clear")) {
+        return lv_port_call(replay_call_clear, NULL);
+    } else if (!strcmp(op, "dump")) {
+        indev_replay_dump();
+    } else if (!strcmp(op, "add") && argc == 6) {
+        replay_args.ms = strtoul(argv[2], NULL, 0);
+        replay_args.x0 = atoi(argv[3]);
+        replay_args.y0 = atoi(argv[4]);
+        replay_args.pressed = atoi(argv[5]);
+        return lv_port_call(replay_call_add, NULL);
+    } else if (!strcmp(op, "swipe") && argc == 7) {
+        replay_args.x0 = atoi(argv[2]);
+        replay_args.y0 = atoi(argv[3]);
+        replay_args.x1 = atoi(argv[4]);
+        replay_args.y1 = atoi(argv[5]);
+        replay_args.ms = strtoul(argv[6], NULL, 0);
+        if (!replay_args.ms)
+            return -1;
+        return lv_port_call(replay_call_swipe, NULL);
+    } else if (!strcmp(op, "stats")) {
+        indev_replay_get_stats(&st);
+        printf("%u events in %u ms, %u frames, render %u ms total %u ms max, %u px\n",
+               (unsigned)st.events, (unsigned)st.duration_ms, (unsigned)st.frames,
+               (unsigned)st.render_ms, (unsigned)st.render_max_ms, (unsigned)st.px);
+    } else {
+        printf("replay rec [echo]|stop|play|clear|dump|stats\n"
+               "replay add <ms> <x> <y> <pressed>\n"
+               "replay swipe <x0> <y0> <x1> <y1> <ms>\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+static const struct console_cmd replay_console_cmd = {
+    .name = "replay",
+    .help = "replay rec|stop|play|clear|dump|stats|add|swipe, touch record/replay",
+    .fn = replay_cmd,
+};
+
+void indev_replay_init(void)
+{
+    console_register(&replay_console_cmd);
+}
+
+#else
+
+void indev_replay_init(void)
+{
+}
+
+#endif /* PICO_ON_DEVICE */
+
+#endif /* INDEV_REPLAY_ENABLED */
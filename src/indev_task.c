@@ -0,0 +1,232 @@
+// Copyright (c) 2024 embeddedboys developers
+
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+/*
+ * Touch acquisition task.
+ *
+ * Bus I/O to the touch controller happens here instead of in LVGL's
+ * read_cb. The task sleeps until the controller's INT pin fires (or polls
+ * when there is none), samples every INDEV_TASK_PERIOD_MS while pressed
+ * and pushes timestamped samples into a single producer / single consumer
+ * ring that the LVGL task drains.
+ */
+
+#define pr_fmt(fmt) "indev_task: " fmt
+
+#include <stdio.h>
+
+#include "pico/stdlib.h"
+#include "hardware/gpio.h"
+#include "hardware/sync.h"
+#include "hardware/timer.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "indev.h"
+#include "indev_task.h"
+#include "bringup.h"
+#include "rtos_alloc.h"
+#include "lowpower.h"
+#include "trace.h"
+#include "latency.h"
+#include "debug.h"
+
+#if (INDEV_TASK_RING_SIZE & (INDEV_TASK_RING_SIZE - 1))
+#error "INDEV_TASK_RING_SIZE must be a power of two"
+#endif
+
+static struct {
+    struct indev_sample ring[INDEV_TASK_RING_SIZE];
+    volatile uint32_t head;     /* written by the touch task only */
+    volatile uint32_t tail;     /* written by the consumer only */
+
+    TaskHandle_t task;
+    void (*notify)(void);
+    int pin_irq;
+
+    struct indev_task_stats stats;
+} g_indev_task;
+
+static bool indev_task_push(const struct indev_sample *s)
+{
+    uint32_t head = g_indev_task.head;
+
+    if (head - g_indev_task.tail >= INDEV_TASK_RING_SIZE)
+        return false;
+
+    g_indev_task.ring[head & (INDEV_TASK_RING_SIZE - 1)] = *s;
+    __dmb();    /* publish the slot before the index */
+    g_indev_task.head = head + 1;
+    return true;
+}
+
+bool indev_task_pop(struct indev_sample *s)
+{
+    uint32_t tail = g_indev_task.tail;
+
+    if (tail == g_indev_task.head)
+        return false;
+
+    __dmb();
+    *s = g_indev_task.ring[tail & (INDEV_TASK_RING_SIZE - 1)];
+    __dmb();    /* done reading before handing the slot back */
+    g_indev_task.tail = tail + 1;
+    return true;
+}
+
+bool indev_task_empty(void)
+{
+    return g_indev_task.tail == g_indev_task.head;
+}
+
+void indev_task_get_stats(struct indev_task_stats *stats)
+{
+    *stats = g_indev_task.stats;
+}
+
+static void indev_task_irq(uint gpio, uint32_t events)
+{
+    BaseType_t woken = pdFALSE;
+
+    g_indev_task.stats.irqs++;
+    lowpower_touch_wake();
+    latency_mark(LATENCY_IRQ);
+
+    if (g_indev_task.task) {
+        vTaskNotifyGiveFromISR(g_indev_task.task, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+}
+
+static void indev_task_queue(struct indev_sample *s)
+{
+    g_indev_task.stats.samples++;
+
+    /* a lost press sample is fine, a lost release leaves a stuck touch */
+    while (!indev_task_push(s)) {
+        if (s->pressed) {
+            g_indev_task.stats.dropped++;
+            return;
+        }
+        vTaskDelay(1);
+    }
+
+    if (g_indev_task.notify)
+        g_indev_task.notify();
+}
+
+static portTASK_FUNCTION(indev_task, pvParameters)
+{
+    struct indev_sample s = { 0 };
+    bool was_pressed = false;
+    int ret;
+
+    /* the controller resets and probes here, in parallel with the panel */
+    if (bringup_run(BRINGUP_TOUCH)) {
+        g_indev_task.task = NULL;
+        vTaskDelete(NULL);
+    }
+
+    g_indev_task.pin_irq = indev_get_irq_pin();
+    /* drivers differ in INT polarity, any edge is worth a read */
+    if (g_indev_task.pin_irq != INDEV_PIN_NONE)
+        gpio_set_irq_enabled_with_callback(g_indev_task.pin_irq,
+                                           GPIO_IRQ_EDGE_FALL | GPIO_IRQ_EDGE_RISE,
+                                           true, indev_task_irq);
+
+    for (;;) {
+        if (g_indev_task.pin_irq != INDEV_PIN_NONE)
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        else
+            vTaskDelay(pdMS_TO_TICKS(INDEV_TASK_POLL_MS));
+
+        for (;;) {
+            /*
+             * Edges up to here are covered by the read below, anything
+             * after it stays pending and brings us straight back.
+             */
+            ulTaskNotifyTake(pdTRUE, 0);
+
+            trace_span_begin(TRACE_SPAN_TOUCH_READ);
+            if (indev_has_frame()) {
+                ret = indev_read_frame(&s.frame);
+                if (ret < 0) {
+                    /* bus error, report a release rather than a stuck touch */
+                    s.frame.nr = 0;
+                    s.pressed = false;
+                } else if (ret == 0) {
+                    s.pressed = s.frame.nr > 0;
+                    if (s.pressed) {
+                        s.x = s.frame.pt[0].x;
+                        s.y = s.frame.pt[0].y;
+                    }
+                }
+                /* INDEV_FRAME_NONE, nothing new yet, keep the previous frame */
+            } else {
+                s.pressed = indev_is_pressed();
+                if (s.pressed)
+                    indev_read_point(&s.x, &s.y);
+                s.frame.nr = s.pressed ? 1 : 0;
+                s.frame.pt[0].id = 0;
+                s.frame.pt[0].x = s.x;
+                s.frame.pt[0].y = s.y;
+                s.frame.pt[0].size = 0;
+            }
+            trace_span_end(TRACE_SPAN_TOUCH_READ);
+
+            /* controllers without INT only notice the touch here */
+            if (s.pressed && !was_pressed)
+                lowpower_touch_wake();
+
+            /* releases keep the last pressed coordinates */
+            s.ts = time_us_32();
+            if (s.pressed || was_pressed)
+                indev_task_queue(&s);
+            if (s.pressed && !was_pressed)
+                latency_mark(LATENCY_SAMPLE);
+
+            was_pressed = s.pressed;
+            if (!s.pressed)
+                break;
+
+            vTaskDelay(pdMS_TO_TICKS(INDEV_TASK_PERIOD_MS));
+        }
+    }
+
+    vTaskDelete(NULL);
+}
+
+void indev_task_set_notify(void (*notify)(void))
+{
+    g_indev_task.notify = notify;
+}
+
+int indev_task_init(void)
+{
+    g_indev_task.pin_irq = INDEV_PIN_NONE;
+
+    rtos_task_create(indev_task, "indev_task", 512, NULL, (tskIDLE_PRIORITY + 4), &g_indev_task.task);
+    /* keep the bus waits off the rendering core, the GPIO IRQ follows the task */
+    vTaskCoreAffinitySet(g_indev_task.task, (1 << 1));
+
+    return 0;
+}
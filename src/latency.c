@@ -0,0 +1,266 @@
+// Copyright (c) 2024 embeddedboys developers
+
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+/*
+ * Touch-to-photon latency.
+ *
+ * Each finger-down arms a measurement at the touch INT edge. The touch
+ * task, read_cb, the indev feedback callback, disp_flush and the flush
+ * DMA completion then timestamp their stage in order. A measurement that
+ * reaches LATENCY_DONE goes into a small history, the "lat" console
+ * command prints percentiles per stage and a histogram end to end.
+ */
+
+#define pr_fmt(fmt) "latency: " fmt
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+#include "hardware/timer.h"
+
+#include "latency.h"
+#include "console.h"
+#include "porting/lv_port_os.h"
+#include "debug.h"
+
+#if LATENCY_ENABLED
+
+/* histogram of the end to end latency */
+#define LATENCY_HIST_BUCKET_US  2000
+#define LATENCY_HIST_BUCKETS    25
+#define LATENCY_HIST_WIDTH      40
+
+/*
+ * An INT edge that got no pressed sample within this long was a release
+ * or a spurious edge, the next edge arms again.
+ */
+#define LATENCY_ARM_US          50000
+
+static const char *const latency_stage_names[LATENCY_NR_STAGES] = {
+    [LATENCY_IRQ]    = "irq",
+    [LATENCY_SAMPLE] = "sample",
+    [LATENCY_READ]   = "read_cb",
+    [LATENCY_EVENT]  = "event",
+    [LATENCY_FLUSH]  = "flush",
+    [LATENCY_DONE]   = "dma done",
+};
+
+static struct {
+    spin_lock_t *lock;
+
+    int cur;                            /* last stage taken, -1 when idle */
+    uint32_t t[LATENCY_NR_STAGES];
+
+    /* us since LATENCY_IRQ for every stage */
+    uint32_t hist[LATENCY_HISTORY][LATENCY_NR_STAGES];
+    uint32_t head;
+    uint32_t count;
+    uint32_t timeouts;
+} g_latency = { .cur = -1 };
+
+void latency_mark(enum latency_stage stage)
+{
+    uint32_t now = time_us_32();
+    uint32_t save;
+    int i;
+
+    if (!g_latency.lock)
+        return;
+
+    save = spin_lock_blocking(g_latency.lock);
+
+    if (g_latency.cur >= 0 && now - g_latency.t[g_latency.cur] > LATENCY_TIMEOUT_US) {
+        g_latency.timeouts++;
+        g_latency.cur = -1;
+    }
+
+    if (stage == LATENCY_IRQ && g_latency.cur == LATENCY_IRQ &&
+        now - g_latency.t[LATENCY_IRQ] > LATENCY_ARM_US)
+        g_latency.cur = -1;
+
+    /* controllers without INT start at the first pressed sample */
+    if (g_latency.cur < 0 && stage == LATENCY_SAMPLE) {
+        g_latency.t[LATENCY_IRQ] = now;
+        g_latency.cur = LATENCY_IRQ;
+    }
+
+    if (stage != g_latency.cur + 1)
+        goto out;
+
+    g_latency.t[stage] = now;
+    g_latency.cur = stage;
+
+    if (stage == LATENCY_DONE) {
+        uint32_t *rec = g_latency.hist[g_latency.head];
+
+        for (i = 0; i < LATENCY_NR_STAGES; i++)
+            rec[i] = g_latency.t[i] - g_latency.t[LATENCY_IRQ];
+
+        g_latency.head = (g_latency.head + 1) % LATENCY_HISTORY;
+        if (g_latency.count < LATENCY_HISTORY)
+            g_latency.count++;
+        g_latency.cur = -1;
+    }
+
+out:
+    spin_unlock(g_latency.lock, save);
+}
+
+void latency_reset(void)
+{
+    uint32_t save = spin_lock_blocking(g_latency.lock);
+
+    g_latency.cur = -1;
+    g_latency.head = 0;
+    g_latency.count = 0;
+    g_latency.timeouts = 0;
+
+    spin_unlock(g_latency.lock, save);
+}
+
+uint32_t latency_count(void)
+{
+    return g_latency.count;
+}
+
+static int latency_cmp(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+/* sorted copy of one stage column, returns the number of entries */
+static uint32_t latency_column(enum latency_stage stage, uint32_t *out)
+{
+    uint32_t save = spin_lock_blocking(g_latency.lock);
+    uint32_t n = g_latency.count;
+
+    for (uint32_t i = 0; i < n; i++)
+        out[i] = g_latency.hist[i][stage];
+    spin_unlock(g_latency.lock, save);
+
+    qsort(out, n, sizeof(*out), latency_cmp);
+    return n;
+}
+
+static uint32_t latency_pick(const uint32_t *sorted, uint32_t n, int pct)
+{
+    if (!n)
+        return 0;
+
+    return sorted[(n - 1) * pct / 100];
+}
+
+uint32_t latency_percentile(enum latency_stage stage, int pct)
+{
+    uint32_t col[LATENCY_HISTORY];
+    uint32_t n = latency_column(stage, col);
+
+    return latency_pick(col, n, pct);
+}
+
+static void latency_dump(void)
+{
+    uint32_t col[LATENCY_HISTORY];
+    uint32_t n;
+    int i;
+
+    printf("%lu touches, %lu dropped without a frame\n", g_latency.count, g_latency.timeouts);
+    printf("%-10s %8s %8s %8s %8s %8s   (us since touch irq)\n",
+           "stage", "min", "p50", "p90", "p99", "max");
+
+    for (i = LATENCY_SAMPLE; i < LATENCY_NR_STAGES; i++) {
+        n = latency_column(i, col);
+        if (!n)
+            break;
+        printf("%-10s %8lu %8lu %8lu %8lu %8lu\n", latency_stage_names[i],
+               col[0], latency_pick(col, n, 50), latency_pick(col, n, 90),
+               latency_pick(col, n, 99), col[n - 1]);
+    }
+}
+
+static void latency_hist(void)
+{
+    uint32_t buckets[LATENCY_HIST_BUCKETS] = { 0 };
+    uint32_t col[LATENCY_HISTORY];
+    uint32_t n, peak = 1;
+    int i, b, w;
+
+    n = latency_column(LATENCY_DONE, col);
+    for (i = 0; i < (int)n; i++) {
+        b = col[i] / LATENCY_HIST_BUCKET_US;
+        if (b >= LATENCY_HIST_BUCKETS)
+            b = LATENCY_HIST_BUCKETS - 1;
+        buckets[b]++;
+    }
+
+    for (b = 0; b < LATENCY_HIST_BUCKETS; b++)
+        if (buckets[b] > peak)
+            peak = buckets[b];
+
+    for (b = 0; b < LATENCY_HIST_BUCKETS; b++) {
+        printf("%3d%s ms %4lu ", b * LATENCY_HIST_BUCKET_US / 1000,
+               b == LATENCY_HIST_BUCKETS - 1 ? "+" : " ", buckets[b]);
+        w = buckets[b] * LATENCY_HIST_WIDTH / peak;
+        while (w--)
+            putchar('#');
+        putchar('\n');
+    }
+}
+
+/* LVGL objects belong to the LVGL task */
+static void latency_ui_call(void *arg)
+{
+    latency_ui_start();
+}
+
+static int latency_cmd(int argc, char **argv)
+{
+    if (argc > 1 && !strcmp(argv[1], "reset"))
+        latency_reset();
+    else if (argc > 1 && !strcmp(argv[1], "hist"))
+        latency_hist();
+    else if (argc > 1 && !strcmp(argv[1], "screen"))
+        return lv_port_call(latency_ui_call, NULL);
+    else
+        latency_dump();
+
+    return 0;
+}
+
+static const struct console_cmd latency_console_cmd = {
+    .name = "lat",
+    .help = "lat [reset|hist|screen], touch to photon latency",
+    .fn = latency_cmd,
+};
+
+void latency_init(void)
+{
+    g_latency.lock = spin_lock_instance(spin_lock_claim_unused(true));
+    console_register(&latency_console_cmd);
+}
+
+#endif /* LATENCY_ENABLED */
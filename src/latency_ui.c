@@ -0,0 +1,116 @@
+// Copyright (c) 2024 embeddedboys developers
+
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+/*
+ * Latency factory test screen.
+ *
+ * A large pad flips color on every press, so each finger-down produces
+ * a frame and completes a measurement. The label shows the running
+ * touch-to-photon numbers, it is only updated on release to keep the
+ * measured frame the same size every time.
+ */
+
+#include <stdio.h>
+
+#include "lvgl/lvgl.h"
+
+#include "latency.h"
+
+#if LATENCY_ENABLED
+
+static struct {
+    lv_obj_t *scr;
+    lv_obj_t *prev;
+    lv_obj_t *pad;
+    lv_obj_t *label;
+    bool flip;
+} g_latency_ui;
+
+static void latency_ui_update_label(void)
+{
+    lv_label_set_text_fmt(g_latency_ui.label,
+                          "%lu touches  p50 %lu us  p90 %lu us  p99 %lu us",
+                          latency_count(),
+                          latency_percentile(LATENCY_DONE, 50),
+                          latency_percentile(LATENCY_DONE, 90),
+                          latency_percentile(LATENCY_DONE, 99));
+}
+
+static void latency_ui_pad_cb(lv_event_t *e)
+{
+    switch (lv_event_get_code(e)) {
+    case LV_EVENT_PRESSED:
+        g_latency_ui.flip = !g_latency_ui.flip;
+        lv_obj_set_style_bg_color(g_latency_ui.pad, g_latency_ui.flip ?
+                                  lv_color_white() : lv_palette_main(LV_PALETTE_BLUE), 0);
+        break;
+    case LV_EVENT_RELEASED:
+        latency_ui_update_label();
+        break;
+    default:
+        break;
+    }
+}
+
+static void latency_ui_exit_cb(lv_event_t *e)
+{
+    lv_scr_load(g_latency_ui.prev);
+    lv_obj_del_async(g_latency_ui.scr);
+    g_latency_ui.scr = NULL;
+}
+
+int latency_ui_start(void)
+{
+    lv_obj_t *btn, *label;
+
+    if (g_latency_ui.scr)
+        return -1;
+
+    g_latency_ui.prev = lv_scr_act();
+    g_latency_ui.scr = lv_obj_create(NULL);
+    lv_obj_clear_flag(g_latency_ui.scr, LV_OBJ_FLAG_SCROLLABLE);
+
+    g_latency_ui.label = lv_label_create(g_latency_ui.scr);
+    lv_obj_align(g_latency_ui.label, LV_ALIGN_TOP_LEFT, 8, 8);
+
+    g_latency_ui.pad = lv_obj_create(g_latency_ui.scr);
+    lv_obj_remove_style_all(g_latency_ui.pad);
+    lv_obj_set_size(g_latency_ui.pad, lv_pct(70), lv_pct(70));
+    lv_obj_set_style_bg_opa(g_latency_ui.pad, LV_OPA_COVER, 0);
+    lv_obj_set_style_bg_color(g_latency_ui.pad, lv_palette_main(LV_PALETTE_BLUE), 0);
+    lv_obj_align(g_latency_ui.pad, LV_ALIGN_BOTTOM_MID, 0, -8);
+    lv_obj_add_event_cb(g_latency_ui.pad, latency_ui_pad_cb, LV_EVENT_ALL, NULL);
+
+    btn = lv_btn_create(g_latency_ui.scr);
+    lv_obj_align(btn, LV_ALIGN_TOP_RIGHT, -8, 8);
+    lv_obj_add_event_cb(btn, latency_ui_exit_cb, LV_EVENT_CLICKED, NULL);
+    label = lv_label_create(btn);
+    lv_label_set_text(label, LV_SYMBOL_CLOSE);
+
+    latency_reset();
+    latency_ui_update_label();
+    lv_scr_load(g_latency_ui.scr);
+
+    return 0;
+}
+
+#endif /* LATENCY_ENABLED */
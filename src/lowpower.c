@@ -0,0 +1,214 @@
+// Copyright (c) 2024 embeddedboys developers
+
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+/*
+ * Low power idle.
+ *
+ * - Both idle hooks WFI, so a core with nothing to run stops its clock
+ *   until the next interrupt (tick, cross-core yield, touch, DMA, ...).
+ * - Clocks of blocks this firmware never uses (USB, ADC, RTC, UART1, SPI
+ *   unless the XPT2046 driver is built) are gated and PLL_USB is powered
+ *   down.
+ * - When LVGL has no pending timer at all the screen is static; a touch
+ *   interrupt in that state starts a wake-to-first-frame measurement that
+ *   completes on the next finished flush.
+ *
+ * The RP2040 SMP port has no tickless idle support and the UART console
+ * and flush DMA need clk_sys, so the tick keeps running and dormant mode
+ * is not used; between ticks the cores sleep.
+ */
+
+#define pr_fmt(fmt) "lowpower: " fmt
+
+#include <stdio.h>
+#include <string.h>
+
+#include "pico/platform.h"
+#include "hardware/clocks.h"
+#include "hardware/pll.h"
+#include "hardware/sync.h"
+#include "hardware/timer.h"
+#include "hardware/structs/clocks.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "lowpower.h"
+#include "console.h"
+#include "debug.h"
+
+#if LOWPOWER_ENABLED
+
+/* a SPI touch controller may be picked at boot */
+#if INDEV_DRV_USE_XPT2046
+#define LOWPOWER_GATE_SPI   0
+#else
+#define LOWPOWER_GATE_SPI   (CLOCKS_WAKE_EN0_CLK_SYS_SPI1_BITS |   \
+                             CLOCKS_WAKE_EN0_CLK_PERI_SPI1_BITS |  \
+                             CLOCKS_WAKE_EN0_CLK_SYS_SPI0_BITS |   \
+                             CLOCKS_WAKE_EN0_CLK_PERI_SPI0_BITS)
+#endif
+
+/* blocks that are never used by this firmware, gated in wake and sleep */
+#define LOWPOWER_GATE_EN0   (LOWPOWER_GATE_SPI |                    \
+                             CLOCKS_WAKE_EN0_CLK_SYS_RTC_BITS |    \
+                             CLOCKS_WAKE_EN0_CLK_RTC_RTC_BITS |    \
+                             CLOCKS_WAKE_EN0_CLK_SYS_ADC_BITS |    \
+                             CLOCKS_WAKE_EN0_CLK_ADC_ADC_BITS)
+#define LOWPOWER_GATE_EN1   (CLOCKS_WAKE_EN1_CLK_SYS_USBCTRL_BITS | \
+                             CLOCKS_WAKE_EN1_CLK_USB_USBCTRL_BITS | \
+                             CLOCKS_WAKE_EN1_CLK_SYS_UART1_BITS |   \
+                             CLOCKS_WAKE_EN1_CLK_PERI_UART1_BITS)
+
+static struct lowpower_stats g_stats;
+
+/* LVGL side state, only touched by the LVGL task, the touch irq and the flush task */
+static volatile bool g_static;
+static volatile bool g_measuring;
+static uint64_t g_static_since;
+static uint64_t g_wake_at;
+
+static void __time_critical_func(lowpower_idle)(void)
+{
+    uint64_t t0 = time_us_64();
+
+    __wfi();
+
+    g_stats.sleep_us[get_core_num()] += time_us_64() - t0;
+}
+
+void vApplicationIdleHook(void)
+{
+    lowpower_idle();
+}
+
+void vApplicationPassiveIdleHook(void)
+{
+    lowpower_idle();
+}
+
+void lowpower_lvgl_sleep(bool forever)
+{
+    if (!forever)
+        return;
+
+    /* a touch that woke us but changed nothing on screen */
+    if (g_measuring) {
+        g_measuring = false;
+        g_stats.wakes_no_frame++;
+    }
+
+    g_static_since = time_us_64();
+    g_static = true;
+}
+
+void __time_critical_func(lowpower_touch_wake)(void)
+{
+    uint64_t now;
+
+    if (!g_static)
+        return;
+
+    now = time_us_64();
+    g_static = false;
+    g_stats.static_us += now - g_static_since;
+    g_stats.wakes++;
+
+    g_wake_at = now;
+    g_measuring = true;
+}
+
+void lowpower_frame_flushed(void)
+{
+    uint32_t lat;
+
+    if (!g_measuring)
+        return;
+    g_measuring = false;
+
+    lat = (uint32_t)(time_us_64() - g_wake_at);
+
+    g_stats.latency_last_us = lat;
+    if (!g_stats.latency_cnt || lat < g_stats.latency_min_us)
+        g_stats.latency_min_us = lat;
+    if (lat > g_stats.latency_max_us)
+        g_stats.latency_max_us = lat;
+    g_stats.latency_sum_us += lat;
+    g_stats.latency_cnt++;
+}
+
+void lowpower_get_stats(struct lowpower_stats *stats)
+{
+    *stats = g_stats;
+
+    /* include the static period still in progress */
+    if (g_static)
+        stats->static_us += time_us_64() - g_static_since;
+}
+
+void lowpower_dump(void)
+{
+    struct lowpower_stats s;
+    uint64_t up = time_us_64();
+
+    lowpower_get_stats(&s);
+
+    for (int i = 0; i < 2; i++)
+        printf("core%d asleep %llu ms (%lu%%)\n", i, s.sleep_us[i] / 1000,
+               (uint32_t)(s.sleep_us[i] * 100 / up));
+    printf("static screen %llu ms (%lu%%), %s now\n", s.static_us / 1000,
+           (uint32_t)(s.static_us * 100 / up), g_static ? "static" : "active");
+    printf("touch wakes %lu, without redraw %lu\n", s.wakes, s.wakes_no_frame);
+    if (s.latency_cnt)
+        printf("wake to first frame: last %lu us, min %lu us, avg %lu us, max %lu us\n",
+               s.latency_last_us, s.latency_min_us,
+               (uint32_t)(s.latency_sum_us / s.latency_cnt), s.latency_max_us);
+}
+
+static int lowpower_cmd(int argc, char **argv)
+{
+    lowpower_dump();
+    return 0;
+}
+
+static const struct console_cmd power_console_cmd = {
+    .name = "power",
+    .help = "core sleep time, static screen time and wake-to-frame latency",
+    .fn = lowpower_cmd,
+};
+
+void lowpower_init(void)
+{
+    /* nothing runs from PLL_USB: USB and ADC are unused, RTC too */
+    clock_stop(clk_usb);
+    clock_stop(clk_adc);
+    clock_stop(clk_rtc);
+    pll_deinit(pll_usb);
+
+    hw_clear_bits(&clocks_hw->wake_en0, LOWPOWER_GATE_EN0);
+    hw_clear_bits(&clocks_hw->wake_en1, LOWPOWER_GATE_EN1);
+    hw_clear_bits(&clocks_hw->sleep_en0, LOWPOWER_GATE_EN0);
+    hw_clear_bits(&clocks_hw->sleep_en1, LOWPOWER_GATE_EN1);
+
+    console_register(&power_console_cmd);
+}
+
+#endif /* LOWPOWER_ENABLED */
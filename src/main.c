@@ -40,37 +40,110 @@
 #include "lvgl/examples/lv_examples.h"
 #include "porting/lv_port_disp_template.h"
 #include "porting/lv_port_indev_template.h"
+#include "porting/lv_port_os.h"
 
 #include "FreeRTOS.h"
 #include "task.h"
 #include "semphr.h"
 
+#include "rtos_alloc.h"
 #include "backlight.h"
+#include "cabc.h"
+#include "disp_power.h"
+#include "settings.h"
+#include "splash.h"
+#include "boot_time.h"
+#include "bringup.h"
+#include "decode_cache.h"
+#include "mem_pool.h"
+#include "task_stats.h"
+#include "console.h"
+#include "trace.h"
+#include "prof.h"
+#include "lowpower.h"
+#include "indev_calib_ui.h"
+#include "indev_task.h"
+#include "latency.h"
+#include "indev_replay.h"
 
 #include "debug.h"
 
 QueueHandle_t xToFlushQueue = NULL;
 
-void vApplicationTickHook()
+extern int factory_test(void);
+
+static int mem_cmd(int argc, char **argv)
 {
-	lv_tick_inc(1);
+#if MEM_POOL_ENABLED
+    mem_pool_dump();
+#endif
+    decode_cache_dump();
+    return 0;
 }
 
-const TickType_t xPeriod = pdMS_TO_TICKS( 5 );
-static portTASK_FUNCTION(lv_timer_task_handler, pvParameters)
+static const struct console_cmd mem_console_cmd = {
+    .name = "mem",
+    .help = "allocator and decode cache statistics",
+    .fn = mem_cmd,
+};
+
+/* flush task, core 1: panel first, everything after runs behind the splash */
+static int bringup_panel(void)
 {
-	TickType_t xLastWakeTime;
-	
-	xLastWakeTime = xTaskGetTickCount();  
-	
-	for(;;) {		
-		vTaskDelayUntil( &xLastWakeTime,xPeriod );
-		lv_timer_handler();
-	}
-	vTaskDelete(NULL);
+    int ret = tft_driver_init();
+
+    splash_show();
+    return ret;
 }
 
-extern int factory_test(void);
+static int bringup_backlight(void)
+{
+    u8 bl_level = 100;
+
+    settings_get(SETTINGS_KEY_BL_LEVEL, &bl_level, sizeof(bl_level));
+    backlight_set_level(bl_level);
+    printf("backlight set to %d%%\n", bl_level);
+    return 0;
+}
+
+/* touch task, core 1: the controller resets while the panel initializes */
+static int bringup_touch(void)
+{
+    /* No controller answered, the pointer stays released */
+    if (indev_driver_init())
+        return -1;
+
+    indev_calib_ui_load();
+    return 0;
+}
+
+/* LVGL task, core 0: needs neither panel nor touch, they hook in later */
+static int bringup_lvgl(void)
+{
+    lv_init();
+    decode_cache_init();
+    lv_port_disp_init();
+    lv_port_indev_init();
+    return 0;
+}
+
+static int bringup_ui(void)
+{
+    printf("Starting demo\n");
+    // lv_example_btn_1();
+    lv_demo_widgets();
+    // lv_demo_stress();
+    // lv_demo_music();
+
+    /* measure weighted fps and opa speed */
+    // lv_demo_benchmark();
+
+    /* This is a factory test app */
+    // factory_test();
+
+    disp_power_init();
+    return 0;
+}
 
 int main(void)
 {
@@ -94,41 +167,54 @@ int main(void)
     stdio_uart_init_full(uart0, 115200, 16, 17);
 
     printf("\n\n\nPICO DM QD3503728 LVGL Porting\n");
+    boot_time_init();
+    boot_mark("clocks");
+
+    /* the display and touch setup below look up their settings */
+    settings_init();
+    boot_mark("settings");
+
+    rtos_queue_create(xToFlushQueue, 2, sizeof(struct video_frame));
+
+    /* touch and panel share a pin, the panel's GPIOs go first, see tft.c */
+    tft_gpio_setup();
+
+    /*
+     * Drivers come up in the tasks that own them once the scheduler runs,
+     * with their reset delays slept instead of spun, see bringup.c.
+     */
+    bringup_init();
+    bringup_register(BRINGUP_PANEL, "panel", bringup_panel, 0);
+    bringup_register(BRINGUP_BACKLIGHT, "backlight", bringup_backlight,
+                     BRINGUP_BIT(BRINGUP_PANEL));
+    bringup_register(BRINGUP_TOUCH, "touch", bringup_touch, 0);
+    bringup_register(BRINGUP_LVGL, "lvgl", bringup_lvgl, 0);
+    bringup_register(BRINGUP_UI, "ui", bringup_ui, BRINGUP_BIT(BRINGUP_LVGL));
+
+    /* PWM off until the panel shows the splash */
+    backlight_driver_init();
 
-    xToFlushQueue = xQueueCreate(2, sizeof(struct video_frame));
-    
-
-    // extern int tft_driver_init(void);
-    // tft_driver_init();
-    // for(;;);
-
-    lv_init();
-    lv_port_disp_init();
-    lv_port_indev_init();
-
-    printf("Starting demo\n");
-    // lv_example_btn_1();
-    lv_demo_widgets();
-    // lv_demo_stress();
-    // lv_demo_music();
-
-    /* measure weighted fps and opa speed */
-    // lv_demo_benchmark();
-
-    /* This is a factory test app */
-    // factory_test();
-
-    TaskHandle_t lvgl_task_handle;
-    xTaskCreate(lv_timer_task_handler, "lvgl_task", 2048, NULL, (tskIDLE_PRIORITY + 3), &lvgl_task_handle);
-    vTaskCoreAffinitySet(lvgl_task_handle, (1 << 0));
+    lv_port_os_init();
 
     TaskHandle_t video_flush_handler;
-    xTaskCreate(video_flush_task, "video_flush", 256, NULL, (tskIDLE_PRIORITY + 2), &video_flush_handler);
+    rtos_task_create(video_flush_task, "video_flush", 512, NULL, (tskIDLE_PRIORITY + 2), &video_flush_handler);
     vTaskCoreAffinitySet(video_flush_handler, (1 << 1));
 
-    backlight_driver_init();
-    backlight_set_level(100);
-    printf("backlight set to 100%%\n");
+    indev_task_init();
+
+    cabc_init();
+
+    console_init();
+    console_register(&mem_console_cmd);
+    indev_calib_ui_init();
+    latency_init();
+    indev_replay_init();
+    task_stats_init();
+    trace_init();
+    trace_queue_watch(xToFlushQueue, "flush");
+    prof_init();
+    lowpower_init();
+    boot_mark("services");
 
     printf("calling freertos scheduler, %lld\n", time_us_64());
     vTaskStartScheduler();
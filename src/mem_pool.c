@@ -0,0 +1,586 @@
+// Copyright (c) 2024 embeddedboys developers
+
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+/*
+ * A single arena shared by LVGL (lv_mem_alloc), FreeRTOS (pvPortMalloc)
+ * and newlib (malloc).
+ *
+ * Requests up to 1 KiB are served from size classes. Each core keeps its
+ * own freelist per class and only touches it with local interrupts masked,
+ * so the common alloc/free path takes no lock at all. Empty local lists are
+ * refilled in batches from a global list per class, which in turn carves
+ * new slabs out of the arena. Bigger requests and slabs come from an
+ * address ordered first-fit list with coalescing. Both slow paths are
+ * serialized by one hardware spin lock.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <reent.h>
+
+#include "pico/platform.h"
+#include "hardware/sync.h"
+
+#include "FreeRTOS.h"
+
+#include "mem_pool.h"
+#include "debug.h"
+
+#if MEM_POOL_ENABLED
+
+#define MEM_POOL_ALIGN          8
+#define MEM_POOL_MAGIC          0xB10C
+#define MEM_POOL_CLASS_LARGE    0xFF
+
+#define MEM_POOL_SLAB_SIZE      2048
+#define MEM_POOL_REFILL_BATCH   8
+#define MEM_POOL_LOCAL_MAX      (MEM_POOL_REFILL_BATCH * 3)
+#define MEM_POOL_MIN_SPLIT      32
+
+#define NR_CORES                2
+
+#define ALIGN_UP(v, a)  (((v) + (a) - 1) & ~((a) - 1))
+
+/* prepended to every allocation, keeps the payload 8 bytes aligned */
+struct mem_block_hdr {
+    uint32_t size;      /* requested size */
+    uint16_t magic;
+    uint8_t  cls;
+    uint8_t  core;
+};
+
+/* free blocks link through their payload */
+struct mem_free_block {
+    struct mem_free_block *next;
+};
+
+/* arena chunk header, used by the large allocator */
+struct mem_chunk {
+    uint32_t len;       /* including this header */
+    uint32_t used;
+    struct mem_chunk *next;     /* valid while free only */
+};
+
+#define CHUNK_HDR_SIZE  8
+
+static const uint16_t mem_pool_class_size[MEM_POOL_NR_CLASSES] = {
+    16, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024,
+};
+
+/* per core state, only ever touched by its own core */
+struct mem_pool_core {
+    struct mem_free_block *free[MEM_POOL_NR_CLASSES];
+    uint16_t nr_free[MEM_POOL_NR_CLASSES];
+
+    uint32_t allocs[MEM_POOL_NR_CLASSES];
+    uint32_t frees[MEM_POOL_NR_CLASSES];
+    int32_t  req_bytes[MEM_POOL_NR_CLASSES];
+};
+
+static struct {
+    bool initialized;
+    spin_lock_t *lock;
+
+    struct mem_pool_core core[NR_CORES];
+
+    /* below here protected by lock */
+    struct mem_free_block *free[MEM_POOL_NR_CLASSES];
+    uint32_t blocks[MEM_POOL_NR_CLASSES];
+
+    struct mem_chunk *chunks;   /* free chunks, address ordered */
+    uint32_t arena_used;
+    uint32_t arena_hwm;
+    uint32_t large_allocs;
+    uint32_t large_in_use;
+    uint32_t failures;
+} g_pool;
+
+static uint8_t g_arena[MEM_POOL_SIZE] __attribute__((aligned(MEM_POOL_ALIGN)));
+
+static inline bool in_arena(void *p)
+{
+    return (uint8_t *)p >= g_arena && (uint8_t *)p < g_arena + sizeof(g_arena);
+}
+
+static inline uint32_t block_size(int cls)
+{
+    return sizeof(struct mem_block_hdr) + mem_pool_class_size[cls];
+}
+
+static int size_to_class(size_t size)
+{
+    for (int i = 0; i < MEM_POOL_NR_CLASSES; i++)
+        if (size <= mem_pool_class_size[i])
+            return i;
+
+    return MEM_POOL_CLASS_LARGE;
+}
+
+/* ------------------------ Large allocator (locked) ----------------------- */
+
+static void *chunk_alloc(uint32_t size)
+{
+    struct mem_chunk **pp, *c, *rest;
+    uint32_t len = ALIGN_UP(size + CHUNK_HDR_SIZE, MEM_POOL_ALIGN);
+
+    for (pp = &g_pool.chunks; (c = *pp); pp = &c->next) {
+        if (c->len < len)
+            continue;
+
+        if (c->len - len >= MEM_POOL_MIN_SPLIT) {
+            rest = (struct mem_chunk *)((uint8_t *)c + len);
+            rest->len = c->len - len;
+            rest->used = 0;
+            rest->next = c->next;
+            *pp = rest;
+            c->len = len;
+        } else {
+            *pp = c->next;
+        }
+
+        c->used = 1;
+        g_pool.arena_used += c->len;
+        if (g_pool.arena_used > g_pool.arena_hwm)
+            g_pool.arena_hwm = g_pool.arena_used;
+
+        return (uint8_t *)c + CHUNK_HDR_SIZE;
+    }
+
+    return NULL;
+}
+
+static void chunk_free(void *p)
+{
+    struct mem_chunk *c = (struct mem_chunk *)((uint8_t *)p - CHUNK_HDR_SIZE);
+    struct mem_chunk **pp, *prev = NULL;
+
+    c->used = 0;
+    g_pool.arena_used -= c->len;
+
+    for (pp = &g_pool.chunks; *pp && *pp < c; pp = &(*pp)->next)
+        prev = *pp;
+
+    c->next = *pp;
+    *pp = c;
+
+    /* merge with the following chunk */
+    if (c->next && (uint8_t *)c + c->len == (uint8_t *)c->next) {
+        c->len += c->next->len;
+        c->next = c->next->next;
+    }
+
+    /* merge with the preceding chunk */
+    if (prev && (uint8_t *)prev + prev->len == (uint8_t *)c) {
+        prev->len += c->len;
+        prev->next = c->next;
+    }
+}
+
+/* carve a new slab into blocks of `cls`, called with lock held */
+static bool class_grow(int cls)
+{
+    uint32_t bsize = block_size(cls);
+    uint32_t len = MEM_POOL_SLAB_SIZE;
+    struct mem_block_hdr *hdr;
+    struct mem_free_block *fb;
+    uint8_t *slab;
+
+    if (len < bsize * MEM_POOL_REFILL_BATCH)
+        len = bsize * MEM_POOL_REFILL_BATCH;
+
+    slab = chunk_alloc(len);
+    if (!slab)
+        return false;
+
+    for (uint32_t off = 0; off + bsize <= len; off += bsize) {
+        hdr = (struct mem_block_hdr *)(slab + off);
+        hdr->magic = MEM_POOL_MAGIC;
+        hdr->cls = cls;
+        hdr->size = 0;
+
+        fb = (struct mem_free_block *)(hdr + 1);
+        fb->next = g_pool.free[cls];
+        g_pool.free[cls] = fb;
+        g_pool.blocks[cls]++;
+    }
+
+    return true;
+}
+
+/* move a batch from the global list to the local one, called with lock held */
+static void class_refill(struct mem_pool_core *pc, int cls)
+{
+    struct mem_free_block *fb;
+
+    for (int i = 0; i < MEM_POOL_REFILL_BATCH; i++) {
+        if (!g_pool.free[cls] && !class_grow(cls))
+            break;
+
+        fb = g_pool.free[cls];
+        g_pool.free[cls] = fb->next;
+
+        fb->next = pc->free[cls];
+        pc->free[cls] = fb;
+        pc->nr_free[cls]++;
+    }
+}
+
+/* give a batch back to the global list, called with lock held */
+static void class_drain(struct mem_pool_core *pc, int cls, int count)
+{
+    struct mem_free_block *fb;
+
+    while (count-- && pc->free[cls]) {
+        fb = pc->free[cls];
+        pc->free[cls] = fb->next;
+        pc->nr_free[cls]--;
+
+        fb->next = g_pool.free[cls];
+        g_pool.free[cls] = fb;
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+
+void mem_pool_init(void)
+{
+    struct mem_chunk *c;
+
+    if (g_pool.initialized)
+        return;
+
+    g_pool.lock = spin_lock_init(spin_lock_claim_unused(true));
+
+    c = (struct mem_chunk *)g_arena;
+    c->len = sizeof(g_arena);
+    c->used = 0;
+    c->next = NULL;
+    g_pool.chunks = c;
+
+    g_pool.initialized = true;
+}
+
+void *__not_in_flash_func(mem_pool_alloc)(size_t size)
+{
+    struct mem_block_hdr *hdr;
+    struct mem_free_block *fb;
+    struct mem_pool_core *pc;
+    uint32_t irq, core;
+    int cls;
+
+    if (!g_pool.initialized)
+        mem_pool_init();
+
+    cls = size_to_class(size);
+    if (cls == MEM_POOL_CLASS_LARGE) {
+        irq = spin_lock_blocking(g_pool.lock);
+        hdr = chunk_alloc(sizeof(*hdr) + size);
+        if (hdr) {
+            g_pool.large_allocs++;
+            g_pool.large_in_use += size;
+        } else {
+            g_pool.failures++;
+        }
+        spin_unlock(g_pool.lock, irq);
+
+        if (!hdr)
+            return NULL;
+
+        hdr->magic = MEM_POOL_MAGIC;
+        hdr->cls = MEM_POOL_CLASS_LARGE;
+        hdr->core = get_core_num();
+        hdr->size = size;
+        return hdr + 1;
+    }
+
+    /* masking local interrupts also keeps the scheduler from migrating us */
+    irq = save_and_disable_interrupts();
+    core = get_core_num();
+    pc = &g_pool.core[core];
+
+    if (!pc->free[cls]) {
+        spin_lock_unsafe_blocking(g_pool.lock);
+        class_refill(pc, cls);
+        if (!pc->free[cls])
+            g_pool.failures++;
+        spin_unlock_unsafe(g_pool.lock);
+
+        if (!pc->free[cls]) {
+            restore_interrupts(irq);
+            return NULL;
+        }
+    }
+
+    fb = pc->free[cls];
+    pc->free[cls] = fb->next;
+    pc->nr_free[cls]--;
+    pc->allocs[cls]++;
+    pc->req_bytes[cls] += size;
+
+    restore_interrupts(irq);
+
+    hdr = (struct mem_block_hdr *)fb - 1;
+    hdr->size = size;
+    hdr->core = core;
+
+    return fb;
+}
+
+void __not_in_flash_func(mem_pool_free)(void *ptr)
+{
+    struct mem_block_hdr *hdr;
+    struct mem_free_block *fb = ptr;
+    struct mem_pool_core *pc;
+    uint32_t irq;
+    int cls;
+
+    if (!ptr)
+        return;
+
+    hdr = (struct mem_block_hdr *)ptr - 1;
+    if (hdr->magic != MEM_POOL_MAGIC)
+        panic("mem_pool: bad free %p\n", ptr);
+
+    cls = hdr->cls;
+    if (cls == MEM_POOL_CLASS_LARGE) {
+        irq = spin_lock_blocking(g_pool.lock);
+        g_pool.large_in_use -= hdr->size;
+        chunk_free(hdr);
+        spin_unlock(g_pool.lock, irq);
+        return;
+    }
+
+    irq = save_and_disable_interrupts();
+    pc = &g_pool.core[get_core_num()];
+
+    fb->next = pc->free[cls];
+    pc->free[cls] = fb;
+    pc->nr_free[cls]++;
+    pc->frees[cls]++;
+    pc->req_bytes[cls] -= hdr->size;
+
+    /* don't let one core hoard blocks freed on behalf of the other */
+    if (pc->nr_free[cls] > MEM_POOL_LOCAL_MAX) {
+        spin_lock_unsafe_blocking(g_pool.lock);
+        class_drain(pc, cls, MEM_POOL_REFILL_BATCH);
+        spin_unlock_unsafe(g_pool.lock);
+    }
+
+    restore_interrupts(irq);
+}
+
+void *mem_pool_realloc(void *ptr, size_t size)
+{
+    struct mem_block_hdr *hdr;
+    uint32_t cap;
+    void *p;
+
+    if (!ptr)
+        return mem_pool_alloc(size);
+
+    if (!size) {
+        mem_pool_free(ptr);
+        return NULL;
+    }
+
+    hdr = (struct mem_block_hdr *)ptr - 1;
+    if (hdr->cls == MEM_POOL_CLASS_LARGE) {
+        struct mem_chunk *c = (struct mem_chunk *)((uint8_t *)hdr - CHUNK_HDR_SIZE);
+        cap = c->len - CHUNK_HDR_SIZE - sizeof(*hdr);
+    } else {
+        cap = mem_pool_class_size[hdr->cls];
+    }
+
+    /* shrinking in place, or growing within the class slack */
+    if (size <= cap && (hdr->cls == MEM_POOL_CLASS_LARGE || size_to_class(size) == hdr->cls)) {
+        uint32_t irq = save_and_disable_interrupts();
+        if (hdr->cls == MEM_POOL_CLASS_LARGE) {
+            spin_lock_unsafe_blocking(g_pool.lock);
+            g_pool.large_in_use += size - hdr->size;
+            spin_unlock_unsafe(g_pool.lock);
+        } else {
+            g_pool.core[get_core_num()].req_bytes[hdr->cls] += size - hdr->size;
+        }
+        hdr->size = size;
+        restore_interrupts(irq);
+        return ptr;
+    }
+
+    p = mem_pool_alloc(size);
+    if (!p)
+        return NULL;
+
+    memcpy(p, ptr, hdr->size < size ? hdr->size : size);
+    mem_pool_free(ptr);
+
+    return p;
+}
+
+/* return the blocks cached by the calling core to the global lists */
+void mem_pool_trim(void)
+{
+    struct mem_pool_core *pc;
+    uint32_t irq;
+
+    irq = save_and_disable_interrupts();
+    pc = &g_pool.core[get_core_num()];
+
+    spin_lock_unsafe_blocking(g_pool.lock);
+    for (int i = 0; i < MEM_POOL_NR_CLASSES; i++)
+        class_drain(pc, i, pc->nr_free[i]);
+    spin_unlock_unsafe(g_pool.lock);
+
+    restore_interrupts(irq);
+}
+
+void mem_pool_get_stats(struct mem_pool_stats *stats)
+{
+    struct mem_chunk *c;
+    uint32_t irq;
+
+    memset(stats, 0, sizeof(*stats));
+
+    irq = spin_lock_blocking(g_pool.lock);
+
+    stats->arena_size = sizeof(g_arena);
+    stats->arena_used = g_pool.arena_used;
+    stats->arena_hwm = g_pool.arena_hwm;
+    stats->large_allocs = g_pool.large_allocs;
+    stats->large_in_use = g_pool.large_in_use;
+    stats->failures = g_pool.failures;
+
+    for (c = g_pool.chunks; c; c = c->next) {
+        stats->free_bytes += c->len;
+        if (c->len > stats->largest_free)
+            stats->largest_free = c->len;
+    }
+
+    for (int i = 0; i < MEM_POOL_NR_CLASSES; i++)
+        stats->cls[i].blocks = g_pool.blocks[i];
+
+    spin_unlock(g_pool.lock, irq);
+
+    if (stats->free_bytes)
+        stats->frag_pct = 100 - stats->largest_free * 100 / stats->free_bytes;
+
+    /* per core counters are read racy, good enough for statistics */
+    for (int i = 0; i < MEM_POOL_NR_CLASSES; i++) {
+        struct mem_pool_class_stats *cs = &stats->cls[i];
+
+        cs->size = mem_pool_class_size[i];
+        for (int core = 0; core < NR_CORES; core++) {
+            cs->allocs += g_pool.core[core].allocs[i];
+            cs->frees += g_pool.core[core].frees[i];
+            cs->req_bytes += g_pool.core[core].req_bytes[i];
+        }
+        cs->in_use = cs->allocs - cs->frees;
+    }
+}
+
+void mem_pool_dump(void)
+{
+    struct mem_pool_stats s;
+    uint32_t waste = 0;
+
+    mem_pool_get_stats(&s);
+
+    printf("mem pool: %lu/%lu bytes used, hwm %lu, free %lu, largest free %lu, frag %lu%%\n",
+           s.arena_used, s.arena_size, s.arena_hwm, s.free_bytes, s.largest_free, s.frag_pct);
+    printf("  large: %lu allocs, %lu bytes in use, %lu failures\n",
+           s.large_allocs, s.large_in_use, s.failures);
+    printf("  class    allocs     frees  in_use  blocks  req_bytes\n");
+
+    for (int i = 0; i < MEM_POOL_NR_CLASSES; i++) {
+        struct mem_pool_class_stats *cs = &s.cls[i];
+
+        if (!cs->blocks)
+            continue;
+
+        printf("  %5lu %9lu %9lu %7ld %7lu %10lu\n", cs->size, cs->allocs,
+               cs->frees, cs->in_use, cs->blocks, cs->req_bytes);
+        if (cs->in_use > 0)
+            waste += cs->in_use * cs->size - cs->req_bytes;
+    }
+
+    printf("  internal fragmentation : %lu bytes\n", waste);
+}
+
+/* -------------------------- Allocator backends --------------------------- */
+
+void *pvPortMalloc(size_t xWantedSize)
+{
+    void *p = mem_pool_alloc(xWantedSize);
+
+    traceMALLOC(p, xWantedSize);
+    return p;
+}
+
+void vPortFree(void *pv)
+{
+    traceFREE(pv, 0);
+    mem_pool_free(pv);
+}
+
+/*
+ * pico_malloc wraps malloc() and friends and ends up calling these through
+ * __real_malloc(), so they take precedence over newlib's allocator.
+ */
+void *malloc(size_t size)
+{
+    return mem_pool_alloc(size);
+}
+
+/* newlib internals (e.g. vasprintf) still hand out blocks from its own heap */
+void free(void *ptr)
+{
+    if (ptr && !in_arena(ptr)) {
+        _free_r(_REENT, ptr);
+        return;
+    }
+
+    mem_pool_free(ptr);
+}
+
+void *calloc(size_t count, size_t size)
+{
+    size_t len = count * size;
+    void *p;
+
+    if (size && len / size != count)
+        return NULL;
+
+    p = mem_pool_alloc(len);
+    if (p)
+        memset(p, 0, len);
+
+    return p;
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    if (ptr && !in_arena(ptr))
+        return _realloc_r(_REENT, ptr, size);
+
+    return mem_pool_realloc(ptr, size);
+}
+
+#endif
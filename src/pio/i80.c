@@ -120,6 +120,42 @@ int __time_critical_func(i80_write_buf_rs)(void *buf, size_t len, bool rs)
     return 0;
 }
 
+/* count pixels of one colour, px is two bytes in bus order like a frame */
+int __time_critical_func(i80_fill_rs)(const void *px, size_t count, bool rs)
+{
+#if PIO_USE_DMA
+    dma_channel_config cfg = g_i80.dma_chnn_cfg;
+#endif
+
+    i80_wait_idle(g_i80.pio, g_i80.sm);
+    i80_set_rs_cs(rs, 0);
+
+#if PIO_USE_DMA
+    if (g_i80.db_count == 16) {
+        channel_config_set_read_increment(&cfg, false);
+    } else {
+        /* the read wraps over the two bytes of the pixel */
+        channel_config_set_ring(&cfg, false, 1);
+        count *= 2;
+    }
+    dma_channel_configure(g_i80.dma_tx, &cfg, &g_i80.pio->txf[g_i80.sm], px, count, true);
+    dma_channel_wait_for_finish_blocking(g_i80.dma_tx);
+#else
+    while (count--) {
+        if (g_i80.db_count == 16) {
+            i80_put(g_i80.pio, g_i80.sm, *(const uint16_t *)px);
+        } else {
+            i80_put(g_i80.pio, g_i80.sm, ((const uint8_t *)px)[0]);
+            i80_put(g_i80.pio, g_i80.sm, ((const uint8_t *)px)[1]);
+        }
+    }
+#endif
+
+    i80_wait_idle(g_i80.pio, g_i80.sm);
+    i80_set_rs_cs(rs, 0);
+    return 0;
+}
+
 int i80_pio_init(uint8_t db_base, uint8_t db_count, uint8_t pin_wr)
 {
     printf("i80 PIO initialzing...\n");
@@ -166,4 +202,23 @@ int i80_pio_init(uint8_t db_base, uint8_t db_count, uint8_t pin_wr)
 exit_release_chnn:
     dma_channel_unclaim(g_i80.dma_tx);
     return -1;
-}
\ No newline at end of file
+}
+
+/* a bus clock found to be stable on this panel, overrides I80_BUS_WR_CLK_KHZ */
+int i80_set_clk_khz(uint32_t khz)
+{
+    float clk_div;
+
+    if (!khz)
+        return -1;
+
+    clk_div = DEFAULT_PIO_CLK_KHZ / 2.f / khz;
+    if (clk_div < 1.f)
+        return -1;
+
+    g_i80.clk_div = clk_div;
+    pio_sm_set_clkdiv(g_i80.pio, g_i80.sm, g_i80.clk_div);
+
+    printf("I80 bus clock : %lu kHz\n", khz);
+    return 0;
+}
@@ -18,6 +18,13 @@
 
 #include "pico/multicore.h"
 
+#include "lv_port_os.h"
+#include "lowpower.h"
+#include "trace.h"
+#include "latency.h"
+#include "indev_replay.h"
+#include "disp_power.h"
+#include "boot_time.h"
 #include "debug.h"
 
 /*********************
@@ -34,6 +41,7 @@
 static void disp_init(void);
 
 static void disp_flush(lv_disp_drv_t * disp_drv, const lv_area_t * area, lv_color_t * color_p);
+static void disp_monitor(lv_disp_drv_t * disp_drv, uint32_t time, uint32_t px);
 //static void gpu_fill(lv_disp_drv_t * disp_drv, lv_color_t * dest_buf, lv_coord_t dest_width,
 //        const lv_area_t * fill_area, lv_color_t color);
 
@@ -122,6 +130,12 @@ void lv_port_disp_init(void)
     /*Used to copy the buffer's content to the display*/
     disp_drv.flush_cb = disp_flush;
 
+    /*Sleep instead of spinning while a flush is in progress*/
+    disp_drv.wait_cb = lv_port_wait_flush;
+
+    /*Render time of every refreshed frame*/
+    disp_drv.monitor_cb = disp_monitor;
+
     /*Set a display buffer*/
     disp_drv.draw_buf = &draw_buf_dsc_2;
 
@@ -144,8 +158,7 @@ void lv_port_disp_init(void)
 /*Initialize your display and the required peripherals.*/
 static void disp_init(void)
 {
-    /*You code here*/
-    tft_driver_init();
+    /*The panel is already up, main() brings it up first for the boot splash*/
 }
 
 volatile bool disp_flush_enabled = true;
@@ -164,9 +177,22 @@ void disp_disable_update(void)
     disp_flush_enabled = false;
 }
 
+static void disp_monitor(lv_disp_drv_t * disp_drv, uint32_t time, uint32_t px)
+{
+    indev_replay_frame(time, px);
+}
+
 void __time_critical_func(call_lv_disp_flush_ready)(void)
 {
+    if(lv_disp_flush_is_last(&disp_drv)) {
+        lowpower_frame_flushed();
+        disp_power_frame_flushed();
+        boot_time_frame();
+        latency_mark(LATENCY_DONE);
+    }
+
     lv_disp_flush_ready(&disp_drv);
+    lv_port_wake();
 }
 
 
@@ -175,6 +201,9 @@ void __time_critical_func(call_lv_disp_flush_ready)(void)
  *'lv_disp_flush_ready()' has to be called when finished.*/
 static void disp_flush(lv_disp_drv_t * disp_drv, const lv_area_t * area, lv_color_t * color_p)
 {
+    trace_span_begin(TRACE_SPAN_DISP_FLUSH);
+    latency_mark(LATENCY_FLUSH);
+
     if(disp_flush_enabled) {
         struct video_frame vf = {
             .xs = area->x1,
@@ -186,6 +215,12 @@ static void disp_flush(lv_disp_drv_t * disp_drv, const lv_area_t * area, lv_colo
         };
         tft_async_video_flush(&vf);
     }
+    else {
+        /*The panel sleeps, nothing will complete this area*/
+        lv_disp_flush_ready(disp_drv);
+    }
+
+    trace_span_end(TRACE_SPAN_DISP_FLUSH);
 
     /*IMPORTANT!!!
      *Inform the graphics library that you are ready with the flushing*/
@@ -13,12 +13,23 @@
 #include "lvgl/lvgl.h"
 
 #include <stdio.h>
+#include "hardware/timer.h"
 #include "indev.h"
+#include "indev_task.h"
+#include "lv_port_os.h"
+#include "latency.h"
+#include "indev_replay.h"
+#include "disp_power.h"
 
 /*********************
  *      DEFINES
  *********************/
 
+/*Screens with their own prediction setting*/
+#define TOUCHPAD_PREDICT_SCREENS    4
+/*Sample to glass when latency.c has no measurement*/
+#define TOUCHPAD_PREDICT_LEAD_US    25000
+
 /**********************
  *      TYPEDEFS
  **********************/
@@ -29,8 +40,9 @@
 
 static void touchpad_init(void);
 static void touchpad_read(lv_indev_drv_t * indev_drv, lv_indev_data_t * data);
-static bool touchpad_is_pressed(void);
-static void touchpad_get_xy(lv_coord_t * x, lv_coord_t * y);
+static void touchpad_gesture(const struct indev_frame * frame);
+static void touchpad_feedback(lv_indev_drv_t * indev_drv, uint8_t code);
+static void touchpad_predict(lv_indev_drv_t * indev_drv, lv_indev_data_t * data);
 
 static void mouse_init(void);
 static void mouse_read(lv_indev_drv_t * indev_drv, lv_indev_data_t * data);
@@ -59,6 +71,20 @@ lv_indev_t * indev_keypad;
 lv_indev_t * indev_encoder;
 lv_indev_t * indev_button;
 
+/* touch read timer is paused while released, the touch task wakes it */
+static volatile bool touch_data_pending;
+
+static struct indev_gesture_ctx touch_gesture;
+
+static struct indev_predict touch_predict;
+static const struct indev_predict_cfg * touch_predict_default;
+static struct {
+    lv_obj_t * scr;
+    const struct indev_predict_cfg * cfg;
+} touch_predict_scr[TOUCHPAD_PREDICT_SCREENS];
+
+uint32_t lv_port_event_gesture;
+
 static int32_t encoder_diff;
 static lv_indev_state_t encoder_state;
 
@@ -97,6 +123,7 @@ void lv_port_indev_init(void)
     lv_indev_drv_init(&indev_drv);
     indev_drv.type = LV_INDEV_TYPE_POINTER;
     indev_drv.read_cb = touchpad_read;
+    indev_drv.feedback_cb = touchpad_feedback;
     indev_touchpad = lv_indev_drv_register(&indev_drv);
 
     /*------------------
@@ -181,47 +208,196 @@ void lv_port_indev_init(void)
 /*------------------
  * Touchpad
  * -----------------*/
+
+/* called by the touch task whenever it queued a sample */
+static void touchpad_notify(void)
+{
+    touch_data_pending = true;
+    lv_port_wake();
+}
+
 /*Initialize your touchpad*/
 static void touchpad_init(void)
 {
     /*Your code comes here*/
-    indev_driver_init();
+    /*The touch task brings the controller up, see bringup.c*/
+    indev_task_set_notify(touchpad_notify);
+
+    /*LVGL 8.3 has no pinch/rotate of its own*/
+    lv_port_event_gesture = lv_event_register_id();
+    indev_gesture_reset(&touch_gesture);
 }
 
-/*Will be called by the library to read the touchpad*/
-static void touchpad_read(lv_indev_drv_t * indev_drv, lv_indev_data_t * data)
+bool lv_port_indev_pending(void)
+{
+    return touch_data_pending;
+}
+
+void lv_port_indev_resume(void)
 {
-    static lv_coord_t last_x = 0;
-    static lv_coord_t last_y = 0;
+    if(!touch_data_pending)
+        return;
 
-    /*Save the pressed coordinates and the state*/
-    if(touchpad_is_pressed()) {
-        touchpad_get_xy(&last_x, &last_y);
-        // printf("touchpad is pressed, x: %d, y: %d\n", last_x, last_y);
-        data->state = LV_INDEV_STATE_PR;
+    touch_data_pending = false;
+    lv_timer_resume(indev_touchpad->driver->read_timer);
+    lv_timer_ready(indev_touchpad->driver->read_timer);
+}
+
+/*Send pinch/rotate to the object being pressed, or the screen*/
+static void touchpad_gesture(const struct indev_frame * frame)
+{
+    struct indev_gesture g;
+    lv_obj_t * obj;
+
+    if(!indev_gesture_update(&touch_gesture, frame, &g))
+        return;
+
+    obj = indev_touchpad->proc.types.pointer.act_obj;
+    if(obj == NULL)
+        obj = lv_scr_act();
+
+    lv_event_send(obj, lv_port_event_gesture, &g);
+}
+
+/*Called by LVGL after the pressed object's handlers ran*/
+static void touchpad_feedback(lv_indev_drv_t * indev_drv, uint8_t code)
+{
+    if(code == LV_EVENT_PRESSED)
+        latency_mark(LATENCY_EVENT);
+}
+
+static void touchpad_predict_scr_deleted(lv_event_t * e)
+{
+    lv_port_indev_set_predict(lv_event_get_target(e), NULL);
+}
+
+int lv_port_indev_set_predict(lv_obj_t * scr, const struct indev_predict_cfg * cfg)
+{
+    int i, free_slot = -1;
+
+    if(scr == NULL) {
+        touch_predict_default = cfg;
+        return 0;
     }
-    else {
-        data->state = LV_INDEV_STATE_REL;
+
+    for(i = 0; i < TOUCHPAD_PREDICT_SCREENS; i++) {
+        if(touch_predict_scr[i].scr == scr) {
+            touch_predict_scr[i].cfg = cfg;
+            if(cfg == NULL)
+                touch_predict_scr[i].scr = NULL;
+            return 0;
+        }
+        if(touch_predict_scr[i].scr == NULL && free_slot < 0)
+            free_slot = i;
     }
 
-    /*Set the last pressed coordinates*/
-    data->point.x = last_x;
-    data->point.y = last_y;
+    if(cfg == NULL)
+        return 0;
+    if(free_slot < 0)
+        return -1;
+
+    touch_predict_scr[free_slot].scr = scr;
+    touch_predict_scr[free_slot].cfg = cfg;
+    lv_obj_add_event_cb(scr, touchpad_predict_scr_deleted, LV_EVENT_DELETE, NULL);
+    return 0;
 }
 
-/*Return true is the touchpad is pressed*/
-static bool touchpad_is_pressed(void)
+static const struct indev_predict_cfg * touchpad_predict_cfg(void)
 {
-    /*Your code comes here*/
-    return indev_is_pressed();
+    lv_obj_t * scr = lv_scr_act();
+
+    for(int i = 0; i < TOUCHPAD_PREDICT_SCREENS; i++)
+        if(touch_predict_scr[i].scr == scr)
+            return touch_predict_scr[i].cfg;
+
+    return touch_predict_default;
 }
 
-/*Get the x and y coordinates if the touchpad is pressed*/
-static void touchpad_get_xy(lv_coord_t * x, lv_coord_t * y)
+/*Time from read_cb to the glass, the measured median when there is one*/
+static uint32_t touchpad_predict_lead(const struct indev_predict_cfg * cfg)
 {
-    /*Your code comes here*/
-    (*x) = indev_read_x();
-    (*y) = indev_read_y(); 
+    uint32_t read, done;
+
+    if(cfg->lead_us)
+        return cfg->lead_us;
+
+    if(latency_count() >= 8) {
+        read = latency_percentile(LATENCY_READ, 50);
+        done = latency_percentile(LATENCY_DONE, 50);
+        if(done > read)
+            return done - read;
+    }
+
+    return TOUCHPAD_PREDICT_LEAD_US;
+}
+
+/*Move the reported point to where the finger will be when the frame shows*/
+static void touchpad_predict(lv_indev_drv_t * indev_drv, lv_indev_data_t * data)
+{
+    const struct indev_predict_cfg * cfg = touchpad_predict_cfg();
+    int16_t x, y;
+
+    if(cfg == NULL)
+        return;
+
+    if(!indev_predict_get(&touch_predict, cfg, time_us_32(), touchpad_predict_lead(cfg), &x, &y))
+        return;
+
+    data->point.x = LV_CLAMP(0, x, lv_disp_get_hor_res(indev_drv->disp) - 1);
+    data->point.y = LV_CLAMP(0, y, lv_disp_get_ver_res(indev_drv->disp) - 1);
+}
+
+/*Will be called by the library to read the touchpad.
+ *Only consumes samples queued by the touch task, never touches the bus.*/
+static void touchpad_read(lv_indev_drv_t * indev_drv, lv_indev_data_t * data)
+{
+    static struct indev_sample last;
+    static bool swallow;
+    struct indev_sample s;
+
+    /*A replay owns the pointer, real touches are dropped meanwhile*/
+    if(indev_replay_playing()) {
+        while(indev_task_pop(&s));
+        last.pressed = false;
+        indev_replay_read(indev_drv, data);
+        return;
+    }
+
+    if(indev_task_pop(&s)) {
+        /*A touch on a panel that was not fully visible only wakes it*/
+        if(s.pressed && !last.pressed && disp_power_wake())
+            swallow = true;
+        if(!s.pressed)
+            swallow = false;
+        if(swallow)
+            s.pressed = false;
+
+        if(s.pressed && !last.pressed)
+            latency_mark(LATENCY_READ);
+        last = s;
+        if(s.pressed)
+            indev_predict_push(&touch_predict, s.ts, s.x, s.y);
+        else
+            indev_predict_reset(&touch_predict);
+        touchpad_gesture(&s.frame);
+    }
+
+    data->state = last.pressed ? LV_INDEV_STATE_PR : LV_INDEV_STATE_REL;
+    data->point.x = last.x;
+    data->point.y = last.y;
+
+    /*Let LVGL process every buffered sample in this read cycle*/
+    data->continue_reading = !indev_task_empty();
+
+    indev_replay_record(data);
+
+    /*Only the newest sample is moved ahead, queued ones are history*/
+    if(last.pressed && !data->continue_reading)
+        touchpad_predict(indev_drv, data);
+
+    /* nothing to read until the touch task queues the next sample */
+    if(!last.pressed && !data->continue_reading)
+        lv_timer_pause(indev_drv->read_timer);
 }
 
 /*------------------
@@ -18,6 +18,8 @@ extern "C" {
  *      INCLUDES
  *********************/
 #include "lvgl/lvgl.h"
+#include "indev_gesture.h"
+#include "indev_predict.h"
 
 /*********************
  *      DEFINES
@@ -32,6 +34,22 @@ extern "C" {
  **********************/
 void lv_port_indev_init(void);
 
+/* Event code sent to the pressed object (or the active screen) for two
+ * finger pinch/rotate, lv_event_get_param() is a const struct indev_gesture * */
+extern uint32_t lv_port_event_gesture;
+
+/* Touch interrupt seen since the last lv_port_indev_resume() */
+bool lv_port_indev_pending(void);
+
+/* Restart the paused touch read timer after a touch interrupt,
+ * called by the LVGL task before lv_timer_handler() */
+void lv_port_indev_resume(void);
+
+/* Drag prediction on scr, NULL for every screen without its own setting.
+ * A NULL cfg turns it off, cfg must stay valid while it is in use.
+ * Returns -1 when all per screen slots are taken.*/
+int lv_port_indev_set_predict(lv_obj_t * scr, const struct indev_predict_cfg * cfg);
+
 /**********************
  *      MACROS
  **********************/
@@ -0,0 +1,174 @@
+/**
+ * @file lv_port_os.c
+ *
+ * Event driven LVGL scheduling.
+ *
+ * The LVGL task runs lv_timer_handler() and then blocks on its task
+ * notification for exactly the time LVGL reported until its next timer.
+ * Touch interrupts and flush completion notify the task, so it wakes
+ * early for input and sleeps indefinitely when every LVGL timer is
+ * paused. The tick comes from the 64-bit us timer, no tick hook needed.
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lv_port_os.h"
+#include "lv_port_disp_template.h"
+#include "lv_port_indev_template.h"
+#include "lvgl/lvgl.h"
+
+#include "pico/time.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "rtos_alloc.h"
+#include "trace.h"
+#include "lowpower.h"
+#include "boot_time.h"
+#include "bringup.h"
+#include "debug.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define LV_PORT_TASK_STACK  2048
+#define LV_PORT_TASK_PRIO   (tskIDLE_PRIORITY + 3)
+#define LV_PORT_CALL_QUEUE  4
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static TaskHandle_t lvgl_task_handle;
+
+static struct {
+    void (*fn)(void *);
+    void * arg;
+} call_queue[LV_PORT_CALL_QUEUE];
+static volatile uint32_t call_head;
+static volatile uint32_t call_count;
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static void lv_port_run_calls(void)
+{
+    void (*fn)(void *);
+    void * arg;
+
+    while(call_count) {
+        taskENTER_CRITICAL();
+        fn = call_queue[call_head].fn;
+        arg = call_queue[call_head].arg;
+        call_head = (call_head + 1) % LV_PORT_CALL_QUEUE;
+        call_count--;
+        taskEXIT_CRITICAL();
+
+        fn(arg);
+    }
+}
+
+static void lv_port_sleep(uint32_t ms)
+{
+    TickType_t ticks = (ms == LV_NO_TIMER_READY) ? portMAX_DELAY : pdMS_TO_TICKS(ms);
+
+    /* the wake-up may have been eaten by lv_port_wait_flush() */
+    if (lv_port_indev_pending() || call_count)
+        return;
+
+    lowpower_lvgl_sleep(ms == LV_NO_TIMER_READY);
+    ulTaskNotifyTakeIndexed(LV_PORT_NOTIFY_INDEX, pdTRUE, ticks);
+}
+
+static portTASK_FUNCTION(lv_timer_task_handler, pvParameters)
+{
+    uint32_t next_ms;
+
+    bringup_run(BRINGUP_LVGL);
+    bringup_run(BRINGUP_UI);
+
+    /*The first frame would only block on the flush queue until the panel is up*/
+    bringup_wait(BRINGUP_BIT(BRINGUP_PANEL));
+
+    for(;;) {
+        lv_port_indev_resume();
+        lv_port_run_calls();
+
+        trace_span_begin(TRACE_SPAN_LV_TIMER);
+        next_ms = lv_timer_handler();
+        trace_span_end(TRACE_SPAN_LV_TIMER);
+        boot_time_report();
+
+        lv_port_sleep(next_ms);
+    }
+
+    vTaskDelete(NULL);
+}
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+uint32_t lv_port_tick_get(void)
+{
+    return (uint32_t)(time_us_64() / 1000);
+}
+
+void lv_port_wake(void)
+{
+    if (lvgl_task_handle)
+        xTaskNotifyGiveIndexed(lvgl_task_handle, LV_PORT_NOTIFY_INDEX);
+}
+
+void lv_port_wake_from_isr(void)
+{
+    BaseType_t woken = pdFALSE;
+
+    if (lvgl_task_handle) {
+        vTaskNotifyGiveIndexedFromISR(lvgl_task_handle, LV_PORT_NOTIFY_INDEX, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+}
+
+int lv_port_call(void (*fn)(void *), void * arg)
+{
+    int ret = 0;
+
+    taskENTER_CRITICAL();
+    if(call_count < LV_PORT_CALL_QUEUE) {
+        call_queue[(call_head + call_count) % LV_PORT_CALL_QUEUE].fn = fn;
+        call_queue[(call_head + call_count) % LV_PORT_CALL_QUEUE].arg = arg;
+        call_count++;
+    }
+    else {
+        ret = -1;
+    }
+    taskEXIT_CRITICAL();
+
+    if(ret == 0)
+        lv_port_wake();
+
+    return ret;
+}
+
+/*
+ * LVGL calls the display driver's wait_cb while it spins on a flush in
+ * progress. Block instead, flush completion wakes us through lv_port_wake().
+ */
+void lv_port_wait_flush(lv_disp_drv_t * disp_drv)
+{
+    if (xTaskGetSchedulerState() != taskSCHEDULER_RUNNING ||
+        xTaskGetCurrentTaskHandle() != lvgl_task_handle)
+        return;
+
+    ulTaskNotifyTakeIndexed(LV_PORT_NOTIFY_INDEX, pdTRUE, 1);
+}
+
+void lv_port_os_init(void)
+{
+    rtos_task_create(lv_timer_task_handler, "lvgl_task", LV_PORT_TASK_STACK, NULL,
+                     LV_PORT_TASK_PRIO, &lvgl_task_handle);
+    vTaskCoreAffinitySet(lvgl_task_handle, (1 << 0));
+}
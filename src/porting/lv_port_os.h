@@ -0,0 +1,50 @@
+/**
+ * @file lv_port_os.h
+ *
+ */
+
+#ifndef LV_PORT_OS_H
+#define LV_PORT_OS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+/* Also used as LV_TICK_CUSTOM_INCLUDE, keep it free of SDK and RTOS headers */
+#include <stdint.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+/* task notification slot used to wake the LVGL task */
+#define LV_PORT_NOTIFY_INDEX    0
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+/* Milliseconds since boot from the 64-bit us timer, LVGL's tick source */
+uint32_t lv_port_tick_get(void);
+
+/* Create the LVGL task, it only wakes for the next LVGL timer or an event */
+void lv_port_os_init(void);
+
+/* Wake the LVGL task early, e.g. on touch input or flush completion */
+void lv_port_wake(void);
+void lv_port_wake_from_isr(void);
+
+/* Run fn(arg) in the LVGL task, for other tasks that need to touch LVGL
+ * objects. Returns -1 when the queue is full. */
+int lv_port_call(void (*fn)(void *), void * arg);
+
+/* wait_cb of the display driver, blocks until the running flush is done */
+struct _lv_disp_drv_t;
+void lv_port_wait_flush(struct _lv_disp_drv_t * disp_drv);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*LV_PORT_OS_H*/
@@ -0,0 +1,266 @@
+// Copyright (c) 2024 embeddedboys developers
+
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+/*
+ * Statistical sampling profiler.
+ *
+ * Each core gets its own hardware timer alarm whose IRQ is only enabled in
+ * that core's NVIC. The handler picks the exception frame of whatever was
+ * interrupted and records the stacked PC and LR in a per-core open
+ * addressing histogram, then re-arms the alarm. LR gives an approximate
+ * caller for the call graph, exact for leaf functions.
+ *
+ * "prof dump" prints the histogram; scripts/prof_symbolize.py resolves it
+ * against the .elf into flat and caller reports.
+ */
+
+#define pr_fmt(fmt) "prof: " fmt
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "pico/platform.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+#include "hardware/timer.h"
+#include "hardware/structs/timer.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "prof.h"
+#include "console.h"
+#include "debug.h"
+
+#if PROF_ENABLED
+
+#if (PROF_HIST_SIZE & (PROF_HIST_SIZE - 1))
+#error "PROF_HIST_SIZE must be a power of two"
+#endif
+
+#define PROF_MAX_PROBE  8
+
+struct prof_core {
+    struct prof_slot hist[PROF_HIST_SIZE];
+    uint32_t samples;
+    uint32_t dropped;   /* histogram too full to place the sample */
+    int      alarm;
+};
+
+static struct prof_core g_prof[NUM_CORES];
+static volatile uint32_t g_period_us;
+static uint32_t g_hz;
+static bool g_running;
+
+/* called with the interrupted context's exception frame: r0-r3, r12, lr, pc, xpsr */
+void __attribute__((used)) __time_critical_func(prof_sample)(uint32_t *frame)
+{
+    struct prof_core *p = &g_prof[get_core_num()];
+    uint32_t pc = frame[6];
+    uint32_t lr = frame[5] & ~1u;
+    uint32_t idx;
+
+    timer_hw->intr = 1u << p->alarm;
+    timer_hw->alarm[p->alarm] = timer_hw->timerawl + g_period_us;
+
+    p->samples++;
+
+    idx = ((pc >> 1) ^ (lr * 0x9e3779b1u >> 16)) & (PROF_HIST_SIZE - 1);
+    for (int i = 0; i < PROF_MAX_PROBE; i++) {
+        struct prof_slot *s = &p->hist[(idx + i) & (PROF_HIST_SIZE - 1)];
+
+        if (s->count && (s->pc != pc || s->lr != lr))
+            continue;
+
+        s->pc = pc;
+        s->lr = lr;
+        s->count++;
+        return;
+    }
+
+    p->dropped++;
+}
+
+/*
+ * Find the frame of the interrupted context: bit 2 of EXC_RETURN tells
+ * whether it was on the process (task) or main (ISR/boot) stack. Tail
+ * calls prof_sample() so its return is the exception return.
+ */
+static void __attribute__((naked)) __time_critical_func(prof_irq_handler)(void)
+{
+    __asm volatile(
+        "movs r0, #4        \n"
+        "mov  r1, lr        \n"
+        "tst  r0, r1        \n"
+        "beq  1f            \n"
+        "mrs  r0, psp       \n"
+        "b    2f            \n"
+        "1:                 \n"
+        "mrs  r0, msp       \n"
+        "2:                 \n"
+        "ldr  r2, =prof_sample \n"
+        "bx   r2            \n"
+        ".align 2           \n"
+        ".ltorg             \n"
+    );
+}
+
+/* NVIC enables are per core, so hop the calling task over to each core */
+static void prof_run_on_core(uint core, void (*fn)(uint core))
+{
+    UBaseType_t affinity = vTaskCoreAffinityGet(NULL);
+
+    vTaskCoreAffinitySet(NULL, 1u << core);
+    while (get_core_num() != core)
+        taskYIELD();
+
+    fn(core);
+
+    vTaskCoreAffinitySet(NULL, affinity);
+}
+
+static void prof_arm_core(uint core)
+{
+    int alarm = g_prof[core].alarm;
+
+    irq_set_priority(TIMER_IRQ_0 + alarm, 0);
+    irq_set_enabled(TIMER_IRQ_0 + alarm, true);
+    hw_set_bits(&timer_hw->inte, 1u << alarm);
+    timer_hw->alarm[alarm] = timer_hw->timerawl + g_period_us;
+}
+
+static void prof_disarm_core(uint core)
+{
+    int alarm = g_prof[core].alarm;
+
+    hw_clear_bits(&timer_hw->inte, 1u << alarm);
+    timer_hw->armed = 1u << alarm;
+    irq_set_enabled(TIMER_IRQ_0 + alarm, false);
+    timer_hw->intr = 1u << alarm;
+}
+
+int prof_start(uint32_t hz)
+{
+    if (g_running)
+        prof_stop();
+
+    if (!hz || hz > 20000) {
+        pr_error("sample rate %lu Hz out of range (1..20000)\n", hz);
+        return -1;
+    }
+
+    g_hz = hz;
+    g_period_us = 1000000 / hz;
+
+    for (uint core = 0; core < NUM_CORES; core++)
+        prof_run_on_core(core, prof_arm_core);
+
+    g_running = true;
+    return 0;
+}
+
+void prof_stop(void)
+{
+    if (!g_running)
+        return;
+
+    for (uint core = 0; core < NUM_CORES; core++)
+        prof_run_on_core(core, prof_disarm_core);
+
+    g_running = false;
+}
+
+void prof_clear(void)
+{
+    bool running = g_running;
+
+    prof_stop();
+
+    for (int core = 0; core < NUM_CORES; core++) {
+        memset(g_prof[core].hist, 0, sizeof(g_prof[core].hist));
+        g_prof[core].samples = 0;
+        g_prof[core].dropped = 0;
+    }
+
+    if (running)
+        prof_start(g_hz);
+}
+
+void prof_dump(void)
+{
+    bool running = g_running;
+
+    prof_stop();
+
+    printf("# prof begin hz=%lu\n", g_hz);
+    for (int core = 0; core < NUM_CORES; core++) {
+        struct prof_core *p = &g_prof[core];
+
+        printf("C %d %lu %lu\n", core, p->samples, p->dropped);
+        for (int i = 0; i < PROF_HIST_SIZE; i++) {
+            if (p->hist[i].count)
+                printf("P %d %08lx %08lx %lu\n", core,
+                       p->hist[i].pc, p->hist[i].lr, p->hist[i].count);
+        }
+    }
+    printf("# prof end\n");
+
+    if (running)
+        prof_start(g_hz);
+}
+
+static int prof_cmd(int argc, char **argv)
+{
+    if (argc < 2 || !strcmp(argv[1], "dump")) {
+        prof_dump();
+    } else if (!strcmp(argv[1], "start")) {
+        return prof_start(argc > 2 ? strtoul(argv[2], NULL, 0) : PROF_DEFAULT_HZ);
+    } else if (!strcmp(argv[1], "stop")) {
+        prof_stop();
+    } else if (!strcmp(argv[1], "clear")) {
+        prof_clear();
+    } else {
+        printf("usage: prof [start [hz]|stop|clear|dump]\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+static const struct console_cmd prof_console_cmd = {
+    .name = "prof",
+    .help = "prof [start [hz]|stop|clear|dump], dump feeds scripts/prof_symbolize.py",
+    .fn = prof_cmd,
+};
+
+void prof_init(void)
+{
+    for (int core = 0; core < NUM_CORES; core++) {
+        g_prof[core].alarm = hardware_alarm_claim_unused(true);
+        irq_set_exclusive_handler(TIMER_IRQ_0 + g_prof[core].alarm, prof_irq_handler);
+    }
+
+    console_register(&prof_console_cmd);
+}
+
+#endif /* PROF_ENABLED */
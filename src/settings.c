@@ -0,0 +1,474 @@
+// Copyright (c) 2024 embeddedboys developers
+
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+/*
+ * Persistent settings, a small log-structured key-value store in the last
+ * SETTINGS_SECTORS sectors of flash.
+ *
+ * Each sector starts with a header (magic, sequence number, commit word)
+ * followed by records appended in order: key, length, CRC-8 and the value
+ * padded to a word. A record with length 0 deletes its key. Appending
+ * programs only the page(s) the record lands in; the rest is written as
+ * 0xFF, which leaves NOR flash untouched.
+ *
+ * When the active sector is full, the live records are copied into the
+ * next sector, which only becomes valid once its commit word is written,
+ * so a reset in the middle leaves the old sector in use. Sectors are used
+ * in turn, which spreads the erases.
+ *
+ * settings_init() reads the headers and scans the active sector once to
+ * index the newest record of every key. A get is then one XIP copy.
+ * Flash is written through flash_safe_execute(), which parks the other
+ * core and masks interrupts while XIP is unavailable.
+ */
+
+#define pr_fmt(fmt) "settings: " fmt
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "pico/flash.h"
+#include "pico/mutex.h"
+#include "hardware/flash.h"
+#include "hardware/timer.h"
+
+#include "settings.h"
+#include "console.h"
+#include "debug.h"
+
+#if SETTINGS_ENABLED
+
+#if SETTINGS_SECTORS < 2
+#error "the compaction needs a spare sector"
+#endif
+
+#define SETTINGS_MAGIC          0x54544553      /* "SETT" */
+#define SETTINGS_COMMIT         0x0000C0DE
+#define SETTINGS_REGION_OFFS    (PICO_FLASH_SIZE_BYTES - SETTINGS_SECTORS * FLASH_SECTOR_SIZE)
+#define SETTINGS_KEY_FREE       0xFFFF
+#define SETTINGS_FLASH_TIMEOUT_MS   100
+
+#define SETTINGS_ALIGN(n)       (((n) + 3) & ~3)
+
+struct settings_hdr {
+    uint32_t magic;
+    uint32_t seq;
+    uint32_t commit;            /* SETTINGS_COMMIT once the copy is complete */
+    uint32_t reserved;
+};
+
+struct settings_rec {
+    uint16_t key;
+    uint8_t  len;
+    uint8_t  crc;               /* over key, len and the value */
+    uint8_t  data[];
+};
+
+/* one flash_safe_execute() call, erase when data is NULL */
+struct settings_op {
+    uint32_t offs;
+    const uint8_t *data;
+    size_t len;
+};
+
+static struct {
+    mutex_t lock;
+    bool usable;
+
+    int sector;                 /* active sector, -1 when nothing is stored yet */
+    uint32_t seq;
+    uint32_t end;               /* append offset in the active sector */
+
+    int nr_keys;
+    struct {
+        uint16_t key;
+        uint16_t offs;
+    } idx[SETTINGS_MAX_KEYS];
+
+    uint32_t scan_us;
+    uint32_t scan_recs;
+    uint32_t writes;
+    uint32_t compactions;
+
+    /* flash_range_program() can't take its data from flash */
+    uint8_t page[2 * FLASH_PAGE_SIZE];
+    uint8_t rec[sizeof(struct settings_rec) + SETTINGS_MAX_LEN] __attribute__((aligned(4)));
+} g_settings;
+
+static inline uint32_t settings_offs(int sector)
+{
+    return SETTINGS_REGION_OFFS + sector * FLASH_SECTOR_SIZE;
+}
+
+static inline const void *settings_xip(int sector, uint32_t offs)
+{
+    return (const void *)(XIP_BASE + settings_offs(sector) + offs);
+}
+
+static uint8_t settings_crc8(uint8_t crc, const uint8_t *p, size_t len)
+{
+    while (len--) {
+        crc ^= *p++;
+        for (int i = 0; i < 8; i++)
+            crc = crc & 0x80 ? (crc << 1) ^ 0x07 : crc << 1;
+    }
+    return crc;
+}
+
+static uint8_t settings_rec_crc(const struct settings_rec *rec)
+{
+    uint8_t crc = settings_crc8(0, (const uint8_t *)&rec->key, sizeof(rec->key));
+
+    crc = settings_crc8(crc, &rec->len, sizeof(rec->len));
+    return settings_crc8(crc, rec->data, rec->len);
+}
+
+static void settings_flash_op(void *param)
+{
+    struct settings_op *op = param;
+
+    if (!op->data)
+        flash_range_erase(op->offs, FLASH_SECTOR_SIZE);
+    else
+        flash_range_program(op->offs, op->data, op->len);
+}
+
+static int settings_flash(uint32_t offs, const void *data, size_t len)
+{
+    struct settings_op op = {
+        .offs = offs,
+        .data = data,
+        .len = len,
+    };
+    int ret;
+
+    ret = flash_safe_execute(settings_flash_op, &op, SETTINGS_FLASH_TIMEOUT_MS);
+    if (ret != PICO_OK) {
+        pr_error("flash %s at 0x%08lx failed, %d\n", data ? "program" : "erase", offs, ret);
+        return -1;
+    }
+    return 0;
+}
+
+/* program len bytes at offs of a sector, the rest of the touched pages stays as is */
+static int settings_program(int sector, uint32_t offs, const void *data, size_t len)
+{
+    uint32_t start = offs & ~(FLASH_PAGE_SIZE - 1);
+    uint32_t end = (offs + len + FLASH_PAGE_SIZE - 1) & ~(FLASH_PAGE_SIZE - 1);
+
+    if (end - start > sizeof(g_settings.page))
+        return -1;
+
+    memset(g_settings.page, 0xFF, end - start);
+    memcpy(g_settings.page + offs - start, data, len);
+
+    return settings_flash(settings_offs(sector) + start, g_settings.page, end - start);
+}
+
+static int settings_find(uint16_t key)
+{
+    for (int i = 0; i < g_settings.nr_keys; i++)
+        if (g_settings.idx[i].key == key)
+            return i;
+    return -1;
+}
+
+static void settings_index(uint16_t key, uint8_t len, uint32_t offs)
+{
+    int i = settings_find(key);
+
+    if (!len) {
+        if (i >= 0)
+            g_settings.idx[i] = g_settings.idx[--g_settings.nr_keys];
+        return;
+    }
+
+    if (i < 0) {
+        if (g_settings.nr_keys == SETTINGS_MAX_KEYS) {
+            pr_warn("index full, key %u dropped\n", key);
+            return;
+        }
+        i = g_settings.nr_keys++;
+    }
+
+    g_settings.idx[i].key = key;
+    g_settings.idx[i].offs = offs;
+}
+
+static void settings_scan(int sector)
+{
+    uint32_t offs = sizeof(struct settings_hdr);
+    const struct settings_rec *rec;
+
+    g_settings.nr_keys = 0;
+    g_settings.scan_recs = 0;
+
+    while (offs + sizeof(*rec) <= FLASH_SECTOR_SIZE) {
+        uint32_t size;
+
+        rec = settings_xip(sector, offs);
+        if (rec->key == SETTINGS_KEY_FREE)
+            break;
+
+        size = SETTINGS_ALIGN(sizeof(*rec) + rec->len);
+        if (rec->len > SETTINGS_MAX_LEN || offs + size > FLASH_SECTOR_SIZE) {
+            /* torn header, nothing after it can be trusted; compact on the next write */
+            pr_warn("bad record at %lu, sector %d\n", offs, sector);
+            offs = FLASH_SECTOR_SIZE;
+            break;
+        }
+
+        if (rec->crc == settings_rec_crc(rec))
+            settings_index(rec->key, rec->len, offs);
+
+        g_settings.scan_recs++;
+        offs += size;
+    }
+
+    g_settings.end = offs;
+}
+
+static int settings_append(int sector, uint32_t *offs, uint16_t key, const void *buf, size_t len)
+{
+    struct settings_rec *rec = (struct settings_rec *)g_settings.rec;
+    uint32_t size = SETTINGS_ALIGN(sizeof(*rec) + len);
+
+    if (*offs + size > FLASH_SECTOR_SIZE)
+        return -1;
+
+    memset(rec, 0xFF, size);
+    rec->key = key;
+    rec->len = len;
+    memcpy(rec->data, buf, len);
+    rec->crc = settings_rec_crc(rec);
+
+    if (settings_program(sector, *offs, rec, size))
+        return -1;
+
+    *offs += size;
+    return 0;
+}
+
+/* copy the live keys, key replaced by buf, into the next sector and switch to it */
+static int settings_compact(uint16_t key, const void *buf, size_t len)
+{
+    int to = g_settings.sector < 0 ? 0 : (g_settings.sector + 1) % SETTINGS_SECTORS;
+    struct settings_hdr hdr = {
+        .magic = SETTINGS_MAGIC,
+        .seq = g_settings.seq + 1,
+        .commit = 0xFFFFFFFF,
+        .reserved = 0xFFFFFFFF,
+    };
+    uint32_t commit = SETTINGS_COMMIT;
+    uint32_t offs = sizeof(hdr);
+
+    if (settings_flash(settings_offs(to), NULL, 0))
+        return -1;
+    if (settings_program(to, 0, &hdr, sizeof(hdr)))
+        return -1;
+
+    for (int i = 0; i < g_settings.nr_keys; i++) {
+        const struct settings_rec *rec = settings_xip(g_settings.sector, g_settings.idx[i].offs);
+
+        if (rec->key == key)
+            continue;
+        /* the value is copied to RAM before XIP goes away for the program */
+        if (settings_append(to, &offs, rec->key, rec->data, rec->len))
+            return -1;
+    }
+
+    if (len && settings_append(to, &offs, key, buf, len))
+        return -1;
+
+    if (settings_program(to, offsetof(struct settings_hdr, commit), &commit, sizeof(commit)))
+        return -1;
+
+    g_settings.sector = to;
+    g_settings.seq = hdr.seq;
+    g_settings.compactions++;
+    settings_scan(to);
+
+    pr_debug("compacted into sector %d, seq %lu, %lu bytes\n", to, g_settings.seq, g_settings.end);
+    return 0;
+}
+
+int settings_get(uint16_t key, void *buf, size_t len)
+{
+    const struct settings_rec *rec;
+    int i, ret = -1;
+
+    if (!g_settings.usable)
+        return -1;
+
+    mutex_enter_blocking(&g_settings.lock);
+    i = settings_find(key);
+    if (i >= 0) {
+        rec = settings_xip(g_settings.sector, g_settings.idx[i].offs);
+        ret = rec->len < len ? rec->len : len;
+        memcpy(buf, rec->data, ret);
+    }
+    mutex_exit(&g_settings.lock);
+
+    return ret;
+}
+
+int settings_set(uint16_t key, const void *buf, size_t len)
+{
+    const struct settings_rec *rec;
+    int i, ret;
+
+    if (!g_settings.usable || key == SETTINGS_KEY_FREE || len > SETTINGS_MAX_LEN)
+        return -1;
+
+    mutex_enter_blocking(&g_settings.lock);
+
+    /* unchanged values cost no flash wear */
+    i = settings_find(key);
+    if (i >= 0) {
+        rec = settings_xip(g_settings.sector, g_settings.idx[i].offs);
+        if (rec->len == len && !memcmp(rec->data, buf, len)) {
+            mutex_exit(&g_settings.lock);
+            return 0;
+        }
+    } else if (!len) {
+        mutex_exit(&g_settings.lock);
+        return 0;
+    }
+
+    if (g_settings.sector < 0 ||
+        g_settings.end + SETTINGS_ALIGN(sizeof(*rec) + len) > FLASH_SECTOR_SIZE) {
+        ret = settings_compact(key, buf, len);
+    } else {
+        uint32_t offs = g_settings.end;
+
+        ret = settings_append(g_settings.sector, &g_settings.end, key, buf, len);
+        if (!ret)
+            settings_index(key, len, offs);
+    }
+    g_settings.writes++;
+
+    mutex_exit(&g_settings.lock);
+
+    return ret;
+}
+
+int settings_del(uint16_t key)
+{
+    return settings_set(key, NULL, 0);
+}
+
+static int settings_erase(void)
+{
+    int ret = 0;
+
+    mutex_enter_blocking(&g_settings.lock);
+    for (int i = 0; i < SETTINGS_SECTORS; i++)
+        ret |= settings_flash(settings_offs(i), NULL, 0);
+    g_settings.sector = -1;
+    g_settings.seq = 0;
+    g_settings.nr_keys = 0;
+    mutex_exit(&g_settings.lock);
+
+    return ret;
+}
+
+static int settings_cmd(int argc, char **argv)
+{
+    if (argc > 2 && !strcmp(argv[1], "del"))
+        return settings_del(strtoul(argv[2], NULL, 0));
+    if (argc > 2 && !strcmp(argv[1], "busclk")) {
+        uint32_t khz = strtoul(argv[2], NULL, 0);
+
+        /* applied by the next boot, the bus is busy with frames now */
+        return khz ? settings_set(SETTINGS_KEY_BUS_CLK_KHZ, &khz, sizeof(khz)) :
+                     settings_del(SETTINGS_KEY_BUS_CLK_KHZ);
+    }
+    if (argc > 1 && !strcmp(argv[1], "erase"))
+        return settings_erase();
+    if (argc > 1)
+        return -1;
+
+    printf("sector %d of %d at 0x%08x, seq %lu, %lu/%u bytes used\n",
+           g_settings.sector, SETTINGS_SECTORS, SETTINGS_REGION_OFFS,
+           g_settings.seq, g_settings.end, FLASH_SECTOR_SIZE);
+    printf("boot scan %lu records in %lu us, %lu writes, %lu compactions\n",
+           g_settings.scan_recs, g_settings.scan_us, g_settings.writes, g_settings.compactions);
+
+    mutex_enter_blocking(&g_settings.lock);
+    for (int i = 0; i < g_settings.nr_keys; i++) {
+        const struct settings_rec *rec = settings_xip(g_settings.sector, g_settings.idx[i].offs);
+
+        printf("  key %3u, %2u bytes:", rec->key, rec->len);
+        for (int j = 0; j < rec->len; j++)
+            printf(" %02x", rec->data[j]);
+        printf("\n");
+    }
+    mutex_exit(&g_settings.lock);
+
+    return 0;
+}
+
+static const struct console_cmd settings_console_cmd = {
+    .name = "settings",
+    .help = "settings [del key|busclk khz|erase], persistent settings in flash",
+    .fn = settings_cmd,
+};
+
+void settings_init(void)
+{
+    extern char __flash_binary_end;
+    uint32_t t0 = time_us_32();
+
+    mutex_init(&g_settings.lock);
+    g_settings.sector = -1;
+
+    console_register(&settings_console_cmd);
+
+    if ((uint32_t)&__flash_binary_end - XIP_BASE > SETTINGS_REGION_OFFS) {
+        pr_error("firmware overlaps the settings sectors\n");
+        return;
+    }
+    g_settings.usable = true;
+
+    /* the newest committed sector wins */
+    for (int i = 0; i < SETTINGS_SECTORS; i++) {
+        const struct settings_hdr *hdr = settings_xip(i, 0);
+
+        if (hdr->magic != SETTINGS_MAGIC || hdr->commit != SETTINGS_COMMIT)
+            continue;
+        if (g_settings.sector < 0 || (int32_t)(hdr->seq - g_settings.seq) > 0) {
+            g_settings.sector = i;
+            g_settings.seq = hdr->seq;
+        }
+    }
+
+    if (g_settings.sector >= 0)
+        settings_scan(g_settings.sector);
+
+    g_settings.scan_us = time_us_32() - t0;
+    pr_info("sector %d, %d keys, %lu bytes used, %lu us\n",
+            g_settings.sector, g_settings.nr_keys, g_settings.end, g_settings.scan_us);
+}
+
+#endif
@@ -0,0 +1,72 @@
+// Copyright (c) 2024 embeddedboys developers
+
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+/*
+ * Boot splash.
+ *
+ * Drawn straight to the panel once its init sequence is done, before the
+ * backlight comes on, so the garbage in GRAM after reset is never seen
+ * and LVGL, touch and the UI come up behind it. The image is a list of
+ * colour runs in flash; each run is one DMA transfer with a fixed read
+ * address, the CPU only walks the list.
+ */
+
+#define pr_fmt(fmt) "splash: " fmt
+
+#include <stdio.h>
+
+#include "lvgl/lvgl.h"
+
+#include "splash.h"
+#include "tft.h"
+#include "boot_time.h"
+#include "debug.h"
+
+#if SPLASH_ENABLED
+
+/* to the byte order of a draw buffer, which is what goes on the bus */
+static inline u16 splash_px(u16 c)
+{
+#if LV_COLOR_16_SWAP
+    return (c >> 8) | (c << 8);
+#else
+    return c;
+#endif
+}
+
+void splash_show(void)
+{
+    const struct splash_img *img = &splash_img;
+    int xs = (LCD_HOR_RES - img->w) / 2;
+    int ys = (LCD_VER_RES - img->h) / 2;
+
+    tft_set_window(0, 0, LCD_HOR_RES - 1, LCD_VER_RES - 1);
+    tft_fill(splash_px(img->bg), LCD_HOR_RES * LCD_VER_RES);
+
+    tft_set_window(xs, ys, xs + img->w - 1, ys + img->h - 1);
+    for (int i = 0; i < img->nr_runs; i++)
+        tft_fill(splash_px(img->runs[i].color), img->runs[i].count);
+
+    boot_mark("splash");
+}
+
+#endif
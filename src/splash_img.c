@@ -0,0 +1,97 @@
+// Copyright (c) 2024 embeddedboys developers
+
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+/* generated by scripts/splash_rle.py, do not edit */
+
+#include "splash.h"
+
+static const struct splash_run splash_runs[] = {
+    {   233, 0x10a3 }, {    14, 0x24be }, {    77, 0x10a3 }, {    24, 0x24be }, {    69, 0x10a3 }, {    30, 0x24be },
+    {    63, 0x10a3 }, {    36, 0x24be }, {    58, 0x10a3 }, {    40, 0x24be }, {    54, 0x10a3 }, {    44, 0x24be },
+    {    50, 0x10a3 }, {    48, 0x24be }, {    47, 0x10a3 }, {    50, 0x24be }, {    44, 0x10a3 }, {    54, 0x24be },
+    {    41, 0x10a3 }, {    56, 0x24be }, {    39, 0x10a3 }, {    58, 0x24be }, {    37, 0x10a3 }, {    60, 0x24be },
+    {    34, 0x10a3 }, {    64, 0x24be }, {    31, 0x10a3 }, {    66, 0x24be }, {    29, 0x10a3 }, {    28, 0x24be },
+    {    12, 0x10a3 }, {    28, 0x24be }, {    28, 0x10a3 }, {    24, 0x24be }, {    20, 0x10a3 }, {    24, 0x24be },
+    {    27, 0x10a3 }, {    23, 0x24be }, {    24, 0x10a3 }, {    23, 0x24be }, {    25, 0x10a3 }, {    21, 0x24be },
+    {    30, 0x10a3 }, {    21, 0x24be }, {    23, 0x10a3 }, {    21, 0x24be }, {    32, 0x10a3 }, {    21, 0x24be },
+    {    21, 0x10a3 }, {    20, 0x24be }, {    36, 0x10a3 }, {    20, 0x24be }, {    20, 0x10a3 }, {    19, 0x24be },
+    {    38, 0x10a3 }, {    19, 0x24be }, {    19, 0x10a3 }, {    18, 0x24be }, {    42, 0x10a3 }, {    18, 0x24be },
+    {    17, 0x10a3 }, {    18, 0x24be }, {    44, 0x10a3 }, {    18, 0x24be }, {    16, 0x10a3 }, {    17, 0x24be },
+    {    46, 0x10a3 }, {    17, 0x24be }, {    15, 0x10a3 }, {    17, 0x24be }, {    48, 0x10a3 }, {    17, 0x24be },
+    {    14, 0x10a3 }, {    16, 0x24be }, {    50, 0x10a3 }, {    16, 0x24be }, {    13, 0x10a3 }, {    17, 0x24be },
+    {    50, 0x10a3 }, {    17, 0x24be }, {    12, 0x10a3 }, {    16, 0x24be }, {    52, 0x10a3 }, {    16, 0x24be },
+    {    11, 0x10a3 }, {    16, 0x24be }, {    54, 0x10a3 }, {    16, 0x24be }, {    10, 0x10a3 }, {    16, 0x24be },
+    {    54, 0x10a3 }, {    16, 0x24be }, {    10, 0x10a3 }, {    15, 0x24be }, {    56, 0x10a3 }, {    15, 0x24be },
+    {     9, 0x10a3 }, {    15, 0x24be }, {    58, 0x10a3 }, {    15, 0x24be }, {     8, 0x10a3 }, {    15, 0x24be },
+    {    25, 0x10a3 }, {     8, 0xffff }, {    25, 0x10a3 }, {    15, 0x24be }, {     8, 0x10a3 }, {    15, 0x24be },
+    {    23, 0x10a3 }, {    12, 0xffff }, {    23, 0x10a3 }, {    15, 0x24be }, {     7, 0x10a3 }, {    15, 0x24be },
+    {    22, 0x10a3 }, {    16, 0xffff }, {    22, 0x10a3 }, {    15, 0x24be }, {     6, 0x10a3 }, {    15, 0x24be },
+    {    21, 0x10a3 }, {    18, 0xffff }, {    21, 0x10a3 }, {    15, 0x24be }, {     6, 0x10a3 }, {    14, 0x24be },
+    {    21, 0x10a3 }, {    20, 0xffff }, {    21, 0x10a3 }, {    14, 0x24be }, {     6, 0x10a3 }, {    14, 0x24be },
+    {    20, 0x10a3 }, {    22, 0xffff }, {    20, 0x10a3 }, {    14, 0x24be }, {     6, 0x10a3 }, {    14, 0x24be },
+    {    19, 0x10a3 }, {    24, 0xffff }, {    19, 0x10a3 }, {    14, 0x24be }, {     5, 0x10a3 }, {    15, 0x24be },
+    {    19, 0x10a3 }, {    24, 0xffff }, {    19, 0x10a3 }, {    15, 0x24be }, {     4, 0x10a3 }, {    14, 0x24be },
+    {    19, 0x10a3 }, {    26, 0xffff }, {    19, 0x10a3 }, {    14, 0x24be }, {     4, 0x10a3 }, {    14, 0x24be },
+    {    19, 0x10a3 }, {    26, 0xffff }, {    19, 0x10a3 }, {    14, 0x24be }, {     4, 0x10a3 }, {    14, 0x24be },
+    {    18, 0x10a3 }, {    28, 0xffff }, {    18, 0x10a3 }, {    14, 0x24be }, {     4, 0x10a3 }, {    14, 0x24be },
+    {    18, 0x10a3 }, {    28, 0xffff }, {    18, 0x10a3 }, {    14, 0x24be }, {     4, 0x10a3 }, {    14, 0x24be },
+    {    18, 0x10a3 }, {    28, 0xffff }, {    18, 0x10a3 }, {    14, 0x24be }, {     4, 0x10a3 }, {    14, 0x24be },
+    {    18, 0x10a3 }, {    28, 0xffff }, {    18, 0x10a3 }, {    14, 0x24be }, {     4, 0x10a3 }, {    14, 0x24be },
+    {    18, 0x10a3 }, {    28, 0xffff }, {    18, 0x10a3 }, {    14, 0x24be }, {     4, 0x10a3 }, {    14, 0x24be },
+    {    18, 0x10a3 }, {    28, 0xffff }, {    18, 0x10a3 }, {    14, 0x24be }, {     4, 0x10a3 }, {    14, 0x24be },
+    {    18, 0x10a3 }, {    28, 0xffff }, {    18, 0x10a3 }, {    14, 0x24be }, {     4, 0x10a3 }, {    14, 0x24be },
+    {    18, 0x10a3 }, {    28, 0xffff }, {    18, 0x10a3 }, {    14, 0x24be }, {     4, 0x10a3 }, {    14, 0x24be },
+    {    19, 0x10a3 }, {    26, 0xffff }, {    19, 0x10a3 }, {    14, 0x24be }, {     4, 0x10a3 }, {    14, 0x24be },
+    {    19, 0x10a3 }, {    26, 0xffff }, {    19, 0x10a3 }, {    14, 0x24be }, {     4, 0x10a3 }, {    15, 0x24be },
+    {    19, 0x10a3 }, {    24, 0xffff }, {    19, 0x10a3 }, {    15, 0x24be }, {     5, 0x10a3 }, {    14, 0x24be },
+    {    19, 0x10a3 }, {    24, 0xffff }, {    19, 0x10a3 }, {    14, 0x24be }, {     6, 0x10a3 }, {    14, 0x24be },
+    {    20, 0x10a3 }, {    22, 0xffff }, {    20, 0x10a3 }, {    14, 0x24be }, {     6, 0x10a3 }, {    14, 0x24be },
+    {    21, 0x10a3 }, {    20, 0xffff }, {    21, 0x10a3 }, {    14, 0x24be }, {     6, 0x10a3 }, {    15, 0x24be },
+    {    21, 0x10a3 }, {    18, 0xffff }, {    21, 0x10a3 }, {    15, 0x24be }, {     6, 0x10a3 }, {    15, 0x24be },
+    {    22, 0x10a3 }, {    16, 0xffff }, {    22, 0x10a3 }, {    15, 0x24be }, {     7, 0x10a3 }, {    15, 0x24be },
+    {    23, 0x10a3 }, {    12, 0xffff }, {    23, 0x10a3 }, {    15, 0x24be }, {     8, 0x10a3 }, {    15, 0x24be },
+    {    25, 0x10a3 }, {     8, 0xffff }, {    25, 0x10a3 }, {    15, 0x24be }, {     8, 0x10a3 }, {    15, 0x24be },
+    {    58, 0x10a3 }, {    15, 0x24be }, {     9, 0x10a3 }, {    15, 0x24be }, {    56, 0x10a3 }, {    15, 0x24be },
+    {    10, 0x10a3 }, {    16, 0x24be }, {    54, 0x10a3 }, {    16, 0x24be }, {    10, 0x10a3 }, {    16, 0x24be },
+    {    54, 0x10a3 }, {    16, 0x24be }, {    11, 0x10a3 }, {    16, 0x24be }, {    52, 0x10a3 }, {    16, 0x24be },
+    {    12, 0x10a3 }, {    17, 0x24be }, {    50, 0x10a3 }, {    17, 0x24be }, {    13, 0x10a3 }, {    16, 0x24be },
+    {    50, 0x10a3 }, {    16, 0x24be }, {    14, 0x10a3 }, {    17, 0x24be }, {    48, 0x10a3 }, {    17, 0x24be },
+    {    15, 0x10a3 }, {    17, 0x24be }, {    46, 0x10a3 }, {    17, 0x24be }, {    16, 0x10a3 }, {    18, 0x24be },
+    {    44, 0x10a3 }, {    18, 0x24be }, {    17, 0x10a3 }, {    18, 0x24be }, {    42, 0x10a3 }, {    18, 0x24be },
+    {    19, 0x10a3 }, {    19, 0x24be }, {    38, 0x10a3 }, {    19, 0x24be }, {    20, 0x10a3 }, {    20, 0x24be },
+    {    36, 0x10a3 }, {    20, 0x24be }, {    21, 0x10a3 }, {    21, 0x24be }, {    32, 0x10a3 }, {    21, 0x24be },
+    {    23, 0x10a3 }, {    21, 0x24be }, {    30, 0x10a3 }, {    21, 0x24be }, {    25, 0x10a3 }, {    23, 0x24be },
+    {    24, 0x10a3 }, {    23, 0x24be }, {    27, 0x10a3 }, {    24, 0x24be }, {    20, 0x10a3 }, {    24, 0x24be },
+    {    28, 0x10a3 }, {    28, 0x24be }, {    12, 0x10a3 }, {    28, 0x24be }, {    29, 0x10a3 }, {    66, 0x24be },
+    {    31, 0x10a3 }, {    64, 0x24be }, {    34, 0x10a3 }, {    60, 0x24be }, {    37, 0x10a3 }, {    58, 0x24be },
+    {    39, 0x10a3 }, {    56, 0x24be }, {    41, 0x10a3 }, {    54, 0x24be }, {    44, 0x10a3 }, {    50, 0x24be },
+    {    47, 0x10a3 }, {    48, 0x24be }, {    50, 0x10a3 }, {    44, 0x24be }, {    54, 0x10a3 }, {    40, 0x24be },
+    {    58, 0x10a3 }, {    36, 0x24be }, {    63, 0x10a3 }, {    30, 0x24be }, {    69, 0x10a3 }, {    24, 0x24be },
+    {    77, 0x10a3 }, {    14, 0x24be }, {   233, 0x10a3 },
+};
+
+const struct splash_img splash_img = {
+    .w       = 96,
+    .h       = 96,
+    .bg      = 0x10a3,
+    .nr_runs = 369,
+    .runs    = splash_runs,
+};
@@ -0,0 +1,231 @@
+// Copyright (c) 2024 embeddedboys developers
+
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+/*
+ * Per-core and per-task CPU usage, context switch counts and stack
+ * high-water marks.
+ *
+ * The FreeRTOS run time counter is the 1MHz RP2040 timer (time_us_64()),
+ * so no extra timer is spent on it. The switch hooks only read the timer
+ * and bump a few counters; each core touches its own slot only. Figures
+ * printed by task_stats_dump() cover the window since the previous dump.
+ */
+
+#define pr_fmt(fmt) "stats: " fmt
+
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "pico/platform.h"
+#include "hardware/timer.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "task_stats.h"
+#include "console.h"
+#include "debug.h"
+
+#if configCHECK_FOR_STACK_OVERFLOW
+void vApplicationStackOverflowHook(TaskHandle_t xTask, char *pcTaskName)
+{
+    panic("stack overflow in task %s\n", pcTaskName);
+}
+#endif
+
+#if TASK_STATS_ENABLED
+
+struct core_stats {
+    uint64_t switched_in_at;
+    uint64_t busy_us;       /* time spent outside the idle tasks */
+    uint32_t switches;
+    bool     in_idle;
+};
+
+static struct core_stats g_core[configNUMBER_OF_CORES];
+static TaskHandle_t g_idle[configNUMBER_OF_CORES];
+
+static inline bool task_is_idle(TaskHandle_t task)
+{
+    for (int i = 0; i < configNUMBER_OF_CORES; i++) {
+        if (task == g_idle[i])
+            return true;
+    }
+    return false;
+}
+
+void __time_critical_func(task_stats_switched_out)(void)
+{
+    struct core_stats *c = &g_core[get_core_num()];
+
+    if (!c->in_idle && c->switched_in_at)
+        c->busy_us += time_us_64() - c->switched_in_at;
+}
+
+void __time_critical_func(task_stats_switched_in)(void)
+{
+    struct core_stats *c = &g_core[get_core_num()];
+    uintptr_t n;
+
+    /* idle tasks exist before the first switch, fetch them once */
+    if (!g_idle[0]) {
+        for (int i = 0; i < configNUMBER_OF_CORES; i++)
+            g_idle[i] = xTaskGetIdleTaskHandleForCore(i);
+    }
+
+    c->switched_in_at = time_us_64();
+    c->switches++;
+    c->in_idle = task_is_idle(xTaskGetCurrentTaskHandle());
+
+    n = (uintptr_t)pvTaskGetThreadLocalStoragePointer(NULL, TASK_STATS_TLS_INDEX);
+    vTaskSetThreadLocalStoragePointer(NULL, TASK_STATS_TLS_INDEX, (void *)(n + 1));
+}
+
+/* previous sample, only touched by the caller of task_stats_dump() */
+static struct {
+    uint64_t time;
+    uint64_t busy_us[configNUMBER_OF_CORES];
+    uint32_t switches[configNUMBER_OF_CORES];
+
+    struct {
+        TaskHandle_t handle;
+        configRUN_TIME_COUNTER_TYPE run_time;
+        uint32_t switches;
+    } task[TASK_STATS_MAX_TASKS];
+    int nr_tasks;
+} g_prev;
+
+static char task_state_char(eTaskState state)
+{
+    switch (state) {
+    case eRunning:   return 'X';
+    case eReady:     return 'R';
+    case eBlocked:   return 'B';
+    case eSuspended: return 'S';
+    case eDeleted:   return 'D';
+    default:         return '?';
+    }
+}
+
+/* permille of part over whole, 0 when the window is empty */
+static uint32_t permille(uint64_t part, uint64_t whole)
+{
+    return whole ? (uint32_t)(part * 1000 / whole) : 0;
+}
+
+void task_stats_dump(void)
+{
+    static TaskStatus_t status[TASK_STATS_MAX_TASKS];
+    configRUN_TIME_COUNTER_TYPE total;
+    UBaseType_t nr;
+    uint64_t now, window;
+
+    nr = uxTaskGetSystemState(status, TASK_STATS_MAX_TASKS, &total);
+    if (!nr) {
+        pr_warn("more than %d tasks, raise TASK_STATS_MAX_TASKS\n", TASK_STATS_MAX_TASKS);
+        return;
+    }
+
+    now = time_us_64();
+    window = now - g_prev.time;
+
+    printf("uptime %llu ms, window %llu ms\n", now / 1000, window / 1000);
+
+    printf("core  busy%%   switches\n");
+    for (int i = 0; i < configNUMBER_OF_CORES; i++) {
+        uint64_t busy = g_core[i].busy_us;
+        uint32_t switches = g_core[i].switches;
+        uint32_t pm = permille(busy - g_prev.busy_us[i], window);
+
+        printf("%-4d  %3lu.%lu  %8lu\n", i, pm / 10, pm % 10,
+               switches - g_prev.switches[i]);
+
+        g_prev.busy_us[i] = busy;
+        g_prev.switches[i] = switches;
+    }
+
+    printf("%-16s st pri aff   cpu%%   switches  stack free\n", "task");
+    for (UBaseType_t i = 0; i < nr; i++) {
+        TaskStatus_t *t = &status[i];
+        uint32_t switches = (uintptr_t)pvTaskGetThreadLocalStoragePointer(t->xHandle,
+                                                                           TASK_STATS_TLS_INDEX);
+        configRUN_TIME_COUNTER_TYPE prev_rt = 0;
+        uint32_t prev_sw = 0;
+        uint32_t pm;
+
+        for (int j = 0; j < g_prev.nr_tasks; j++) {
+            if (g_prev.task[j].handle == t->xHandle) {
+                prev_rt = g_prev.task[j].run_time;
+                prev_sw = g_prev.task[j].switches;
+                break;
+            }
+        }
+
+        /* percentage of one core */
+        pm = permille(t->ulRunTimeCounter - prev_rt, window);
+
+        printf("%-16s %c  %3lu %3lx  %3lu.%lu  %8lu  %5lu words%s\n",
+               t->pcTaskName, task_state_char(t->eCurrentState),
+               (uint32_t)t->uxCurrentPriority, (uint32_t)t->uxCoreAffinityMask,
+               pm / 10, pm % 10, switches - prev_sw,
+               (uint32_t)t->usStackHighWaterMark,
+               t->usStackHighWaterMark < 32 ? "  LOW" : "");
+    }
+
+    for (UBaseType_t i = 0; i < nr; i++) {
+        g_prev.task[i].handle = status[i].xHandle;
+        g_prev.task[i].run_time = status[i].ulRunTimeCounter;
+        g_prev.task[i].switches = (uintptr_t)pvTaskGetThreadLocalStoragePointer(status[i].xHandle,
+                                                                               TASK_STATS_TLS_INDEX);
+    }
+    g_prev.nr_tasks = nr;
+    g_prev.time = now;
+}
+
+static int task_stats_cmd(int argc, char **argv)
+{
+    task_stats_dump();
+    return 0;
+}
+
+static const struct console_cmd top_cmd = {
+    .name = "top",
+    .help = "per-core/per-task cpu usage, switches and stack headroom",
+    .fn = task_stats_cmd,
+};
+
+void task_stats_init(void)
+{
+    console_register(&top_cmd);
+}
+
+#else
+
+void task_stats_init(void)
+{
+}
+
+void task_stats_dump(void)
+{
+    printf("task stats disabled, set TASK_STATS_ENABLED\n");
+}
+
+#endif /* TASK_STATS_ENABLED */
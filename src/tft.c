@@ -33,11 +33,17 @@
 #include "hardware/gpio.h"
 
 #include "tft.h"
+#include "trace.h"
+#include "cabc.h"
+#include "settings.h"
+#include "boot_time.h"
 #include "debug.h"
 
 #define DRV_NAME "tft"
 
 static struct tft_priv g_priv;
+static struct tft_ops g_tftops;
+static u8 g_reg_buf[TFT_REG_BUF_SIZE];
 
 static TaskHandle_t xTaskToNotify = NULL;
 static const UBaseType_t XArrayIndex = 1;
@@ -218,6 +224,9 @@ static int tft_gpio_init(struct tft_priv *priv)
 
 static int tft_hw_init(struct tft_priv *priv)
 {
+#if DISP_OVER_PIO
+    u32 khz;
+#endif
     int ret;
 
     pr_debug("%s\n", __func__);
@@ -226,10 +235,10 @@ static int tft_hw_init(struct tft_priv *priv)
 
 #if DISP_OVER_PIO
     i80_pio_init(priv->gpio.db[0], ARRAY_SIZE(priv->gpio.db), priv->gpio.wr);
+    if (settings_get(SETTINGS_KEY_BUS_CLK_KHZ, &khz, sizeof(khz)) == sizeof(khz))
+        i80_set_clk_khz(khz);
 #endif
 
-    tft_gpio_init(priv);
-
     if (!priv->tftops->init_display) {
         pr_error("init_display must be provided\n");
         return -1;
@@ -237,6 +246,7 @@ static int tft_hw_init(struct tft_priv *priv)
     
     pr_debug("initializing display...\n");
     priv->tftops->init_display(priv);
+    boot_mark("panel init");
 
     /* clear screen to black */
     // pr_debug("clearing screen...\n");
@@ -252,22 +262,128 @@ void tft_video_flush(int xs, int ys, int xe, int ye, void *vmem, uint32_t len)
 {
     xTaskToNotify = xTaskGetCurrentTaskHandle();
 
+    /* before video_sync, some drivers byte swap the buffer in place */
+    cabc_account(xs, ys, xe, ye, vmem);
+
+    trace_span_begin(TRACE_SPAN_VIDEO_FLUSH);
     g_priv.tftops->video_sync(&g_priv, xs, ys, xe, ye, vmem, len);
+    trace_span_end(TRACE_SPAN_VIDEO_FLUSH);
 
     xTaskNotifyGiveIndexed(xTaskToNotify, XArrayIndex);
 
     xTaskToNotify = NULL;
 }
 
+void tft_set_window(int xs, int ys, int xe, int ye)
+{
+    g_priv.tftops->set_addr_win(&g_priv, xs, ys, xe, ye);
+}
+
+/* px is in frame order, i.e. what LVGL puts in a draw buffer */
+void tft_fill(u16 px, size_t count)
+{
+#if DISP_OVER_PIO
+    i80_fill_rs(&px, count, 1);
+#else
+    while (count--)
+        fbtft_write_gpio16_wr_rs(&g_priv, &px, sizeof(px), 1);
+#endif
+}
+
+/* MIPI DCS, sleep out must be followed by 120 ms before the next sleep in */
+#define TFT_SLEEP_GUARD_MS  120
+#define TFT_SLEEP_IN_MS     5
+
+static u32 tft_wake_ms(struct tft_priv *priv)
+{
+    return priv->display->wake_ms ? priv->display->wake_ms : 120;
+}
+
+/* runs in the flush task, the delays let other tasks run */
+static int tft_sleep(struct tft_priv *priv, bool on)
+{
+    static TickType_t woke;
+    TickType_t since = xTaskGetTickCount() - woke;
+
+    if (on) {
+        if (since < pdMS_TO_TICKS(TFT_SLEEP_GUARD_MS))
+            vTaskDelay(pdMS_TO_TICKS(TFT_SLEEP_GUARD_MS) - since);
+        write_reg(priv, 0x28);
+        write_reg(priv, 0x10);
+        vTaskDelay(pdMS_TO_TICKS(TFT_SLEEP_IN_MS));
+        return 0;
+    }
+
+    write_reg(priv, 0x11);
+    vTaskDelay(pdMS_TO_TICKS(tft_wake_ms(priv)));
+    write_reg(priv, 0x29);
+    woke = xTaskGetTickCount();
+    return 0;
+}
+
+int tft_set_sleep(bool on)
+{
+    return g_priv.tftops->sleep(&g_priv, on);
+}
+
+u32 tft_get_wake_ms(void)
+{
+    return tft_wake_ms(&g_priv);
+}
+
+void tft_set_display(bool on)
+{
+    struct tft_priv *priv = &g_priv;
+
+    write_reg(priv, on ? 0x29 : 0x28);
+}
+
+void tft_set_idle(bool on)
+{
+    struct tft_priv *priv = &g_priv;
+
+    write_reg(priv, on ? 0x39 : 0x38);
+}
+
+void tft_set_partial(int ys, int ye)
+{
+    struct tft_priv *priv = &g_priv;
+
+    if (ys > ye) {
+        write_reg(priv, 0x13);
+        return;
+    }
+
+    write_reg(priv, 0x30, ys >> 8, ys & 0xFF, ye >> 8, ye & 0xFF);
+    write_reg(priv, 0x12);
+}
+
+int tft_set_cabc(u8 mode)
+{
+    if (!g_priv.tftops->set_cabc)
+        return -1;
+
+    return g_priv.tftops->set_cabc(&g_priv, mode);
+}
+
 portTASK_FUNCTION(video_flush_task, pvParameters)
 {
     const TickType_t xMaxBlockTime = pdMS_TO_TICKS( 100 );
     uint32_t ulNotificationValue;
     struct video_frame vf;
 
+    /* the panel init delays overlap with the UI being built on core 0 */
+    bringup_run(BRINGUP_PANEL);
+    bringup_run(BRINGUP_BACKLIGHT);
+
     for (;;) {
         /* if lvgl request to draw */
         if (xQueueReceive(xToFlushQueue, &vf, portMAX_DELAY)) {
+            if (vf.fn) {
+                vf.fn(vf.vmem);
+                continue;
+            }
+
             pr_debug("Received video frame to flush\n");
             tft_video_flush(vf.xs, vf.ys, vf.xe, vf.ye, vf.vmem, vf.len);
 
@@ -291,6 +407,16 @@ void tft_async_video_flush(struct video_frame *vf)
     xQueueSend(xToFlushQueue, (void *)vf, portMAX_DELAY);
 }
 
+void tft_async_call(void (*fn)(void *arg), void *arg)
+{
+    struct video_frame vf = {
+        .vmem = arg,
+        .fn = fn,
+    };
+
+    xQueueSend(xToFlushQueue, (void *)&vf, portMAX_DELAY);
+}
+
 /* -------------------------------------------------------------------------- */
 
 void tft_merge_tftops(struct tft_ops *dst, struct tft_ops *src)
@@ -310,26 +436,19 @@ void tft_merge_tftops(struct tft_ops *dst, struct tft_ops *src)
         dst->set_addr_win = src->set_addr_win;
     if (src->video_sync)
         dst->video_sync = src->video_sync;
+    if (src->set_cabc)
+        dst->set_cabc = src->set_cabc;
 }
 
-int tft_probe(struct tft_display *display)
+/*
+ * Called from main() before the scheduler, the panel itself is brought up
+ * later in the flush task. LCD_PIN_RD doubles as the touch INT on this
+ * board: the touch driver turns it into an input and has to come after
+ * this, whichever bring-up task gets to run first.
+ */
+int tft_gpio_setup(void)
 {
     struct tft_priv *priv = &g_priv;
-    pr_debug("%s\n", __func__);
-
-    priv->buf = (u8 *)malloc(TFT_REG_BUF_SIZE);
-    if (!priv->buf) {
-        pr_debug("failed to allocate buffer\n");
-        return -1;
-    }
-
-    priv->tftops = (struct tft_ops *)malloc(sizeof(struct tft_ops));
-    if (!priv->tftops) {
-        pr_debug("failed to allocate tftops\n");
-        return -1;
-    }
-
-    priv->display = display;
 
     priv->gpio.bl    = LCD_PIN_BL;
     priv->gpio.reset = LCD_PIN_RST;
@@ -342,9 +461,24 @@ int tft_probe(struct tft_display *display)
     for (int i = LCD_PIN_DB_BASE; i < ARRAY_SIZE(priv->gpio.db); i++)
         priv->gpio.db[i] = i;
 
+    return tft_gpio_init(priv);
+}
+
+int tft_probe(struct tft_display *display)
+{
+    struct tft_priv *priv = &g_priv;
+    pr_debug("%s\n", __func__);
+
+    /* there is only one panel, keep its state out of the heap */
+    priv->buf = g_reg_buf;
+    priv->tftops = &g_tftops;
+
+    priv->display = display;
+
     priv->tftops->reset = tft_reset;
     priv->tftops->set_addr_win = tft_set_addr_win;
     priv->tftops->clear = tft_clear;
+    priv->tftops->sleep = tft_sleep;
     priv->tftops->video_sync = tft_video_sync;
 
     tft_merge_tftops(priv->tftops, &display->tftops);
@@ -352,8 +486,4 @@ int tft_probe(struct tft_display *display)
     tft_hw_init(priv);
 
     return 0;
-
-exit_free_priv_buf:
-    free(priv->buf);
-    return -1;
 }
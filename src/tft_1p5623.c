@@ -113,6 +113,7 @@ static struct tft_display tft_1p5623 = {
     .yres   = TFT_Y_RES,
     .bpp    = 16,
     .backlight = 100,
+    .wake_ms   = 20,
     .tftops = {
 #if LCD_PIN_DB_COUNT == 8
         .write_reg = tft_write_reg8,
@@ -97,11 +97,20 @@ static void tft_video_sync(struct tft_priv *priv, int xs, int ys, int xe, int ye
 }
 #endif
 
+/* BCTRL and DD on, the CABC block also lifts the image while dimmed */
+static int tft_ili9488_set_cabc(struct tft_priv *priv, u8 mode)
+{
+    write_reg(priv, 0x53, mode != TFT_CABC_OFF ? 0x2C : 0x00);
+    write_reg(priv, 0x55, mode & 0x03);
+    return 0;
+}
+
 static struct tft_display ili9488 = {
     .xres   = TFT_X_RES,
     .yres   = TFT_Y_RES,
     .bpp    = 16,
     .backlight = 100,
+    .wake_ms   = 60,
     .tftops = {
 #if LCD_PIN_DB_COUNT == 8
         .write_reg = tft_write_reg8,
@@ -110,6 +119,7 @@ static struct tft_display ili9488 = {
         .write_reg = tft_write_reg16,
 #endif
         .init_display = tft_ili9488_init_display,
+        .set_cabc = tft_ili9488_set_cabc,
     },
 };
 
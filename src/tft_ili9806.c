@@ -133,6 +133,7 @@ static struct tft_display ili9806 = {
     .yres   = TFT_Y_RES,
     .bpp    = 16,
     .backlight = 100,
+    .wake_ms   = 120,
     .tftops = {
 #if LCD_PIN_DB_COUNT == 8
         .write_reg = tft_write_reg8,
@@ -176,6 +176,7 @@ static struct tft_display r61581 = {
     .yres   = TFT_Y_RES,
     .bpp    = 16,
     .backlight = 100,
+    .wake_ms   = 10,
     .tftops = {
         .write_reg = tft_write_reg8,
         .init_display = tft_r61581_init_display,
@@ -71,14 +71,24 @@ static int tft_st7789_init_display(struct tft_priv *priv)
     return 0;
 }
 
+/* BCTRL and DD on, the CABC block also lifts the image while dimmed */
+static int tft_st7789_set_cabc(struct tft_priv *priv, u8 mode)
+{
+    write_reg(priv, 0x53, mode != TFT_CABC_OFF ? 0x2C : 0x00);
+    write_reg(priv, 0x55, mode & 0x03);
+    return 0;
+}
+
 static struct tft_display st7789 = {
     .xres = TFT_X_RES,
     .yres = TFT_Y_RES,
     .bpp  = 16,
     .backlight = 100,
+    .wake_ms   = 120,
     .tftops = {
         .write_reg    = tft_write_reg8,
         .init_display = tft_st7789_init_display,
+        .set_cabc     = tft_st7789_set_cabc,
     },
 };
 
@@ -0,0 +1,206 @@
+// Copyright (c) 2024 embeddedboys developers
+
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+/*
+ * Binary event trace.
+ *
+ * Each core appends fixed size events to its own ring, so writers never
+ * contend with the other core; masking interrupts around the slot claim
+ * is enough to keep ISRs on the same core from tearing an entry. The ring
+ * overwrites its oldest entries, so a dump always shows the last
+ * TRACE_RING_SIZE events per core.
+ *
+ * "trace dump" on the console prints the rings as text, which
+ * scripts/trace2perfetto.py turns into a Chrome/Perfetto JSON trace.
+ */
+
+#define pr_fmt(fmt) "trace: " fmt
+
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "pico/platform.h"
+#include "hardware/sync.h"
+#include "hardware/timer.h"
+#include "hardware/structs/timer.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "trace.h"
+#include "console.h"
+#include "debug.h"
+
+#if TRACE_ENABLED
+
+#if (TRACE_RING_SIZE & (TRACE_RING_SIZE - 1))
+#error "TRACE_RING_SIZE must be a power of two"
+#endif
+
+struct trace_ring {
+    struct trace_event ev[TRACE_RING_SIZE];
+    uint32_t head;  /* total events written, never wraps in practice */
+};
+
+static struct trace_ring g_ring[NUM_CORES];
+static volatile bool g_trace_on;
+
+void * volatile g_trace_queues[TRACE_MAX_QUEUES];
+static const char *g_trace_queue_names[TRACE_MAX_QUEUES];
+
+static const char *const trace_span_names[TRACE_SPAN_NR] = {
+    [TRACE_SPAN_LV_TIMER]    = "lv_timer_handler",
+    [TRACE_SPAN_DISP_FLUSH]  = "disp_flush",
+    [TRACE_SPAN_VIDEO_FLUSH] = "tft_video_flush",
+    [TRACE_SPAN_TOUCH_READ]  = "touch_read",
+};
+
+void __time_critical_func(trace_event)(uint8_t type, uint8_t id, uint16_t arg, uint32_t data)
+{
+    struct trace_ring *r;
+    struct trace_event *e;
+    uint32_t irq;
+
+    if (!g_trace_on)
+        return;
+
+    r = &g_ring[get_core_num()];
+
+    irq = save_and_disable_interrupts();
+    e = &r->ev[r->head++ & (TRACE_RING_SIZE - 1)];
+    e->ts = timer_hw->timerawl;
+    e->type = type;
+    e->id = id;
+    e->arg = arg;
+    e->data = data;
+    restore_interrupts(irq);
+}
+
+void __time_critical_func(trace_task_switched_in)(void)
+{
+    trace_event(TRACE_EV_TASK_IN, 0, 0, (uint32_t)xTaskGetCurrentTaskHandle());
+}
+
+void trace_queue_watch(void *queue, const char *name)
+{
+    for (int i = 0; i < TRACE_MAX_QUEUES; i++) {
+        if (!g_trace_queues[i]) {
+            g_trace_queue_names[i] = name;
+            g_trace_queues[i] = queue;
+            return;
+        }
+    }
+
+    pr_warn("no free slot to watch queue %s\n", name);
+}
+
+void trace_start(void)
+{
+    g_trace_on = false;
+    busy_wait_us(10);   /* let a writer on the other core finish */
+
+    for (int i = 0; i < NUM_CORES; i++)
+        g_ring[i].head = 0;
+
+    g_trace_on = true;
+}
+
+void trace_stop(void)
+{
+    g_trace_on = false;
+}
+
+static void trace_dump_tasks(void)
+{
+    static TaskStatus_t status[16];
+    UBaseType_t nr;
+
+    nr = uxTaskGetSystemState(status, sizeof(status) / sizeof(status[0]), NULL);
+    for (UBaseType_t i = 0; i < nr; i++)
+        printf("T %08lx %s\n", (uint32_t)status[i].xHandle, status[i].pcTaskName);
+}
+
+void trace_dump(void)
+{
+    bool was_on = g_trace_on;
+
+    g_trace_on = false;
+    busy_wait_us(10);
+
+    printf("# trace begin cores=%d events=%d\n", NUM_CORES, TRACE_RING_SIZE);
+
+    for (int i = 0; i < TRACE_SPAN_NR; i++)
+        printf("S %d %s\n", i, trace_span_names[i]);
+
+    for (int i = 0; i < TRACE_MAX_QUEUES; i++) {
+        if (g_trace_queues[i])
+            printf("Q %08lx %s\n", (uint32_t)g_trace_queues[i], g_trace_queue_names[i]);
+    }
+
+    trace_dump_tasks();
+
+    for (int core = 0; core < NUM_CORES; core++) {
+        struct trace_ring *r = &g_ring[core];
+        uint32_t start = r->head > TRACE_RING_SIZE ? r->head - TRACE_RING_SIZE : 0;
+
+        for (uint32_t n = start; n < r->head; n++) {
+            struct trace_event *e = &r->ev[n & (TRACE_RING_SIZE - 1)];
+
+            printf("E %d %lu %u %u %u %08lx\n", core, e->ts,
+                   e->type, e->id, e->arg, e->data);
+        }
+    }
+
+    printf("# trace end\n");
+
+    g_trace_on = was_on;
+}
+
+static int trace_cmd(int argc, char **argv)
+{
+    if (argc < 2 || !strcmp(argv[1], "dump")) {
+        trace_dump();
+    } else if (!strcmp(argv[1], "start")) {
+        trace_start();
+    } else if (!strcmp(argv[1], "stop")) {
+        trace_stop();
+    } else {
+        printf("usage: trace [start|stop|dump]\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+static const struct console_cmd trace_console_cmd = {
+    .name = "trace",
+    .help = "trace [start|stop|dump], dump feeds scripts/trace2perfetto.py",
+    .fn = trace_cmd,
+};
+
+void trace_init(void)
+{
+    console_register(&trace_console_cmd);
+    trace_start();
+}
+
+#endif /* TRACE_ENABLED */
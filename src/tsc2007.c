@@ -29,6 +29,7 @@
 #include "hardware/i2c.h"
 
 #include "indev.h"
+#include "i2c_bus.h"
 #include "debug.h"
 
 #if INDEV_DRV_USE_TSC2007
@@ -42,6 +43,8 @@
 
 #define TSC2007_CMD_READ_X 0xC0
 #define TSC2007_CMD_READ_Y 0xD0
+#define TSC2007_CMD_READ_Z1 0xE0
+#define TSC2007_CMD_READ_Z2 0xF0
 
 #define TSC2007_DISABLE_IRQ (1 << 2)
 
@@ -55,12 +58,10 @@ enum {
     TSC2007_POWER_MODE_LOW_POWER,
 };
 
-extern int i2c_bus_scan(i2c_inst_t *i2c);
-
 static void tsc2007_write_reg(struct indev_priv *priv, uint8_t reg, uint8_t val)
 {
     uint16_t buf = val << 8 | reg;
-    i2c_write_blocking(priv->spec->i2c.master, priv->spec->i2c.addr, (uint8_t *)&buf, sizeof(buf), false);
+    i2c_bus_write(priv->spec->i2c.master, priv->spec->i2c.addr, (uint8_t *)&buf, sizeof(buf));
 }
 
 // static uint16_t tsc2007_read_reg(struct indev_priv *priv, uint8_t reg)
@@ -84,45 +85,35 @@ static void tsc2007_write_reg(struct indev_priv *priv, uint8_t reg, uint8_t val)
 static uint8_t tsc2007_read_reg(struct indev_priv *priv, uint8_t reg)
 {
     uint8_t val;
-    i2c_write_blocking(priv->spec->i2c.master, priv->spec->i2c.addr, &reg, 1, true);
-    i2c_read_blocking(priv->spec->i2c.master, priv->spec->i2c.addr, &val, 1, false);
+    i2c_bus_write_read(priv->spec->i2c.master, priv->spec->i2c.addr, &reg, 1, &val, 1);
     return val;
 }
 
-uint16_t tsc2007_read_x(struct indev_priv *priv)
+/* 12-bit conversion, M = 0 in the command byte, result left aligned in 2 bytes */
+static u16 tsc2007_read_adc(struct indev_priv *priv, u8 channel)
 {
-    uint8_t val = read_reg(priv, TSC2007_CMD_READ_X);
-    u16 this_x = 0;
-
-    if (priv->invert_x)
-        this_x = (priv->x_res - (val * priv->x_res) / (1 << priv->spec->resolution));
-    else
-        this_x = (val * priv->x_res) / (1 << priv->spec->resolution);
-
-    pr_debug("x : %d, sc_x : %f\n", this_x, priv->sc_x);
-    this_x += priv->spec->x_offs;
-    this_x *= priv->sc_x;
-    pr_debug("x : %d, sc_x : %f\n", this_x, priv->sc_x);
-
-    return this_x;
+    static const u8 cmds[] = {
+        [INDEV_ADC_X]  = TSC2007_CMD_READ_X,
+        [INDEV_ADC_Y]  = TSC2007_CMD_READ_Y,
+        [INDEV_ADC_Z1] = TSC2007_CMD_READ_Z1,
+        [INDEV_ADC_Z2] = TSC2007_CMD_READ_Z2,
+    };
+    u8 data[2];
+
+    if (i2c_bus_write_read(priv->spec->i2c.master, priv->spec->i2c.addr,
+                           &cmds[channel], 1, data, 2) < 0)
+        return 0;
+
+    return (data[0] << 4) | (data[1] >> 4);
 }
 
-uint16_t tsc2007_read_y(struct indev_priv *priv)
+/* no ID register, a Z1 conversion that ACKs is all there is to check */
+static bool tsc2007_detect(struct indev_spec *spec, u8 addr)
 {
-    uint8_t val = read_reg(priv, TSC2007_CMD_READ_Y);
-    u16 this_y = 0;
-
-    if (priv->invert_y)
-        this_y = (priv->y_res - (val * priv->y_res) / (1 << priv->spec->resolution));
-    else
-        this_y = (val * priv->y_res) / (1 << priv->spec->resolution);
-
-    pr_debug("y : %d, sc_y : %f\n", this_y, priv->sc_y);
-    this_y += priv->spec->y_offs;
-    this_y *= priv->sc_y;
-    pr_debug("y : %d, sc_y : %f\n", this_y, priv->sc_y);
+    const u8 cmd = TSC2007_CMD_READ_Z1;
+    u8 data[2];
 
-    return this_y;
+    return indev_detect_xfer(spec, addr, &cmd, 1, data, sizeof(data)) == 0;
 }
 
 // #define REAL_X(x) ((x * priv->y_res) / (1 << priv->spec->resolution))
@@ -154,13 +145,11 @@ static void tsc2007_hw_init(struct indev_priv *priv)
     gpio_pull_up(priv->spec->pin_irq);
     gpio_set_dir(priv->spec->pin_irq, GPIO_IN);
 
-    i2c_bus_scan(priv->spec->i2c.master);
-
     priv->ops->reset(priv);
     priv->ops->set_dir(priv, INDEV_DIR_SWITCH_XY | INDEV_DIR_INVERT_Y | INDEV_DIR_INVERT_X);
 }
 
-static struct indev_spec tsc2007 = {
+struct indev_spec tsc2007_spec = {
     .name = "tsc2007",
     .type = INDEV_TYPE_POINTER,
 
@@ -176,26 +165,20 @@ static struct indev_spec tsc2007 = {
     .y_res  = 275,  // 25 ~ 300 --- 0 ~ 275
     .x_offs = -25,
     .y_offs = -25,
-    .resolution = TSC2007_RESOLUTION_8BIT,
+    .resolution = TSC2007_RESOLUTION_12BIT,
 
     .pin_irq = TSC2007_PIN_IRQ,
     .pin_rst = TSC2007_PIN_RST,
 
+    .detect = tsc2007_detect,
+
     .ops = {
         .write_reg  = tsc2007_write_reg,
         .read_reg   = tsc2007_read_reg,
         .init       = tsc2007_hw_init,
         .is_pressed = tsc2007_is_pressed,
-        .read_x     = tsc2007_read_x,
-        .read_y     = tsc2007_read_y,
+        .read_adc   = tsc2007_read_adc,
     },
 };
 
-int indev_driver_init(void)
-{
-    pr_debug("%s\n", __func__);
-    indev_probe(&tsc2007);
-    return 0;
-}
-
 #endif
\ No newline at end of file
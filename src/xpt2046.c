@@ -0,0 +1,264 @@
+// Copyright (c) 2024 embeddedboys developers
+
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "hardware/gpio.h"
+#include "hardware/spi.h"
+#include "hardware/dma.h"
+
+#include "indev.h"
+#include "debug.h"
+
+#if INDEV_DRV_USE_XPT2046
+
+/*
+ * GPIO 0-22 belong to the 8080 LCD bus. The touch header carries SCK and
+ * MOSI on the SCL/SDA pins, CS on the RST pin, MISO comes in on GPIO 24.
+ */
+#define XPT2046_SPI         spi1
+#define XPT2046_DEF_SPEED   2000000     /* 125 kSPS at 16 clocks per conversion */
+#define XPT2046_PIN_SCK     26
+#define XPT2046_PIN_MOSI    27
+#define XPT2046_PIN_MISO    24
+#define XPT2046_PIN_CS      29
+#define XPT2046_PIN_IRQ     21
+
+/*
+ * Control byte: S A2 A1 A0 MODE SER/DFR PD1 PD0. 12-bit differential
+ * conversions, PD = 00 powers down in between with PENIRQ enabled.
+ */
+#define XPT2046_CMD_READ_X  0xD0
+#define XPT2046_CMD_READ_Y  0x90
+#define XPT2046_CMD_READ_Z1 0xB0
+#define XPT2046_CMD_READ_Z2 0xC0
+/* single ended temperature, reference on, only used by detect */
+#define XPT2046_CMD_TEMP0   0x87
+#define XPT2046_CMD_PD      0x84
+
+#define XPT2046_RESOLUTION_12BIT 12
+
+/*
+ * 16 clocks per conversion: the next control byte goes out while the
+ * low data byte of the previous one comes in, n conversions take
+ * 2 * n + 1 bytes and the result of conversion i is in rx[2i+1..2i+2].
+ */
+#define XPT2046_MAX_CONV    (2 * INDEV_FILTER_MAX_N + 2)
+#define XPT2046_BURST_LEN   (2 * XPT2046_MAX_CONV + 1)
+
+static struct {
+    bool ready;
+    int  dma_tx;
+    int  dma_rx;
+    u8   tx[XPT2046_BURST_LEN];
+    u8   rx[XPT2046_BURST_LEN];
+} g_xpt2046;
+
+static void xpt2046_bus_init(struct indev_spec *spec)
+{
+    spi_inst_t *spi = spec->spi.master;
+    dma_channel_config c;
+
+    if (g_xpt2046.ready)
+        return;
+
+    spi_init(spi, spec->spi.speed);
+    spi_set_format(spi, 8, SPI_CPOL_0, SPI_CPHA_0, SPI_MSB_FIRST);
+    gpio_set_function(spec->spi.pin_sck, GPIO_FUNC_SPI);
+    gpio_set_function(spec->spi.pin_mosi, GPIO_FUNC_SPI);
+    gpio_set_function(spec->spi.pin_miso, GPIO_FUNC_SPI);
+    /* a missing chip then reads back as 0 */
+    gpio_pull_down(spec->spi.pin_miso);
+
+    gpio_init(spec->spi.pin_cs);
+    gpio_set_dir(spec->spi.pin_cs, GPIO_OUT);
+    gpio_put(spec->spi.pin_cs, 1);
+
+    g_xpt2046.dma_tx = dma_claim_unused_channel(true);
+    g_xpt2046.dma_rx = dma_claim_unused_channel(true);
+
+    c = dma_channel_get_default_config(g_xpt2046.dma_tx);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, spi_get_dreq(spi, true));
+    dma_channel_configure(g_xpt2046.dma_tx, &c, &spi_get_hw(spi)->dr, g_xpt2046.tx, 0, false);
+
+    c = dma_channel_get_default_config(g_xpt2046.dma_rx);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, true);
+    channel_config_set_dreq(&c, spi_get_dreq(spi, false));
+    dma_channel_configure(g_xpt2046.dma_rx, &c, g_xpt2046.rx, &spi_get_hw(spi)->dr, 0, false);
+
+    g_xpt2046.ready = true;
+}
+
+/*
+ * Run the conversions in g_xpt2046.tx as one CS-low DMA transfer. A full
+ * burst is ~100 us at 2 MHz, shorter than a tick, so the caller spins
+ * on the channel instead of sleeping.
+ */
+static void xpt2046_transfer(struct indev_spec *spec, int nconv)
+{
+    size_t len = 2 * nconv + 1;
+
+    gpio_put(spec->spi.pin_cs, 0);
+
+    dma_channel_set_write_addr(g_xpt2046.dma_rx, g_xpt2046.rx, false);
+    dma_channel_set_trans_count(g_xpt2046.dma_rx, len, false);
+    dma_channel_set_read_addr(g_xpt2046.dma_tx, g_xpt2046.tx, false);
+    dma_channel_set_trans_count(g_xpt2046.dma_tx, len, false);
+    dma_start_channel_mask((1u << g_xpt2046.dma_tx) | (1u << g_xpt2046.dma_rx));
+    dma_channel_wait_for_finish_blocking(g_xpt2046.dma_rx);
+
+    gpio_put(spec->spi.pin_cs, 1);
+}
+
+static inline void xpt2046_set_cmd(int i, u8 cmd)
+{
+    g_xpt2046.tx[2 * i] = cmd;
+}
+
+static inline u16 xpt2046_get_result(int i)
+{
+    return ((g_xpt2046.rx[2 * i + 1] << 8) | g_xpt2046.rx[2 * i + 2]) >> 3 & 0xFFF;
+}
+
+static u16 xpt2046_read_adc(struct indev_priv *priv, u8 channel)
+{
+    static const u8 cmds[] = {
+        [INDEV_ADC_X]  = XPT2046_CMD_READ_X,
+        [INDEV_ADC_Y]  = XPT2046_CMD_READ_Y,
+        [INDEV_ADC_Z1] = XPT2046_CMD_READ_Z1,
+        [INDEV_ADC_Z2] = XPT2046_CMD_READ_Z2,
+    };
+
+    memset(g_xpt2046.tx, 0, 3);
+    xpt2046_set_cmd(0, cmds[channel]);
+    xpt2046_transfer(priv->spec, 1);
+
+    return xpt2046_get_result(0);
+}
+
+/* all the resistive pipeline needs for one sample in a single transfer */
+static int xpt2046_read_adc_burst(struct indev_priv *priv, u16 *xs, u16 *ys, int n,
+                                  u16 *z1, u16 *z2)
+{
+    int i, nconv = 2 * n + 2;
+
+    if (nconv > XPT2046_MAX_CONV)
+        return -1;
+
+    /* same channel back to back, the panel settles once per axis */
+    memset(g_xpt2046.tx, 0, 2 * nconv + 1);
+    for (i = 0; i < n; i++) {
+        xpt2046_set_cmd(i, XPT2046_CMD_READ_X);
+        xpt2046_set_cmd(n + i, XPT2046_CMD_READ_Y);
+    }
+    xpt2046_set_cmd(2 * n, XPT2046_CMD_READ_Z1);
+    xpt2046_set_cmd(2 * n + 1, XPT2046_CMD_READ_Z2);
+
+    xpt2046_transfer(priv->spec, nconv);
+
+    for (i = 0; i < n; i++) {
+        xs[i] = xpt2046_get_result(i);
+        ys[i] = xpt2046_get_result(n + i);
+    }
+    *z1 = xpt2046_get_result(2 * n);
+    *z2 = xpt2046_get_result(2 * n + 1);
+
+    return 0;
+}
+
+/* PENIRQ, low while the panel is touched */
+static bool xpt2046_is_pressed(struct indev_priv *priv)
+{
+    return !gpio_get(priv->spec->pin_irq);
+}
+
+/*
+ * No ID register: a temperature conversion has to come back somewhere
+ * in between the rails, MISO is pulled down so an empty footprint
+ * reads 0. The second conversion powers down and re-enables PENIRQ.
+ */
+static bool xpt2046_detect(struct indev_spec *spec, u8 addr)
+{
+    u16 temp;
+
+    xpt2046_bus_init(spec);
+
+    memset(g_xpt2046.tx, 0, 5);
+    xpt2046_set_cmd(0, XPT2046_CMD_TEMP0);
+    xpt2046_set_cmd(1, XPT2046_CMD_PD);
+    xpt2046_transfer(spec, 2);
+
+    temp = xpt2046_get_result(0);
+    pr_debug("xpt2046: temp0 %d\n", temp);
+
+    return temp != 0 && temp != 0xFFF;
+}
+
+static void xpt2046_hw_init(struct indev_priv *priv)
+{
+    pr_debug("%s\n", __func__);
+
+    xpt2046_bus_init(priv->spec);
+
+    gpio_init(priv->spec->pin_irq);
+    gpio_pull_up(priv->spec->pin_irq);
+    gpio_set_dir(priv->spec->pin_irq, GPIO_IN);
+}
+
+struct indev_spec xpt2046_spec = {
+    .name = "xpt2046",
+    .type = INDEV_TYPE_POINTER,
+
+    .spi = {
+        .master = XPT2046_SPI,
+        .speed = XPT2046_DEF_SPEED,
+        .pin_mosi = XPT2046_PIN_MOSI,
+        .pin_miso = XPT2046_PIN_MISO,
+        .pin_cs = XPT2046_PIN_CS,
+        .pin_sck = XPT2046_PIN_SCK,
+    },
+
+    /* full 12-bit span, the calibration wizard trims the edges */
+    .resolution = XPT2046_RESOLUTION_12BIT,
+
+    .pin_irq = XPT2046_PIN_IRQ,
+    .pin_rst = INDEV_PIN_NONE,
+
+    .detect = xpt2046_detect,
+
+    .ops = {
+        .init           = xpt2046_hw_init,
+        .is_pressed     = xpt2046_is_pressed,
+        .read_adc       = xpt2046_read_adc,
+        .read_adc_burst = xpt2046_read_adc_burst,
+    },
+};
+
+#endif
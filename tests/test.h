@@ -0,0 +1,65 @@
+// Copyright (c) 2024 embeddedboys developers
+
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef __TEST_H
+#define __TEST_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/* minimal checks for the host tests, every failure is reported */
+static int test_failures;
+
+#define CHECK(cond)                                                         \
+    do {                                                                    \
+        if (!(cond)) {                                                      \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n",                    \
+                    __FILE__, __LINE__, #cond);                             \
+            test_failures++;                                                \
+        }                                                                   \
+    } while (0)
+
+#define CHECK_NEAR(a, b, tol)                                               \
+    do {                                                                    \
+        long long __a = (a), __b = (b);                                     \
+        if (llabs(__a - __b) > (tol)) {                                     \
+            fprintf(stderr, "%s:%d: %s = %lld, %s = %lld, off by more than %d\n", \
+                    __FILE__, __LINE__, #a, __a, #b, __b, (int)(tol));      \
+            test_failures++;                                                \
+        }                                                                   \
+    } while (0)
+
+#define RUN_TEST(fn)                                                        \
+    do {                                                                    \
+        int __before = test_failures;                                       \
+        fn();                                                               \
+        printf("%-40s %s\n", #fn, test_failures == __before ? "ok" : "FAIL"); \
+    } while (0)
+
+static inline int test_result(void)
+{
+    if (test_failures)
+        fprintf(stderr, "%d check(s) failed\n", test_failures);
+    return test_failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+#endif
@@ -0,0 +1,269 @@
+// Copyright (c) 2024 embeddedboys developers
+
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+/*
+ * indev_calib.c on the host: the default matrix against the float mapping
+ * the resistive drivers used before the matrix, and the wizard fits.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "indev_calib.h"
+#include "test.h"
+
+/* INDEV_DIR_* from indev.h, which needs the SDK */
+#define DIR_INVERT_X    0x01
+#define DIR_INVERT_Y    0x02
+#define DIR_SWITCH_XY   0x04
+
+/* a TSC2007 / NS2009 spec on the 480x320 panel */
+#define SCR_X_RES       480
+#define SCR_Y_RES       320
+#define TOUCH_X_RES     410
+#define TOUCH_Y_RES     275
+#define TOUCH_X_OFFS    (-25)
+#define TOUCH_Y_OFFS    (-25)
+#define TOUCH_BITS      12
+
+/* one axis of the old __ns2009_read_x(), u16 wrap and float scale included */
+static uint16_t old_axis(uint16_t val, bool invert, uint16_t res, int offs, float sc)
+{
+    uint16_t v;
+
+    if (invert)
+        v = (res - (val * res) / (1 << TOUCH_BITS));
+    else
+        v = (val * res) / (1 << TOUCH_BITS);
+
+    v += offs;
+    v *= sc;
+    return v;
+}
+
+/* the old __indev_set_dir(), which swapped state instead of building a matrix */
+static void old_map(unsigned dir, uint16_t raw_x, uint16_t raw_y, uint16_t *x, uint16_t *y)
+{
+    bool invert_x = dir & DIR_INVERT_X, invert_y = dir & DIR_INVERT_Y;
+    uint16_t x_res = SCR_X_RES, y_res = SCR_Y_RES;
+    int x_offs = TOUCH_X_OFFS, y_offs = TOUCH_Y_OFFS;
+    float sc_x = (float)SCR_X_RES / TOUCH_X_RES, sc_y = (float)SCR_Y_RES / TOUCH_Y_RES;
+
+    if (dir & DIR_SWITCH_XY) {
+        bool b = invert_x; invert_x = invert_y; invert_y = b;
+        int o = x_offs; x_offs = y_offs; y_offs = o;
+        float f = sc_x; sc_x = sc_y; sc_y = f;
+        uint16_t r = x_res; x_res = y_res; y_res = r;
+
+        /* read_x is the driver's read_y and the other way around */
+        *x = old_axis(raw_y, invert_y, y_res, y_offs, sc_y);
+        *y = old_axis(raw_x, invert_x, x_res, x_offs, sc_x);
+    } else {
+        *x = old_axis(raw_x, invert_x, x_res, x_offs, sc_x);
+        *y = old_axis(raw_y, invert_y, y_res, y_offs, sc_y);
+    }
+}
+
+/* as indev_calib_default() in indev.c */
+static void default_calib(unsigned dir, struct indev_calib *cal)
+{
+    struct indev_calib_axis x = {
+        .from_y     = dir & DIR_SWITCH_XY,
+        .invert     = dir & DIR_INVERT_X,
+        .res        = SCR_X_RES,
+        .touch_res  = TOUCH_X_RES,
+        .bits       = TOUCH_BITS,
+        .offs       = TOUCH_X_OFFS,
+    };
+    struct indev_calib_axis y = {
+        .from_y     = !(dir & DIR_SWITCH_XY),
+        .invert     = dir & DIR_INVERT_Y,
+        .res        = SCR_Y_RES,
+        .touch_res  = TOUCH_Y_RES,
+        .bits       = TOUCH_BITS,
+        .offs       = TOUCH_Y_OFFS,
+    };
+
+    indev_calib_from_axes(cal, &x, &y);
+}
+
+static void test_default_matches_old_mapping(void)
+{
+    for (unsigned dir = 0; dir <= (DIR_INVERT_X | DIR_INVERT_Y | DIR_SWITCH_XY); dir++) {
+        struct indev_calib cal;
+        int compared = 0;
+
+        default_calib(dir, &cal);
+
+        for (int rx = 0; rx < (1 << TOUCH_BITS); rx += 97) {
+            for (int ry = 0; ry < (1 << TOUCH_BITS); ry += 89) {
+                uint16_t ox, oy, nx = rx, ny = ry;
+
+                old_map(dir, rx, ry, &ox, &oy);
+                /* the old path wrapped off-panel values, the matrix clamps them */
+                if (ox >= SCR_X_RES || oy >= SCR_Y_RES)
+                    continue;
+
+                indev_calib_apply(&cal, &nx, &ny, SCR_X_RES, SCR_Y_RES);
+                /* the drivers truncated twice, the matrix rounds once */
+                CHECK_NEAR(nx, ox, 2);
+                CHECK_NEAR(ny, oy, 2);
+                compared++;
+            }
+        }
+
+        /* most of the raw range lands on the panel in every orientation */
+        CHECK(compared > 500);
+    }
+}
+
+static void test_pixel_axes_are_identity(void)
+{
+    /* capacitive controllers report pixels, no bits and no span */
+    struct indev_calib_axis x = { .res = SCR_X_RES };
+    struct indev_calib_axis y = { .from_y = true, .res = SCR_Y_RES };
+    struct indev_calib cal, id;
+
+    indev_calib_from_axes(&cal, &x, &y);
+    indev_calib_identity(&id);
+
+    CHECK(cal.a == id.a && cal.b == id.b && cal.c == id.c);
+    CHECK(cal.d == id.d && cal.e == id.e && cal.f == id.f);
+}
+
+/* raw = 12 bit ADC, screen x from raw y mirrored, screen y from raw x */
+static void ref_map(int32_t rx, int32_t ry, int32_t *sx, int32_t *sy)
+{
+    *sx = 470 - ry * 450 / 3600;
+    *sy = 10 + rx * 300 / 3600;
+}
+
+static void make_point(struct indev_calib_point *p, int32_t rx, int32_t ry)
+{
+    p->raw_x = rx;
+    p->raw_y = ry;
+    ref_map(rx, ry, &p->scr_x, &p->scr_y);
+}
+
+static void test_three_point_exact(void)
+{
+    struct indev_calib_point pts[3];
+    struct indev_calib cal;
+
+    /* the wizard's 3 targets, raw values chosen to map to whole pixels */
+    make_point(&pts[0], 288, 360);
+    make_point(&pts[1], 3312, 1800);
+    make_point(&pts[2], 1800, 3240);
+
+    CHECK(indev_calib_solve(&cal, pts, 3) == 0);
+    CHECK(indev_calib_max_error(&cal, pts, 3) == 0);
+
+    /* the matrix itself, Q16 */
+    CHECK_NEAR(cal.a, 0, 2);
+    CHECK_NEAR(cal.b, -INDEV_CALIB_ONE / 8, 2);
+    CHECK_NEAR(cal.c, 470 * INDEV_CALIB_ONE, 64);
+    CHECK_NEAR(cal.d, INDEV_CALIB_ONE / 12, 2);
+    CHECK_NEAR(cal.e, 0, 2);
+    CHECK_NEAR(cal.f, 10 * INDEV_CALIB_ONE, 64);
+
+    /* points the fit never saw land within a pixel */
+    for (int rx = 0; rx < 3600; rx += 360) {
+        for (int ry = 0; ry < 3600; ry += 360) {
+            uint16_t x = rx, y = ry;
+            int32_t sx, sy;
+
+            ref_map(rx, ry, &sx, &sy);
+            indev_calib_apply(&cal, &x, &y, SCR_X_RES, SCR_Y_RES);
+            CHECK_NEAR(x, sx, 1);
+            CHECK_NEAR(y, sy, 1);
+        }
+    }
+}
+
+static void test_five_point_least_squares(void)
+{
+    struct indev_calib_point pts[5];
+    struct indev_calib cal;
+
+    /* four corners and the centre, the centre press landed 10 px right */
+    make_point(&pts[0], 360, 360);
+    make_point(&pts[1], 3240, 360);
+    make_point(&pts[2], 3240, 3240);
+    make_point(&pts[3], 360, 3240);
+    make_point(&pts[4], 1800, 1800);
+    pts[4].scr_x += 10;
+
+    CHECK(indev_calib_solve(&cal, pts, 5) == 0);
+
+    /*
+     * The centre sits at the mean of the corners, so its leverage is 1/5:
+     * the fit moves every point 2 px right, leaving 2 px at the corners
+     * and 8 px at the centre.
+     */
+    CHECK(indev_calib_max_error(&cal, pts, 4) == 2);
+    CHECK(indev_calib_max_error(&cal, &pts[4], 1) == 8);
+    CHECK(indev_calib_max_error(&cal, pts, 5) == 8);
+
+    /* without the outlier the same 5 points fit exactly */
+    pts[4].scr_x -= 10;
+    CHECK(indev_calib_solve(&cal, pts, 5) == 0);
+    CHECK(indev_calib_max_error(&cal, pts, 5) == 0);
+}
+
+static void test_collinear_rejected(void)
+{
+    struct indev_calib_point pts[5];
+    struct indev_calib cal;
+
+    indev_calib_identity(&cal);
+
+    /* all presses along one diagonal */
+    for (int i = 0; i < 5; i++)
+        make_point(&pts[i], 400 + i * 700, 300 + i * 650);
+    CHECK(indev_calib_solve(&cal, pts, 3) == -1);
+    CHECK(indev_calib_solve(&cal, pts, 5) == -1);
+
+    /* the same target pressed three times */
+    for (int i = 0; i < 3; i++)
+        make_point(&pts[i], 1800, 1800);
+    CHECK(indev_calib_solve(&cal, pts, 3) == -1);
+
+    /* too few points */
+    make_point(&pts[0], 360, 360);
+    make_point(&pts[1], 3240, 3240);
+    CHECK(indev_calib_solve(&cal, pts, 2) == -1);
+
+    /* a rejected fit leaves the matrix alone */
+    CHECK(cal.a == INDEV_CALIB_ONE && cal.e == INDEV_CALIB_ONE);
+    CHECK(!cal.b && !cal.c && !cal.d && !cal.f);
+}
+
+int main(void)
+{
+    RUN_TEST(test_default_matches_old_mapping);
+    RUN_TEST(test_pixel_axes_are_identity);
+    RUN_TEST(test_three_point_exact);
+    RUN_TEST(test_five_point_least_squares);
+    RUN_TEST(test_collinear_rejected);
+
+    return test_result();
+}
@@ -0,0 +1,247 @@
+// Copyright (c) 2024 embeddedboys developers
+
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+/*
+ * indev_filter.c on the host, driven by sample traces of a 12 bit
+ * resistive controller: conversion bursts with spikes, the Z1/Z2 values
+ * of a stroke from approach to lift, and calibrated positions at the
+ * touch task's 5 ms sampling period.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "indev_filter.h"
+#include "test.h"
+
+#define ARRAY_SIZE(arr) (sizeof(arr)/sizeof(arr[0]))
+
+#define PERIOD_US   5000
+
+static const struct indev_filter_cfg cfg_default = INDEV_FILTER_CFG_DEFAULT;
+
+/* X conversions of one sample each, with the position they belong to */
+static const struct {
+    int n;
+    uint16_t v[INDEV_FILTER_MAX_N];
+    uint16_t pos;
+} median_trace[] = {
+    { 5, { 2047, 2051, 4095, 2049, 2046 }, 2048 },  /* one spike high */
+    { 5, { 0, 1203, 1199, 1201, 1198 }, 1200 },     /* one dropout */
+    { 5, { 4095, 3001, 0, 3004, 2998 }, 3000 },     /* one of each */
+    { 5, { 4095, 4095, 812, 809, 815 }, 812 },      /* two spikes */
+    { 5, { 640, 640, 640, 640, 640 }, 640 },
+    { 3, { 903, 4095, 905 }, 904 },
+    { 7, { 0, 2500, 2502, 4095, 2497, 2499, 0 }, 2500 },
+    { 9, { 4095, 1500, 1502, 0, 1497, 1501, 4095, 1499, 0 }, 1500 },
+    { 1, { 77 }, 77 },
+};
+
+static void test_median_rejects_spikes(void)
+{
+    for (int i = 0; i < ARRAY_SIZE(median_trace); i++) {
+        uint16_t v[INDEV_FILTER_MAX_N];
+        int n = median_trace[i].n;
+
+        for (int k = 0; k < n; k++)
+            v[k] = median_trace[i].v[k];
+
+        /* fewer spikes than half the burst never reach the median */
+        CHECK_NEAR(indev_filter_median(v, n), median_trace[i].pos, 4);
+
+        /* documented to sort in place */
+        for (int k = 1; k < n; k++)
+            CHECK(v[k - 1] <= v[k]);
+    }
+}
+
+/* a stroke at mid panel, from approach to lift */
+static const struct {
+    uint16_t x, z1, z2;
+    bool ok;
+} stroke_trace[] = {
+    { 2048,   40, 4090, false },    /* approach, under z1_min */
+    { 2051,  150, 4000, false },    /* half pressed, rt ~3850 ohms */
+    { 2046,  280, 3100, true },     /* rt ~1510 */
+    { 2049,  400, 2400, true },     /* rt ~750 */
+    { 2047,  600, 1800, true },     /* firm, rt ~300 */
+    { 2050,  620, 1790, true },
+    { 2048,  590, 1820, true },
+    { 2052,  310, 3300, true },     /* easing off, rt ~1450 */
+    { 2049,  180, 3900, false },    /* half lifted, rt ~3100 */
+    { 2051,   60, 4050, false },    /* lifting, under z1_min */
+};
+
+static void test_pressure_stroke(void)
+{
+    for (int i = 0; i < ARRAY_SIZE(stroke_trace); i++)
+        CHECK(indev_filter_pressure_ok(&cfg_default, stroke_trace[i].x,
+                                       stroke_trace[i].z1, stroke_trace[i].z2) ==
+              stroke_trace[i].ok);
+}
+
+static void test_pressure_without_z2(void)
+{
+    struct indev_filter_cfg cfg = cfg_default;
+
+    /* Z1 only controllers, the half press above passes on Z1 alone */
+    CHECK(indev_filter_pressure_ok(&cfg_default, 2051, 150, 0));
+    CHECK(!indev_filter_pressure_ok(&cfg_default, 2048, 40, 0));
+
+    /* no touch resistance check configured */
+    cfg.rt_max_ohms = 0;
+    CHECK(indev_filter_pressure_ok(&cfg, 2051, 150, 4000));
+    CHECK(!indev_filter_pressure_ok(&cfg, 2048, 40, 4090));
+}
+
+/* +-3 px of jitter on calibrated positions, repeated over longer traces */
+static const int8_t jitter[] = {
+     3,  0,  0, -2, -2,  0,  1,  0, -3,  2,  3, -1,  2,  0,  0,  0,
+     0,  2,  0,  1,  2,  0, -1,  2, -2,  1,  1, -1,  0,  1, -1, -3,
+     0,  0,  1,  3,  2,  1, -3, -1,  1, -2,  0, -2, -1,  1, -2, -2,
+     0,  0,  3, -1,  0,  1,  0,  1,  0,  3,  0, -1,  0,  0, -1,  0,
+};
+
+static void test_smooth_reduces_jitter(void)
+{
+    struct indev_filter f;
+    uint32_t in_err = 0, out_err = 0;
+    uint32_t now = 0;
+
+    indev_filter_init(&f, &cfg_default);
+
+    /* a finger held still at (240, 160) for 640 ms */
+    for (int i = 0; i < 128; i++) {
+        uint16_t x = 240 + jitter[i % ARRAY_SIZE(jitter)];
+        uint16_t y = 160 - jitter[(i + 17) % ARRAY_SIZE(jitter)];
+
+        in_err += abs(x - 240) + abs(y - 160);
+        indev_filter_smooth(&f, &x, &y, now);
+        out_err += abs(x - 240) + abs(y - 160);
+
+        /* never further out than the input ever was */
+        CHECK_NEAR(x, 240, 3);
+        CHECK_NEAR(y, 160, 3);
+        now += PERIOD_US;
+    }
+
+    /* at least half of the jitter is gone */
+    CHECK(out_err * 2 <= in_err);
+}
+
+/* lag behind a 1000 px/s swipe once the filter has caught up */
+static int ramp_lag(const struct indev_filter_cfg *cfg, bool noisy)
+{
+    struct indev_filter f;
+    uint32_t now = 0;
+    int lag = 0;
+
+    indev_filter_init(&f, cfg);
+
+    for (int i = 0; i < 80; i++) {
+        int pos = 20 + i * 5;
+        uint16_t x = pos + (noisy ? jitter[i % ARRAY_SIZE(jitter)] : 0);
+        uint16_t y = 160;
+
+        indev_filter_smooth(&f, &x, &y, now);
+        now += PERIOD_US;
+
+        /* 20 samples, 100 ms, to settle */
+        if (i >= 20 && pos - x > lag)
+            lag = pos - x;
+
+        /* a smoothed swipe never overshoots the finger */
+        if (!noisy)
+            CHECK(x <= pos);
+    }
+
+    return lag;
+}
+
+static void test_smooth_ramp_lag_bounded(void)
+{
+    struct indev_filter_cfg plain = cfg_default;
+    int lag, lag_noisy, lag_plain;
+
+    lag = ramp_lag(&cfg_default, false);
+    lag_noisy = ramp_lag(&cfg_default, true);
+
+    /* beta 0 is a fixed 1 Hz low pass */
+    plain.beta_mhz = 0;
+    lag_plain = ramp_lag(&plain, false);
+
+    printf("ramp lag %d px, %d px with jitter, %d px at beta 0\n", lag, lag_noisy, lag_plain);
+    /* under three samples of travel */
+    CHECK(lag < 15);
+    CHECK(lag_noisy < 15);
+    /* the speed term is what keeps the lag down */
+    CHECK(lag * 4 < lag_plain);
+}
+
+static void test_smooth_stroke_boundaries(void)
+{
+    struct indev_filter_cfg off = cfg_default;
+    struct indev_filter f;
+    uint16_t x = 100, y = 100;
+
+    indev_filter_init(&f, &cfg_default);
+
+    /* the first sample of a stroke passes through */
+    indev_filter_smooth(&f, &x, &y, 0);
+    CHECK(x == 100 && y == 100);
+
+    x = 110;
+    y = 90;
+    indev_filter_smooth(&f, &x, &y, PERIOD_US);
+    /* a lone 10 px jump is mostly jitter to the filter */
+    CHECK(x >= 100 && x < 105 && y <= 100 && y > 95);
+
+    /* pen up, the next stroke starts where it lands */
+    indev_filter_reset(&f);
+    x = 400;
+    y = 300;
+    indev_filter_smooth(&f, &x, &y, 2 * PERIOD_US);
+    CHECK(x == 400 && y == 300);
+
+    /* min_cutoff 0 turns smoothing off */
+    off.min_cutoff_mhz = 0;
+    indev_filter_init(&f, &off);
+    for (int i = 0; i < 4; i++) {
+        x = 200 + jitter[i];
+        y = 100;
+        indev_filter_smooth(&f, &x, &y, i * PERIOD_US);
+        CHECK(x == 200 + jitter[i] && y == 100);
+    }
+}
+
+int main(void)
+{
+    RUN_TEST(test_median_rejects_spikes);
+    RUN_TEST(test_pressure_stroke);
+    RUN_TEST(test_pressure_without_z2);
+    RUN_TEST(test_smooth_reduces_jitter);
+    RUN_TEST(test_smooth_ramp_lag_bounded);
+    RUN_TEST(test_smooth_stroke_boundaries);
+
+    return test_result();
+}